@@ -5,6 +5,7 @@ Cache::Cache(int size, hash_fn hash){
 
     m_currentCap = returnNewCurrCap(size);
     m_currentTable = new Person [m_currentCap];
+    m_currentMeta = new unsigned char [m_currentCap]();
     // Initizing current hashtable
     for (int i = 0; i< m_currentCap; i++) {
         m_currentTable[i] = EMPTY;
@@ -13,20 +14,139 @@ Cache::Cache(int size, hash_fn hash){
     m_currNumDeleted = 0;
 
     m_oldTable = nullptr;     // hash table
+    m_oldMeta = nullptr;
     m_oldCap = 0;       // hash table size (capacity)
     m_oldSize = 0;      // current number of entries, m_oldSize includes deleted entries
     m_oldNumDeleted = 0; // number of deleted entries
+    m_rehashIndex = 0;
+    m_rehashEpoch = 0;
+    m_cursorMarks = 0;
+}
+
+Cache::Cache(const vector<Person>& people, hash_fn hash){
+    m_hash = hash;
+    int count = (int)people.size();
+
+    // the table is sized once, the same way rehash() sizes it for this much live data
+    m_currentCap = returnNewCurrCap(m_policy.rehashCapacity(count));
+    m_currentTable = new Person [m_currentCap];
+    m_currentMeta = new unsigned char [m_currentCap]();
+    for (int i = 0; i < m_currentCap; i++) {
+        m_currentTable[i] = EMPTY;
+    }
+    m_currentSize = 0;
+    m_currNumDeleted = 0;
+
+    m_oldTable = nullptr;
+    m_oldMeta = nullptr;
+    m_oldCap = 0;
+    m_oldSize = 0;
+    m_oldNumDeleted = 0;
+    m_rehashIndex = 0;
+    m_rehashEpoch = 0;
+    m_cursorMarks = 0;
+
+    int threads = (int)thread::hardware_concurrency();
+    if (threads > count / BULKMINPERTHREAD)
+        threads = count / BULKMINPERTHREAD;
+    if (threads < 1)
+        threads = 1;
+
+    // step 1: hash every key, each thread takes a contiguous chunk of the input
+    vector<int> homes(count);
+    auto hashChunk = [this, &people, &homes](int first, int last) {
+        for (int i = first; i < last; i++)
+            homes[i] = m_hash(people[i].getKey()) % m_currentCap;
+    };
+    vector<thread> workers;
+    for (int t = 1; t < threads; t++)
+        workers.push_back(thread(hashChunk, (int)((long long)count * t / threads),
+                                 (int)((long long)count * (t + 1) / threads)));
+    hashChunk(0, (int)((long long)count / threads));
+    for (unsigned int t = 0; t < workers.size(); t++)
+        workers[t].join();
+    workers.clear();
+
+    // step 2: counting sort by home slot, so equal homes keep their input order
+    vector<int> start(m_currentCap + 1, 0);
+    for (int i = 0; i < count; i++)
+        start[homes[i] + 1]++;
+    for (int i = 0; i < m_currentCap; i++)
+        start[i + 1] += start[i];
+    vector<int> order(count);
+    vector<int> next(start.begin(), start.end() - 1);
+    for (int i = 0; i < count; i++)
+        order[next[homes[i]]++] = i;
+
+    // step 3: every thread owns a contiguous band of slots and places the people
+    // whose home is in its band, a probe that leaves the band is deferred
+    vector< vector<int> > deferred(threads);
+    vector<int> placed(threads, 0);
+    for (int t = 0; t < threads; t++) {
+        int lowSlot = (int)((long long)m_currentCap * t / threads);
+        int highSlot = (int)((long long)m_currentCap * (t + 1) / threads);
+        if (t == 0)
+            continue;
+        workers.push_back(thread(&Cache::placeRange, this, cref(people), cref(homes), cref(order),
+                                 start[lowSlot], start[highSlot], lowSlot, highSlot,
+                                 ref(deferred[t]), ref(placed[t])));
+    }
+    int firstHigh = (int)((long long)m_currentCap / threads);
+    placeRange(people, homes, order, start[0], start[firstHigh], 0, firstHigh, deferred[0], placed[0]);
+    for (unsigned int t = 0; t < workers.size(); t++)
+        workers[t].join();
+
+    // step 4: whatever crossed a band boundary is placed against the whole table
+    vector<int> overflow;
+    for (int t = 0; t < threads; t++) {
+        m_currentSize += placed[t];
+        for (unsigned int i = 0; i < deferred[t].size(); i++) {
+            int person = deferred[t][i];
+            int result = placePerson(people[person], homes[person], 0, m_currentCap);
+            if (result == 1)
+                m_currentSize++;
+            else if (result == 2)
+                overflow.push_back(person);
+        }
+    }
+
+    // step 5: a probe sequence that found no bucket at all goes through insert,
+    // which grows the table and tries again
+    for (unsigned int i = 0; i < overflow.size(); i++) {
+        const Person& person = people[overflow[i]];
+        // a second copy of someone already placed is skipped, as in steps 3 and 4
+        if (getPerson(person.getKey(), person.getID()) == person)
+            continue;
+        if (not insert(person)) {
+            // with duplicates and bad IDs out of the way, insert only fails once the
+            // probe sequence is full and the table cannot grow past MAXPRIME
+            delete[] m_currentTable;
+            delete[] m_currentMeta;
+            delete[] m_oldTable;
+            delete[] m_oldMeta;
+            throw length_error("Too many people for a cache of at most MAXPRIME buckets!");
+        }
+    }
+
+    // a grow in step 5 leaves its rehash to later operations, the
+    // constructor hands back a single finished table
+    while (m_oldTable != nullptr)
+        continueRehash();
 }
 
 Cache::~Cache(){
     delete[] m_currentTable;
+    delete[] m_currentMeta;
     m_currentTable = nullptr;
+    m_currentMeta = nullptr;
     m_currentSize = 0;
     m_currNumDeleted = 0;
     m_currentCap = 0;
 
     delete[] m_oldTable;
+    delete[] m_oldMeta;
     m_oldTable = nullptr;
+    m_oldMeta = nullptr;
     m_oldSize = 0;
     m_oldNumDeleted = 0;
     m_oldCap = 0;
@@ -46,6 +166,7 @@ bool Cache::insert(Person person){
     }
     
     // collision check
+    int probes = 0;
     if ((not (m_currentTable[hashKey] == EMPTY)) && (not (m_currentTable[hashKey] == DELETED)))  { // if the index is not empty... we need to start looking for the next one...
         int index = hashKey;
         int i = 0;
@@ -59,7 +180,24 @@ bool Cache::insert(Person person){
         // OCC CASE: not Empty && not DELETED
         // true | true
         while ((not (m_currentTable[index] == EMPTY)) && (not (m_currentTable[index] == DELETED))) {
-            index = ((hashKey) + (i * i)) % m_currentCap;
+            // quadratic probing only reaches (m_currentCap + 1) / 2 distinct buckets,
+            // past that the table is too full for this key, so we grow and retry
+            if (i > m_currentCap / 2 + 1) {
+                // once the table is pinned at MAXPRIME a rehash does not make
+                // room, retrying would probe the same way forever
+                if (m_currentCap >= MAXPRIME)
+                    return false;
+                int oldCap = m_currentCap;
+                rehash();
+                if (m_currentCap <= oldCap)
+                    return false;
+                hashKey = m_hash(person.getKey()) % m_currentCap;
+                index = hashKey;
+                i = 0;
+                continue;
+            }
+
+            index = (int)((hashKey + (long long)i * i) % m_currentCap);
 
             if(m_currentTable[hashKey] == person) { // if it's a duplicate. we can't have that here...
                 cout << "DUPLICATE WARNING!!!" << endl;
@@ -68,18 +206,24 @@ bool Cache::insert(Person person){
             i++;
 
         }
+        probes = i;
 
         m_currentTable[index] = person;
+        m_currentMeta[index] = SLOTLIVE;
         m_currentSize++;
     } else {
         m_currentTable[hashKey] = person;
+        m_currentMeta[hashKey] = SLOTLIVE;
         m_currentSize++;
     }
 
 
 
 
-    if (lambda() > 0.5) {
+    m_policy.recordProbe(probes);
+
+    // a table pinned at MAXPRIME with no tombstones would rehash into a copy of itself
+    if (lambda() > m_policy.growThreshold() && (m_currentCap < MAXPRIME || m_currNumDeleted > 0)) {
         rehash();
     } else if(m_oldTable != nullptr){
 
@@ -103,7 +247,7 @@ bool Cache::remove(Person person){
 
         // continue while the bucket in the old table is not equal to the person or until we hit the end...
         while((not (m_oldTable[index] == person)) && i <= m_oldCap) { 
-            index = ((hashKey) + (i * i)) % m_oldCap;
+            index = (int)((hashKey + (long long)i * i) % m_oldCap);
             i++;
         }
 
@@ -111,6 +255,7 @@ bool Cache::remove(Person person){
         // deletes from oldTable
         if(m_oldTable[index] == person) {
             m_oldTable[index] = DELETED;
+            m_oldMeta[index] = SLOTDELETED;
             m_oldNumDeleted++;
             toggle = true;
         }
@@ -121,7 +266,7 @@ bool Cache::remove(Person person){
     int i = 0;
 
     while((not (m_currentTable[index] == person)) && i <= m_currentCap) {
-        index = ((m_hash(person.getKey()) % m_currentCap) + (i * i)) % m_currentCap;
+        index = (int)((m_hash(person.getKey()) % m_currentCap + (long long)i * i) % m_currentCap);
         i++;
     }
 
@@ -129,6 +274,7 @@ bool Cache::remove(Person person){
     // deletes from currentTable
     if(m_currentTable[index] == person) {
         m_currentTable[index] = DELETED;
+        m_currentMeta[index] = SLOTDELETED;
         m_currNumDeleted++;
         toggle = true;
     }
@@ -139,8 +285,10 @@ bool Cache::remove(Person person){
     }
 
 
-    if (deletedRatio() > .80) {
+    if (deletedRatio() > m_policy.cleanupThreshold()) {
         rehash();
+    } else if(m_oldTable == nullptr && m_currentCap > MINPRIME && liveRatio() < m_policy.shrinkThreshold()) {
+        rehash(); // shrinks, rehash() sizes the new table from the live data
     } else if(m_oldTable != nullptr) { // whilst table is oldTable, we continue incrementally insertion...
         continueRehash();
     }
@@ -163,7 +311,7 @@ Person Cache::getPerson(string key, int id) const{
 
         // continue while the bucket in the old table is not equal to the person or until we hit the end...
         while((not (m_oldTable[index].getID() == id)) && i <= m_oldCap) { 
-            index = ((hashKey) + (i * i)) % m_oldCap;
+            index = (int)((hashKey + (long long)i * i) % m_oldCap);
             if(m_oldTable[index].getID() == id) {
                 // returns from oldTable
                 return m_oldTable[index];
@@ -188,7 +336,7 @@ Person Cache::getPerson(string key, int id) const{
     // we continue looping as long as the index is either empty or not the right ID... and not execisively over the cap.
     while((not (m_currentTable[index].getID() == id)) && i <= m_currentCap) {
 
-        index = ((m_hash(key) % m_currentCap) + (i * i)) % m_currentCap;
+        index = (int)((m_hash(key) % m_currentCap + (long long)i * i) % m_currentCap);
 
    
         if(m_currentTable[index].getID() == id) {
@@ -212,17 +360,163 @@ float Cache::deletedRatio() const {
     return ((float)m_currNumDeleted / (float)m_currentSize);
 }
 
+float Cache::liveRatio() const {
+    int live = (m_currentSize - m_currNumDeleted) + (m_oldSize - m_oldNumDeleted);
+    return ((float)live / (float)m_currentCap);
+}
+
+void Cache::setPolicy(const CachePolicy& policy) {
+    m_policy = policy;
+}
+
+CachePolicy Cache::getPolicy() const {
+    return m_policy;
+}
+
 void Cache::dump() const {
     cout << "Dump for the current table: " << endl;
     if (m_currentTable != nullptr)
         for (int i = 0; i < m_currentCap; i++) {
-            cout << "[" << i << "] : " << m_currentTable[i] << endl;
+            cout << "[" << i << "] : " << m_currentTable[i] << "\n";
         }
     cout << "Dump for the old table: " << endl;
     if (m_oldTable != nullptr)
         for (int i = 0; i < m_oldCap; i++) {
-            cout << "[" << i << "] : " << m_oldTable[i] << endl;
+            cout << "[" << i << "] : " << m_oldTable[i] << "\n";
         }
+    cout.flush();
+}
+
+bool Cache::openCursor(CacheCursor& cursor){
+    if (cursor.isOpen())
+        return false;
+
+    for (int bit = 0; bit < MAXCURSORS; bit++) {
+        unsigned char mark = (unsigned char)(1 << (bit + 2));
+        if ((m_cursorMarks & mark) == 0) {
+            m_cursorMarks |= mark;
+            cursor.m_mark = mark;
+            cursor.m_epoch = m_rehashEpoch;
+            cursor.m_inOld = true;
+            cursor.m_index = 0;
+            return true;
+        }
+    }
+
+    // every cursor bit is taken...
+    return false;
+}
+
+bool Cache::nextPerson(CacheCursor& cursor, Person& person){
+    if (not cursor.isOpen())
+        return false;
+
+    // a new rehash swapped the tables, start over. the marks keep us from
+    // visiting anybody twice and people only ever move from old to current
+    if (cursor.m_epoch != m_rehashEpoch) {
+        cursor.m_epoch = m_rehashEpoch;
+        cursor.m_inOld = true;
+        cursor.m_index = 0;
+    }
+
+    if (cursor.m_inOld) {
+        // m_oldTable goes away once everything has been transferred
+        while (m_oldTable != nullptr && cursor.m_index < m_oldCap) {
+            unsigned char& meta = m_oldMeta[cursor.m_index++];
+            if ((meta & SLOTSTATE) == SLOTLIVE && (meta & cursor.m_mark) == 0) {
+                meta |= cursor.m_mark;
+                person = m_oldTable[cursor.m_index - 1];
+                return true;
+            }
+        }
+        cursor.m_inOld = false;
+        cursor.m_index = 0;
+    }
+
+    while (cursor.m_index < m_currentCap) {
+        unsigned char& meta = m_currentMeta[cursor.m_index++];
+        if ((meta & SLOTSTATE) == SLOTLIVE && (meta & cursor.m_mark) == 0) {
+            meta |= cursor.m_mark;
+            person = m_currentTable[cursor.m_index - 1];
+            return true;
+        }
+    }
+
+    return false;
+}
+
+int Cache::nextPeople(CacheCursor& cursor, vector<Person>& people, int count){
+    int appended = 0;
+    Person person;
+
+    while (appended < count && nextPerson(cursor, person)) {
+        people.push_back(person);
+        appended++;
+    }
+
+    return appended;
+}
+
+void Cache::closeCursor(CacheCursor& cursor){
+    if (not cursor.isOpen())
+        return;
+
+    // hand the bit back clean, so the next cursor that takes it starts fresh
+    unsigned char keep = (unsigned char)~cursor.m_mark;
+    for (int i = 0; i < m_currentCap; i++)
+        m_currentMeta[i] &= keep;
+    if (m_oldTable != nullptr)
+        for (int i = 0; i < m_oldCap; i++)
+            m_oldMeta[i] &= keep;
+
+    m_cursorMarks &= keep;
+    cursor.m_mark = 0;
+}
+
+void Cache::exportBinary(ostream& out) const {
+    string buffer;
+    buffer.reserve(EXPORTBUFFER);
+    if (m_oldTable != nullptr)
+        writeExport(out, buffer, true, m_oldTable, m_oldMeta, m_oldCap);
+    writeExport(out, buffer, true, m_currentTable, m_currentMeta, m_currentCap);
+    out.write(buffer.data(), buffer.size());
+}
+
+void Cache::exportText(ostream& out) const {
+    string buffer;
+    buffer.reserve(EXPORTBUFFER);
+    if (m_oldTable != nullptr)
+        writeExport(out, buffer, false, m_oldTable, m_oldMeta, m_oldCap);
+    writeExport(out, buffer, false, m_currentTable, m_currentMeta, m_currentCap);
+    out.write(buffer.data(), buffer.size());
+}
+
+void Cache::writeExport(ostream& out, string& buffer, bool binary,
+                        const Person* table, const unsigned char* meta, int cap) const {
+    for (int i = 0; i < cap; i++) {
+        if ((meta[i] & SLOTSTATE) != SLOTLIVE)
+            continue;
+
+        const Person& person = table[i];
+        if (binary) {
+            int id = person.m_id;
+            unsigned int length = person.m_key.size();
+            buffer.append((const char*)&id, sizeof(id));
+            buffer.append((const char*)&length, sizeof(length));
+            buffer.append(person.m_key);
+        } else {
+            buffer.append(person.m_key);
+            buffer += ',';
+            buffer.append(to_string(person.m_id));
+            buffer += '\n';
+        }
+
+        // one write per full buffer instead of one per person
+        if (buffer.size() >= (unsigned int)EXPORTBUFFER) {
+            out.write(buffer.data(), buffer.size());
+            buffer.clear();
+        }
+    }
 }
 
 bool Cache::isPrime(int number){
@@ -254,6 +548,196 @@ int Cache::findNextPrime(int current){
 }
 
 
+int Cache::returnNewCurrCap(int size){
+    // the capacity always stays a prime within [MINPRIME-MAXPRIME]
+    if (size < MINPRIME)
+        return MINPRIME;
+    else if (size > MAXPRIME)
+        return MAXPRIME;
+    else if (isPrime(size))
+        return size;
+
+    return findNextPrime(size);
+}
+
+void Cache::rehash(){
+    // a rehash that is still in progress has to finish before we start a new one
+    while (m_oldTable != nullptr) {
+        continueRehash();
+    }
+
+    m_oldTable = m_currentTable;
+    m_oldMeta = m_currentMeta;
+    m_oldCap = m_currentCap;
+    m_oldSize = m_currentSize;
+    m_oldNumDeleted = m_currNumDeleted;
+    m_rehashIndex = 0;
+    m_rehashEpoch++;
+
+    // new table is the smallest prime that puts the live data at half the grow threshold
+    m_currentCap = returnNewCurrCap(m_policy.rehashCapacity(m_oldSize - m_oldNumDeleted));
+    m_currentTable = new Person [m_currentCap];
+    m_currentMeta = new unsigned char [m_currentCap]();
+    for (int i = 0; i < m_currentCap; i++) {
+        m_currentTable[i] = EMPTY;
+    }
+    m_currentSize = 0;
+    m_currNumDeleted = 0;
+}
+
+void Cache::continueRehash(){
+    if (m_oldTable == nullptr)
+        return;
+
+    // every step transfers the next 25% of the old data, so 4 steps finish the job
+    int quota = (m_oldSize + 3) / 4;
+    int moved = 0;
+
+    for (; m_rehashIndex < m_oldCap && moved < quota; m_rehashIndex++) {
+        Person& person = m_oldTable[m_rehashIndex];
+        if ((m_oldMeta[m_rehashIndex] & SLOTSTATE) != SLOTLIVE)
+            continue;
+
+        int hashKey = m_hash(person.getKey()) % m_currentCap;
+        int index = hashKey;
+        int i = 0;
+        while ((not (m_currentTable[index] == EMPTY)) && (not (m_currentTable[index] == DELETED))) {
+            index = (int)((hashKey + (long long)i * i) % m_currentCap);
+            i++;
+        }
+
+        // the cursor marks travel with the person
+        m_currentTable[index] = person;
+        m_currentMeta[index] = m_oldMeta[m_rehashIndex];
+        m_currentSize++;
+
+        person = DELETED;
+        m_oldMeta[m_rehashIndex] = SLOTDELETED;
+        m_oldNumDeleted++;
+        moved++;
+    }
+
+    // everything has been transferred, the old table is no longer needed
+    if (m_rehashIndex >= m_oldCap) {
+        delete[] m_oldTable;
+        delete[] m_oldMeta;
+        m_oldTable = nullptr;
+        m_oldMeta = nullptr;
+        m_oldCap = 0;
+        m_oldSize = 0;
+        m_oldNumDeleted = 0;
+        m_rehashIndex = 0;
+    }
+}
+
+int Cache::placePerson(const Person& person, int hashKey, int lowSlot, int highSlot){
+    // quadratic probing only reaches (m_currentCap + 1) / 2 distinct buckets
+    for (long long i = 0; i <= m_currentCap / 2; i++) {
+        int index = (int)((hashKey + i * i) % m_currentCap);
+
+        if (index < lowSlot || index >= highSlot) // the bucket belongs to another band
+            return -1;
+        else if (m_currentMeta[index] == SLOTEMPTY) {
+            m_currentTable[index] = person;
+            m_currentMeta[index] = SLOTLIVE;
+            return 1;
+        } else if (m_currentTable[index] == person) { // if it's a duplicate. we can't have that here...
+            return 0;
+        }
+    }
+
+    // every bucket the probe sequence reaches is taken
+    return 2;
+}
+
+void Cache::placeRange(const vector<Person>& people, const vector<int>& homes,
+                        const vector<int>& order, int first, int last,
+                        int lowSlot, int highSlot, vector<int>& deferred, int& placed){
+    for (int i = first; i < last; i++) {
+        const Person& person = people[order[i]];
+
+        // check if ID is valid and within range.
+        if (person.getID() < MINID || person.getID() > MAXID)
+            continue;
+
+        int result = placePerson(person, homes[order[i]], lowSlot, highSlot);
+        if (result == 1)
+            placed++;
+        else if (result == -1 || result == 2)
+            deferred.push_back(order[i]);
+    }
+}
+
+CachePolicy::CachePolicy(double targetAvgProbe, int targetMaxProbe,
+                            double minLoad, double maxLoad, double shrinkLoad){
+    m_targetAvgProbe = targetAvgProbe;
+    m_targetMaxProbe = targetMaxProbe;
+    m_minLoad = minLoad;
+    m_maxLoad = maxLoad;
+    m_shrinkLoad = shrinkLoad;
+
+    // until we have seen some probes we start from the textbook thresholds
+    m_growLoad = 0.5;
+    if (m_growLoad < m_minLoad)
+        m_growLoad = m_minLoad;
+    else if (m_growLoad > m_maxLoad)
+        m_growLoad = m_maxLoad;
+    m_cleanupRatio = .80;
+
+    m_probeSum = 0;
+    m_probeMax = 0;
+    m_probeCount = 0;
+}
+
+double CachePolicy::shrinkThreshold() const {
+    // a freshly rehashed table sits at half the grow threshold, staying under
+    // a quarter of it keeps a shrink from bouncing straight back into a grow
+    if (m_shrinkLoad > m_growLoad / 4)
+        return m_growLoad / 4;
+    return m_shrinkLoad;
+}
+
+int CachePolicy::rehashCapacity(int live) const {
+    return (int)ceil(2.0 * live / m_growLoad);
+}
+
+void CachePolicy::recordProbe(int probes) {
+    m_probeSum += probes;
+    if (probes > m_probeMax)
+        m_probeMax = probes;
+    m_probeCount++;
+
+    if (m_probeCount >= POLICYWINDOW)
+        retune();
+}
+
+void CachePolicy::retune() {
+    double average = (double)m_probeSum / m_probeCount;
+
+    if (average > m_targetAvgProbe || m_probeMax > m_targetMaxProbe) {
+        // probes are too long, give the table more room and drop tombstones sooner
+        m_growLoad -= 0.05;
+        m_cleanupRatio -= 0.1;
+    } else if (average < m_targetAvgProbe / 2 && m_probeMax <= m_targetMaxProbe / 2) {
+        // the hash spreads well, let the table fill up more
+        m_growLoad += 0.05;
+        m_cleanupRatio += 0.1;
+    }
+
+    if (m_growLoad < m_minLoad)
+        m_growLoad = m_minLoad;
+    else if (m_growLoad > m_maxLoad)
+        m_growLoad = m_maxLoad;
+    if (m_cleanupRatio < 0.4)
+        m_cleanupRatio = 0.4;
+    else if (m_cleanupRatio > .80)
+        m_cleanupRatio = .80;
+
+    m_probeSum = 0;
+    m_probeMax = 0;
+    m_probeCount = 0;
+}
+
 ostream& operator<<(ostream& sout, const Person &person ) {
     if (!person.m_key.empty())
         sout << person.m_key << " (ID " << person.m_id << ")";
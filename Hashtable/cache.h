@@ -0,0 +1,180 @@
+// Date Created: December, 2022
+#ifndef CACHE_H
+#define CACHE_H
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <stdexcept>
+#include "math.h"
+using namespace std;
+class Grader;   // forward declaration (for grading purposes)
+class Tester;   // forward declaration
+class Person;   // forward declaration
+// Constant parameters, min and max values
+const int MINID = 1000;     // minimum person ID
+const int MAXID = 9999;     // maximum person ID
+const int MINPRIME = 101;   // Min size for hash table
+const int MAXPRIME = 99991; // Max size for hash table
+const int BULKMINPERTHREAD = 4096; // smallest batch worth a bulk-load thread
+const int EXPORTBUFFER = 65536;     // bytes buffered by an export before a write
+// Occupancy metadata, one byte per bucket. The low two bits hold the state
+// of the bucket, every other bit is the visited mark of one open cursor.
+const unsigned char SLOTEMPTY = 0;
+const unsigned char SLOTLIVE = 1;
+const unsigned char SLOTDELETED = 2;
+const unsigned char SLOTSTATE = 3;  // mask for the state bits
+const int MAXCURSORS = 6;           // number of cursors that can be open at once
+const int POLICYWINDOW = 1024;      // inserts observed before the policy retunes
+#define EMPTY Person("", 0)
+#define DELETED Person("DELETED", 0)
+
+// Hash function pointer type
+typedef unsigned int (*hash_fn)(string);
+
+class Person{
+    public:
+    friend class Grader; // for grading purposes
+    friend class Tester; // for testing purposes
+    friend class Cache;
+    Person(string key="", int id=0){m_key = key; m_id = id;}
+    string getKey() const {return m_key;}
+    int getID() const {return m_id;}
+    void setKey(string key){m_key=key;}
+    void setID(int id){m_id=id;}
+    // Overloaded insertion operator
+    friend ostream& operator<<(ostream& sout, const Person &person);
+    // Overloaded equality operator
+    friend bool operator==(const Person& lhs, const Person& rhs);
+    private:
+    string m_key;   // the search key
+    int m_id;       // the unique ID, MINID-MAXID
+};
+
+// Decides when the table grows, shrinks and cleans up its deleted buckets.
+// The latency targets are the average and the longest probe we want to see
+// on insert, the memory target is the range the grow threshold may move in.
+class CachePolicy{
+    public:
+    friend class Grader; // for grading purposes
+    friend class Tester; // for testing purposes
+    CachePolicy(double targetAvgProbe = 2.0, int targetMaxProbe = 32,
+                double minLoad = 0.25, double maxLoad = 0.75, double shrinkLoad = 0.05);
+    // rehash when lambda() goes over this
+    double growThreshold() const {return m_growLoad;}
+    // rehash when deletedRatio() goes over this
+    double cleanupThreshold() const {return m_cleanupRatio;}
+    // rehash to a smaller table when the live load goes under this
+    double shrinkThreshold() const;
+    // capacity that leaves live entries at half of the grow threshold
+    int rehashCapacity(int live) const;
+    // feeds the probe length of one insert
+    void recordProbe(int probes);
+    private:
+    double m_targetAvgProbe;    // average probe length we aim for
+    int m_targetMaxProbe;       // longest probe we are willing to see
+    double m_minLoad;           // lowest grow threshold, the latency bound
+    double m_maxLoad;           // highest grow threshold, the memory bound
+    double m_shrinkLoad;        // configured shrink threshold
+    double m_growLoad;          // current grow threshold
+    double m_cleanupRatio;      // current tombstone threshold
+    long long m_probeSum;       // probes seen in the current window
+    int m_probeMax;             // longest probe in the current window
+    int m_probeCount;           // inserts seen in the current window
+
+    void retune();
+};
+
+class CacheCursor{
+    public:
+    friend class Grader; // for grading purposes
+    friend class Tester; // for testing purposes
+    friend class Cache;
+    CacheCursor(){m_mark = 0; m_epoch = 0; m_inOld = true; m_index = 0;}
+    bool isOpen() const {return m_mark != 0;}
+    private:
+    unsigned char m_mark;   // the visited bit owned by this cursor, 0 when closed
+    int m_epoch;            // rehash epoch that m_index belongs to
+    bool m_inOld;           // walking m_oldTable first, then m_currentTable
+    int m_index;            // next bucket to look at
+};
+
+class Cache{
+    public:
+    friend class Grader; // for grading purposes
+    friend class Tester; // for testing purposes
+
+    Cache(int size, hash_fn hash);
+    // Builds the table from a batch of people, duplicates are skipped. Only
+    // people whose probe sequence is full go through insert, which may grow
+    // the table, any rehash that starts is finished before it returns.
+    // Throws length_error if they do not fit into a table of MAXPRIME buckets
+    Cache(const vector<Person>& people, hash_fn hash);
+    ~Cache();
+    // Returns true if the person is inserted
+    bool insert(Person person);
+    // Returns true if the person is removed
+    bool remove(Person person);
+    // Returns the person if it is found, otherwise returns EMPTY
+    Person getPerson(string key, int id) const;
+    float lambda() const;
+    float deletedRatio() const;
+    // live entries over capacity, counting both tables
+    float liveRatio() const;
+    void dump() const;
+
+    // Cursors visit every person that stays in the cache exactly once,
+    // even while a rehash moves people between the tables.
+    // Returns false if MAXCURSORS cursors are already open
+    bool openCursor(CacheCursor& cursor);
+    // Returns false once every person has been visited
+    bool nextPerson(CacheCursor& cursor, Person& person);
+    // Appends up to count people, returns how many were appended
+    int nextPeople(CacheCursor& cursor, vector<Person>& people, int count);
+    void closeCursor(CacheCursor& cursor);
+    // Writes every live person as an int ID, an unsigned key length and the key
+    void exportBinary(ostream& out) const;
+    // Writes every live person as "key,ID" lines
+    void exportText(ostream& out) const;
+    void setPolicy(const CachePolicy& policy);
+    CachePolicy getPolicy() const;
+
+    private:
+    hash_fn    m_hash;          // hash function
+    Person*    m_currentTable;  // hash table
+    unsigned char* m_currentMeta; // occupancy metadata of m_currentTable
+    int        m_currentCap;    // hash table size (capacity)
+    int        m_currentSize;   // current number of entries
+                                // m_currentSize includes deleted entries
+    int        m_currNumDeleted;// number of deleted entries
+    Person*    m_oldTable;      // hash table
+    unsigned char* m_oldMeta;   // occupancy metadata of m_oldTable
+    int        m_oldCap;        // hash table size (capacity)
+    int        m_oldSize;       // current number of entries
+                                // m_oldSize includes deleted entries
+    int        m_oldNumDeleted; // number of deleted entries
+    int        m_rehashIndex;   // next bucket of m_oldTable to transfer
+    int        m_rehashEpoch;   // number of times rehash() has started
+    unsigned char m_cursorMarks;// visited bits owned by open cursors
+    CachePolicy m_policy;       // grow, shrink and cleanup thresholds
+
+    //private helper functions
+    bool isPrime(int number);
+    int findNextPrime(int current);
+
+    /******************************************
+    * Private function declarations go here! *
+    ******************************************/
+    int returnNewCurrCap(int size);
+    void rehash();
+    void continueRehash();
+    void writeExport(ostream& out, string& buffer, bool binary,
+                        const Person* table, const unsigned char* meta, int cap) const;
+    // helpers for the bulk-load constructor
+    // 1 placed, 0 duplicate, -1 the probe left [lowSlot, highSlot), 2 no free bucket
+    int placePerson(const Person& person, int hashKey, int lowSlot, int highSlot);
+    void placeRange(const vector<Person>& people, const vector<int>& homes,
+                    const vector<int>& order, int first, int last,
+                    int lowSlot, int highSlot, vector<int>& deferred, int& placed);
+};
+#endif
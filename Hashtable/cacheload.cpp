@@ -0,0 +1,186 @@
+//load generator for cacheserver.cpp
+//usage: cacheload unix <socket path> [requests] [pipeline depth]
+//       cacheload tcp <port> [requests] [pipeline depth]
+
+#include "cache.h"
+#include "cacheproto.h"
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <cstdlib>
+#include <cerrno>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+const int NUMKEYS = 10000;  // distinct people the requests pick from
+
+int connectTo(const string& mode, const char* where);
+// Writes the requests (ends[i] is where request i ends) and reads their
+// responses at the same time, with at most depth requests unanswered.
+// latencies, if given, gets each request's time from its last byte sent
+// to its response read, in microseconds
+bool exchange(int fd, const string& requests, const vector<size_t>& ends, int depth,
+              vector<double>* latencies);
+
+int main(int argc, char* argv[]){
+    if (argc < 3) {
+        cerr << "usage: " << argv[0] << " unix <socket path> | tcp <port> [requests] [pipeline depth]" << endl;
+        return 1;
+    }
+
+    int requests = (argc > 3) ? atoi(argv[3]) : 1000000;
+    int depth = (argc > 4) ? atoi(argv[4]) : 32;
+    int fd = connectTo(argv[1], argv[2]);
+    if (fd < 0 || requests < 1 || depth < 1) {
+        cerr << "could not connect to " << argv[1] << " " << argv[2] << endl;
+        return 1;
+    }
+
+    // the first half of the people is already in the cache when we start
+    string batch;
+    vector<size_t> ends;
+    for (int i = 0; i < NUMKEYS / 2; i++) {
+        protoAppend(batch, OPINSERT, MINID + i % (MAXID - MINID + 1), "person" + to_string(i));
+        ends.push_back(batch.size());
+    }
+    if (!exchange(fd, batch, ends, NUMKEYS / 2, nullptr)) {
+        cerr << "lost the server while loading" << endl;
+        return 1;
+    }
+
+    // 80% reads, 10% inserts and 10% removes
+    mt19937 generator(10);// 10 is the fixed seed value
+    uniform_int_distribution<> keyDist(0, NUMKEYS - 1);
+    uniform_int_distribution<> opDist(0, 9);
+    batch.clear();
+    ends.clear();
+    for (int i = 0; i < requests; i++) {
+        int key = keyDist(generator);
+        int op = opDist(generator);
+        unsigned char code = (op == 0) ? OPINSERT : (op == 1) ? OPREMOVE : OPGET;
+        protoAppend(batch, code, MINID + key % (MAXID - MINID + 1), "person" + to_string(key));
+        ends.push_back(batch.size());
+    }
+
+    vector<double> latencies;
+    latencies.reserve(requests);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    if (!exchange(fd, batch, ends, depth, &latencies)) {
+        cerr << "lost the server after " << latencies.size() << " requests" << endl;
+        return 1;
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    close(fd);
+
+    sort(latencies.begin(), latencies.end());
+    cout << requests << " requests, pipeline depth " << depth << endl;
+    cout << "throughput: " << (long long)(requests / seconds) << " requests/s" << endl;
+    cout << "request latency p50: " << latencies[latencies.size() / 2] << " us, p99: "
+         << latencies[(latencies.size() * 99) / 100] << " us, max: " << latencies.back() << " us" << endl;
+
+    return 0;
+}
+
+int connectTo(const string& mode, const char* where) {
+    int fd = -1;
+
+    if (mode == "unix") {
+        struct sockaddr_un address;
+        if (strlen(where) >= sizeof(address.sun_path))
+            return -1;
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        strcpy(address.sun_path, where);
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd >= 0 && connect(fd, (struct sockaddr*)&address, sizeof(address)) < 0) {
+            close(fd);
+            fd = -1;
+        }
+    } else if (mode == "tcp") {
+        struct sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_port = htons(atoi(where));
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd >= 0 && connect(fd, (struct sockaddr*)&address, sizeof(address)) < 0) {
+            close(fd);
+            fd = -1;
+        }
+        if (fd >= 0) {
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        }
+    }
+
+    return fd;
+}
+
+bool exchange(int fd, const string& requests, const vector<size_t>& ends, int depth,
+              vector<double>* latencies) {
+    int count = ends.size();
+    vector<chrono::steady_clock::time_point> sentAt(count);
+    size_t written = 0;
+    int sent = 0;           // requests written in full
+    int answered = 0;
+    string buffer;
+    size_t offset = 0;
+    char chunk[65536];
+    unsigned char status;
+    int id;
+    string key;
+
+    // one poll loop for both directions, a server that stops reading until
+    // we drain its responses can never leave us stuck in a write
+    while (answered < count) {
+        size_t limit = ends[min(answered + depth, count) - 1];
+        struct pollfd waitFor;
+        waitFor.fd = fd;
+        waitFor.events = POLLIN | ((written < limit) ? POLLOUT : 0);
+        waitFor.revents = 0;
+        if (poll(&waitFor, 1, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+
+        if (waitFor.revents & POLLOUT) {
+            ssize_t put = send(fd, requests.data() + written, limit - written, MSG_DONTWAIT | MSG_NOSIGNAL);
+            if (put < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+                return false;
+            if (put > 0) {
+                written += put;
+                chrono::steady_clock::time_point now = chrono::steady_clock::now();
+                while (sent < count && ends[sent] <= written)
+                    sentAt[sent++] = now;
+            }
+        }
+
+        if (waitFor.revents & (POLLIN | POLLHUP | POLLERR)) {
+            ssize_t got = recv(fd, chunk, sizeof(chunk), MSG_DONTWAIT);
+            if (got == 0 || (got < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+                return false;
+            if (got > 0) {
+                buffer.append(chunk, got);
+                chrono::steady_clock::time_point now = chrono::steady_clock::now();
+                int used;
+                while ((used = protoParse(buffer.data() + offset, buffer.size() - offset, status, id, key)) > 0) {
+                    offset += used;
+                    // responses come back in order, so this one answers request number answered
+                    if (latencies != nullptr)
+                        latencies->push_back(chrono::duration<double, micro>(now - sentAt[answered]).count());
+                    answered++;
+                }
+                buffer.erase(0, offset);
+                offset = 0;
+            }
+        }
+    }
+    return true;
+}
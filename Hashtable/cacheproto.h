@@ -0,0 +1,50 @@
+// Date Created: December, 2022
+// Binary protocol spoken between cacheserver and its clients.
+// Every request is a fixed 6 byte header followed by the key:
+//      op (1 byte), key length (1 byte), ID (4 bytes, host order), key
+// Every response has the same layout, the op byte carries the status and
+// only a found GET sends the key back. Clients may pipeline any number of
+// requests, responses always come back in the same order. A request with
+// an empty key or an ID outside MINID-MAXID is answered with STATUSBAD.
+#ifndef CACHEPROTO_H
+#define CACHEPROTO_H
+#include <cstring>
+#include <string>
+using namespace std;
+
+const int PROTOHEADER = 6;      // bytes in front of every key
+const int PROTOMAXKEY = 255;    // the key length has to fit in one byte
+
+enum PROTOOP {OPINSERT = 1, OPREMOVE = 2, OPGET = 3};
+enum PROTOSTATUS {STATUSTRUE = 0, STATUSFALSE = 1, STATUSBAD = 2};
+
+// Appends one message to buffer, returns false if the key is too long
+inline bool protoAppend(string& buffer, unsigned char op, int id, const string& key) {
+    if (key.size() > (unsigned int)PROTOMAXKEY)
+        return false;
+
+    char header[PROTOHEADER];
+    header[0] = (char)op;
+    header[1] = (char)key.size();
+    memcpy(header + 2, &id, sizeof(id));
+    buffer.append(header, PROTOHEADER);
+    buffer.append(key);
+    return true;
+}
+
+// Reads one message from data, returns the bytes it used or 0 if the
+// message is not complete yet
+inline int protoParse(const char* data, int length, unsigned char& op, int& id, string& key) {
+    if (length < PROTOHEADER)
+        return 0;
+
+    int keyLength = (unsigned char)data[1];
+    if (length < PROTOHEADER + keyLength)
+        return 0;
+
+    op = (unsigned char)data[0];
+    memcpy(&id, data + 2, sizeof(id));
+    key.assign(data + PROTOHEADER, keyLength);
+    return PROTOHEADER + keyLength;
+}
+#endif
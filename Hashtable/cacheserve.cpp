@@ -0,0 +1,251 @@
+//epoll event loop for cacheserver.cpp
+
+#include "cacheserve.h"
+#include "cacheproto.h"
+#include <map>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+const int MAXEVENTS = 64;           // events handled per epoll_wait
+const int READCHUNK = 65536;        // bytes read per read() call
+const int OUTLIMIT = 4 * 1048576;   // stop reading a client that does not drain its responses
+
+class Connection{
+    public:
+    Connection(int fd = -1){m_fd = fd; m_events = EPOLLIN; m_readClosed = false;}
+    int m_fd;               // client socket
+    string m_in;            // bytes received but not parsed yet
+    string m_out;           // responses not written yet
+    unsigned int m_events;  // what epoll watches for on m_fd
+    bool m_readClosed;      // the client sent its last byte, answers may still be owed
+};
+
+bool setNonBlocking(int fd);
+void serve(Cache& cache, Connection& conn);
+bool flush(Connection& conn);
+void watch(int epollFd, Connection& conn);
+
+void runServer(int listenFd, bool tcp, hash_fn hash, volatile sig_atomic_t& stop){
+    int epollFd = epoll_create1(0);
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = listenFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event);
+
+    Cache cache(MINPRIME, hash);
+    map<int, Connection> connections;
+    struct epoll_event events[MAXEVENTS];
+    char chunk[READCHUNK];
+
+    while (!stop) {
+        int ready = epoll_wait(epollFd, events, MAXEVENTS, -1);
+        if (ready < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+
+        for (int e = 0; e < ready; e++) {
+            int fd = events[e].data.fd;
+
+            if (fd == listenFd) {
+                // take every pending client
+                int clientFd;
+                while ((clientFd = accept(listenFd, nullptr, nullptr)) >= 0) {
+                    setNonBlocking(clientFd);
+                    if (tcp) {
+                        int one = 1;
+                        setsockopt(clientFd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+                    }
+                    connections[clientFd] = Connection(clientFd);
+                    memset(&event, 0, sizeof(event));
+                    event.events = EPOLLIN;
+                    event.data.fd = clientFd;
+                    epoll_ctl(epollFd, EPOLL_CTL_ADD, clientFd, &event);
+                }
+                continue;
+            }
+
+            Connection& conn = connections[fd];
+            bool failed = (events[e].events & EPOLLERR) != 0;
+
+            // a hangup may still leave requests in the socket, they are read like any other
+            if (!failed && !conn.m_readClosed && (events[e].events & (EPOLLIN | EPOLLHUP))) {
+                // drain the socket, a client may have pipelined many requests
+                while (true) {
+                    ssize_t got = read(fd, chunk, READCHUNK);
+                    if (got > 0) {
+                        conn.m_in.append(chunk, got);
+                    } else if (got == 0) {
+                        conn.m_readClosed = true;
+                        break;
+                    } else {
+                        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+                            failed = true;
+                        if (errno != EINTR)
+                            break;
+                    }
+                }
+            }
+
+            // all responses of this wakeup go out in as few writes as possible,
+            // input left over from a full output buffer is picked up here too
+            if (!failed) {
+                serve(cache, conn);
+                if (!flush(conn))
+                    failed = true;
+            }
+
+            // after the end of its input a client is owed every complete request,
+            // it is done once they are all answered and written
+            unsigned char op;
+            int id;
+            string key;
+            bool answered = conn.m_out.empty()
+                            && protoParse(conn.m_in.data(), conn.m_in.size(), op, id, key) == 0;
+            if (failed || (conn.m_readClosed && answered)) {
+                epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+                close(fd);
+                connections.erase(fd);
+            } else {
+                watch(epollFd, conn);
+            }
+        }
+    }
+
+    for (map<int, Connection>::iterator it = connections.begin(); it != connections.end(); it++)
+        close(it->first);
+    close(epollFd);
+}
+
+int listenUnix(const char* path) {
+    struct sockaddr_un address;
+    if (strlen(path) >= sizeof(address.sun_path))
+        return -1;
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+    unlink(path); // a stale socket from a previous run
+
+    if (bind(fd, (struct sockaddr*)&address, sizeof(address)) < 0 || listen(fd, SOMAXCONN) < 0
+        || !setNonBlocking(fd)) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int listenTcp(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    // loopback only, the cache is not meant to leave the box
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (bind(fd, (struct sockaddr*)&address, sizeof(address)) < 0 || listen(fd, SOMAXCONN) < 0
+        || !setNonBlocking(fd)) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+void serve(Cache& cache, Connection& conn) {
+    int offset = 0;
+    int length = conn.m_in.size();
+    unsigned char op;
+    int id;
+    string key;
+
+    // answer every complete request, a partial one waits for the next read
+    while (conn.m_out.size() < (unsigned int)OUTLIMIT) {
+        int used = protoParse(conn.m_in.data() + offset, length - offset, op, id, key);
+        if (used == 0)
+            break;
+        offset += used;
+
+        // the EMPTY and DELETED sentinels are people too, a remove of one of
+        // them would match a free bucket, so nothing out of range gets through
+        if (key.empty() || id < MINID || id > MAXID) {
+            protoAppend(conn.m_out, STATUSBAD, id, "");
+        } else if (op == OPINSERT) {
+            protoAppend(conn.m_out, cache.insert(Person(key, id)) ? STATUSTRUE : STATUSFALSE, id, "");
+        } else if (op == OPREMOVE) {
+            protoAppend(conn.m_out, cache.remove(Person(key, id)) ? STATUSTRUE : STATUSFALSE, id, "");
+        } else if (op == OPGET) {
+            Person person = cache.getPerson(key, id);
+            if (person == EMPTY)
+                protoAppend(conn.m_out, STATUSFALSE, id, "");
+            else
+                protoAppend(conn.m_out, STATUSTRUE, person.getID(), person.getKey());
+        } else {
+            protoAppend(conn.m_out, STATUSBAD, id, "");
+        }
+    }
+
+    conn.m_in.erase(0, offset);
+}
+
+bool flush(Connection& conn) {
+    size_t written = 0;
+    while (written < conn.m_out.size()) {
+        ssize_t sent = write(conn.m_fd, conn.m_out.data() + written, conn.m_out.size() - written);
+        if (sent > 0) {
+            written += sent;
+        } else if (sent < 0 && errno == EINTR) {
+            continue;
+        } else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else {
+            return false;
+        }
+    }
+    conn.m_out.erase(0, written);
+    return true;
+}
+
+void watch(int epollFd, Connection& conn) {
+    // a client that is behind on reading gets no more input until it catches up,
+    // one that closed its end is only written to, it stays readable for good
+    unsigned int wanted = EPOLLIN;
+    if (!conn.m_out.empty() || conn.m_readClosed) {
+        wanted = EPOLLOUT;
+        if (!conn.m_readClosed && conn.m_out.size() < (unsigned int)OUTLIMIT)
+            wanted |= EPOLLIN;
+    }
+    if (wanted == conn.m_events)
+        return;
+
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = wanted;
+    event.data.fd = conn.m_fd;
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, conn.m_fd, &event);
+    conn.m_events = wanted;
+}
@@ -0,0 +1,18 @@
+// Date Created: December, 2022
+// The epoll event loop behind cacheserver. One thread, nonblocking
+// sockets, every client may pipeline requests and gets its responses back
+// in order. A client that shuts down its sending side still gets an answer
+// to every complete request it sent, the connection closes once they are out.
+#ifndef CACHESERVE_H
+#define CACHESERVE_H
+#include "cache.h"
+#include <csignal>
+
+// Both return the listening socket, nonblocking, or -1
+int listenUnix(const char* path);
+int listenTcp(int port);   // binds 127.0.0.1 only
+// Serves clients of listenFd from a Cache built with hash until stop is set
+// (a signal handler is expected to set it). Closes every client it still
+// has, listenFd is left to the caller
+void runServer(int listenFd, bool tcp, hash_fn hash, volatile sig_atomic_t& stop);
+#endif
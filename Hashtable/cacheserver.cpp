@@ -0,0 +1,61 @@
+//local network front end for cache.cpp, the event loop is in cacheserve.cpp
+//usage: cacheserver unix <socket path>
+//       cacheserver tcp <port>          (binds 127.0.0.1 only)
+
+#include "cache.h"
+#include "cacheserve.h"
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+volatile sig_atomic_t stopServer = 0;
+
+unsigned int hashCode(const string str);
+void onSignal(int);
+
+int main(int argc, char* argv[]){
+    if (argc != 3) {
+        cerr << "usage: " << argv[0] << " unix <socket path> | tcp <port>" << endl;
+        return 1;
+    }
+
+    string mode = argv[1];
+    int listenFd = -1;
+    if (mode == "unix")
+        listenFd = listenUnix(argv[2]);
+    else if (mode == "tcp")
+        listenFd = listenTcp(atoi(argv[2]));
+    if (listenFd < 0) {
+        cerr << "could not listen on " << mode << " " << argv[2] << endl;
+        return 1;
+    }
+
+    // no SA_RESTART, a signal has to wake up epoll_wait so we can clean up
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = onSignal;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+    signal(SIGPIPE, SIG_IGN);
+
+    runServer(listenFd, mode == "tcp", hashCode, stopServer);
+
+    close(listenFd);
+    if (mode == "unix")
+        unlink(argv[2]);
+
+    return 0;
+}
+
+void onSignal(int) {
+    stopServer = 1;
+}
+
+unsigned int hashCode(const string str) {
+   unsigned int val = 0 ;
+   const unsigned int thirtyThree = 33 ;  // magic number from textbook
+   for ( unsigned int i = 0 ; i < str.length(); i++)
+      val = val * thirtyThree + str[i] ;
+   return val ;
+}
@@ -0,0 +1,54 @@
+//benchmark driver for cache.cpp
+
+#include "cache.h"
+#include <chrono>
+#include <random>
+#include <vector>
+
+unsigned int hashCode(const string str);
+
+// times a single call of fn in milliseconds
+template <class Fn>
+double timeIt(Fn fn) {
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    fn();
+    chrono::steady_clock::time_point stop = chrono::steady_clock::now();
+    return chrono::duration<double, milli>(stop - start).count();
+}
+
+int main(){
+    // MAXPRIME caps the table, and rehash() sizes it at 4x the data
+    const int sizes[3] = {1000, 5000, 24000};
+
+    mt19937 generator(10);// 10 is the fixed seed value
+    uniform_int_distribution<> idDist(MINID, MAXID);
+
+    for (int s = 0; s < 3; s++) {
+        vector<Person> dataList;
+        for (int i = 0; i < sizes[s]; i++)
+            dataList.push_back(Person("person" + to_string(i), idDist(generator)));
+
+        double insertTime = timeIt([&dataList]() {
+            Cache cache(MINPRIME, hashCode);
+            for (unsigned int i = 0; i < dataList.size(); i++)
+                cache.insert(dataList[i]);
+        });
+
+        double bulkTime = timeIt([&dataList]() {
+            Cache cache(dataList, hashCode);
+        });
+
+        cout << sizes[s] << " people | repeated insert: " << insertTime
+             << " ms, bulk load: " << bulkTime << " ms" << endl;
+    }
+
+    return 0;
+}
+
+unsigned int hashCode(const string str) {
+   unsigned int val = 0 ;
+   const unsigned int thirtyThree = 33 ;  // magic number from textbook
+   for ( unsigned int i = 0 ; i < str.length(); i++)
+      val = val * thirtyThree + str[i] ;
+   return val ;
+}
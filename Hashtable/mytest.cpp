@@ -1,8 +1,16 @@
 //test driver for cache.cpp
 
 #include "cache.h"
+#include "shmcache.h"
+#include "cacheserve.h"
+#include "cacheproto.h"
 #include <random>
 #include <vector>
+#include <sstream>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 const int MINSEARCH = 0;
 const int MAXSEARCH = 7;
 // the following array defines sample search strings for testing
@@ -96,9 +104,25 @@ class Tester{
 
     bool testDeletionRehashTrigger(Cache&);
     bool testDeletionRehashCompletion(Cache&);
+
+    bool testBulkLoadNormal(vector<Person> dataList);
+
+    bool testCursorDuringRehash(Cache&);
+    bool testExportText(Cache&);
+
+    bool testPolicyBadHash(Cache&);
+    bool testPolicyShrink(Cache&);
+    bool testInsertionAtMaxPrime(Cache&);
+    bool testBulkLoadAtMaxPrime();
+
+    bool testSharedMemoryReader();
+    bool testSharedMemoryReuse();
+    bool testServerHalfClose();
+    bool testSharedMemoryDeadWriter();
 };
 
 unsigned int hashCode(const string str);
+unsigned int badHashCode(const string str);
 
 int main(){
     Tester Test;
@@ -273,6 +297,131 @@ int main(){
             cout << "Test Failed!" << endl;
         }
     }
+
+    {
+        cout << "Test 11: Bulk Load | Normal Case: ";
+        vector<Person> dataList;
+        Random RndID(MINID,MAXID);
+        Random RndStr(MINSEARCH,MAXSEARCH);
+
+        for (int i=0;i<20000;i++){
+            // generating random data, the keys are spread out so the bands get used
+            Person dataObj = Person(searchStr[RndStr.getRandNum()] + to_string(i), RndID.getRandNum());
+            dataList.push_back(dataObj);
+        }
+
+        if (Test.testBulkLoadNormal(dataList) == true) {
+            cout << "Test Passed!" << endl;
+        } else {
+            cout << "Test Failed!" << endl;
+        }
+    }
+
+    {
+        cout << "Test 12: Cursor | Rehash Between Steps Case: ";
+        Cache cache(MINPRIME, hashCode);
+
+        if (Test.testCursorDuringRehash(cache) == true) {
+            cout << "Test Passed!" << endl;
+        } else {
+            cout << "Test Failed!" << endl;
+        }
+    }
+
+    {
+        cout << "Test 13: Export | Text Case: ";
+        Cache cache(MINPRIME, hashCode);
+
+        if (Test.testExportText(cache) == true) {
+            cout << "Test Passed!" << endl;
+        } else {
+            cout << "Test Failed!" << endl;
+        }
+    }
+
+    {
+        cout << "Test 14: Policy | Bad Hash Case: ";
+        Cache cache(MINPRIME, badHashCode);
+
+        if (Test.testPolicyBadHash(cache) == true) {
+            cout << "Test Passed!" << endl;
+        } else {
+            cout << "Test Failed!" << endl;
+        }
+    }
+
+    {
+        cout << "Test 15: Policy | Shrink Case: ";
+        Cache cache(MINPRIME, hashCode);
+        cache.setPolicy(CachePolicy(2.0, 32, 0.25, 0.75, 0.1));
+
+        if (Test.testPolicyShrink(cache) == true) {
+            cout << "Test Passed!" << endl;
+        } else {
+            cout << "Test Failed!" << endl;
+        }
+    }
+
+    {
+        cout << "Test 16: Shared Memory | Reader Process Case: ";
+
+        if (Test.testSharedMemoryReader() == true) {
+            cout << "Test Passed!" << endl;
+        } else {
+            cout << "Test Failed!" << endl;
+        }
+    }
+
+    {
+        cout << "Test 17: Insertion | MAXPRIME Cap Case: ";
+        Cache cache(MINPRIME, hashCode);
+
+        if (Test.testInsertionAtMaxPrime(cache) == true) {
+            cout << "Test Passed!" << endl;
+        } else {
+            cout << "Test Failed!" << endl;
+        }
+    }
+
+    {
+        cout << "Test 18: Bulk Load | MAXPRIME Cap Case: ";
+
+        if (Test.testBulkLoadAtMaxPrime() == true) {
+            cout << "Test Passed!" << endl;
+        } else {
+            cout << "Test Failed!" << endl;
+        }
+    }
+
+    {
+        cout << "Test 19: Shared Memory | Reuse After Remove Case: ";
+
+        if (Test.testSharedMemoryReuse() == true) {
+            cout << "Test Passed!" << endl;
+        } else {
+            cout << "Test Failed!" << endl;
+        }
+    }
+
+    {
+        cout << "Test 20: Server | Half Close Case: ";
+
+        if (Test.testServerHalfClose() == true) {
+            cout << "Test Passed!" << endl;
+        } else {
+            cout << "Test Failed!" << endl;
+        }
+    }
+
+    {
+        cout << "Test 21: Shared Memory | Dead Writer Case: ";
+
+        if (Test.testSharedMemoryDeadWriter() == true) {
+            cout << "Test Passed!" << endl;
+        } else {
+            cout << "Test Failed!" << endl;
+        }
+    }
     return 0;
 }
 
@@ -284,6 +433,10 @@ unsigned int hashCode(const string str) {
    return val ;
 }
 
+unsigned int badHashCode(const string) {
+   return 7; // every key lands on the same bucket
+}
+
 bool Tester::testNormalInsertion(Cache& cache, vector<Person> oldDataList) {
     vector<Person> newDataList;
     Random RndID(MINID,MAXID);
@@ -625,3 +778,383 @@ bool Tester::testDeletionRehashCompletion(Cache& cache) {
         return false;
     }
 }
+
+bool Tester::testBulkLoadNormal(vector<Person> dataList) {
+    Cache cache(dataList, hashCode);
+
+    // the bulk load never leaves a rehash behind...
+    if (cache.m_oldTable != nullptr) {
+        return false;
+    }
+
+    // every person has to be found...
+    for (vector<Person>::iterator it = dataList.begin(); it != dataList.end(); it++){
+        if(cache.getPerson((*it).getKey(), (*it).getID()) == EMPTY) {
+            return false;
+        }
+    }
+
+    // and counted exactly once, there are no duplicates in dataList
+    if (cache.m_currentSize != (int)dataList.size()) {
+        return false;
+    }
+
+    return cache.lambda() <= 0.5;
+}
+
+bool Tester::testCursorDuringRehash(Cache& cache) {
+    vector<Person> newDataList;
+    Random RndID(MINID,MAXID);
+    int addSize = 50;
+
+    // right below the load factor that triggers a rehash
+    for (int i=0;i<addSize;i++){
+        Person dataObj = Person("first" + to_string(i), RndID.getRandNum());
+        newDataList.push_back(dataObj);
+        cache.insert(dataObj);
+    }
+
+    CacheCursor cursor;
+    if (cache.openCursor(cursor) == false) {
+        return false;
+    }
+
+    // every step inserts somebody new, the first insert starts a rehash and
+    // the following ones move the old table over through continueRehash()
+    vector<Person> visited;
+    Person person;
+    int epoch = cache.m_rehashEpoch;
+    int i = 0;
+    while (cache.nextPerson(cursor, person)) {
+        visited.push_back(person);
+        cache.insert(Person("second" + to_string(i), RndID.getRandNum()));
+        i++;
+    }
+    cache.closeCursor(cursor);
+
+    if (cache.m_rehashEpoch == epoch) { // the test is pointless without a rehash...
+        return false;
+    }
+
+    // everybody that was there the whole time is visited exactly once
+    for (vector<Person>::iterator it = newDataList.begin(); it != newDataList.end(); it++){
+        int count = 0;
+        for (vector<Person>::iterator jt = visited.begin(); jt != visited.end(); jt++){
+            if (*it == *jt)
+                count++;
+        }
+        if (count != 1) {
+            return false;
+        }
+    }
+
+    // the cursor bit has to be handed back clean
+    for (int j = 0; j < cache.m_currentCap; j++) {
+        if ((cache.m_currentMeta[j] & ~SLOTSTATE) != 0)
+            return false;
+    }
+
+    return cache.m_cursorMarks == 0;
+}
+
+bool Tester::testExportText(Cache& cache) {
+    Random RndID(MINID,MAXID);
+    int addSize = 40;
+
+    vector<Person> newDataList;
+    for (int i=0;i<addSize;i++){
+        Person dataObj = Person("person" + to_string(i), RndID.getRandNum());
+        newDataList.push_back(dataObj);
+        cache.insert(dataObj);
+    }
+    cache.remove(newDataList.back()); // leaves a deleted bucket behind
+
+    ostringstream out;
+    cache.exportText(out);
+
+    // one line per live person and no empty or deleted buckets
+    int lines = 0;
+    istringstream in(out.str());
+    string line;
+    while (getline(in, line)) {
+        if (line.empty() || line.find("DELETED") != string::npos)
+            return false;
+        lines++;
+    }
+
+    return lines == cache.m_currentSize - cache.m_currNumDeleted;
+}
+
+bool Tester::testPolicyBadHash(Cache& cache) {
+    double before = cache.m_policy.growThreshold();
+
+    // one full window of long probes
+    for (int i=0;i<POLICYWINDOW;i++){
+        cache.insert(Person("person" + to_string(i), MINID + i));
+    }
+
+    // the table has to leave itself more room
+    return cache.m_policy.growThreshold() < before;
+}
+
+bool Tester::testInsertionAtMaxPrime(Cache& cache) {
+    vector<Person> inserted;
+    int addSize = MAXPRIME + 1000; // more people than MAXPRIME buckets can hold
+
+    // the table stops growing at MAXPRIME, inserts that find no bucket have to fail
+    for (int i=0;i<addSize;i++){
+        Person dataObj = Person("person" + to_string(i), MINID + i % (MAXID - MINID + 1));
+        if (cache.insert(dataObj))
+            inserted.push_back(dataObj);
+    }
+    if (cache.m_currentCap != MAXPRIME || inserted.size() > (unsigned int)MAXPRIME
+        || inserted.size() == (unsigned int)addSize)
+        return false;
+
+    // everybody that got in can be found
+    for (unsigned int i = 0; i < inserted.size(); i += 97){
+        if (cache.getPerson(inserted[i].getKey(), inserted[i].getID()) == EMPTY)
+            return false;
+    }
+    return true;
+}
+
+bool Tester::testBulkLoadAtMaxPrime() {
+    vector<Person> dataList;
+    for (int i=0;i<MAXPRIME + 1000;i++){
+        dataList.push_back(Person("person" + to_string(i), MINID + i % (MAXID - MINID + 1)));
+    }
+
+    // a table of MAXPRIME buckets well over half full, nobody may go missing
+    vector<Person> fits(dataList.begin(), dataList.begin() + 80000);
+    Cache cache(fits, hashCode);
+    if (cache.m_currentSize != (int)fits.size())
+        return false;
+    for (unsigned int i = 0; i < fits.size(); i += 97){
+        if (cache.getPerson(fits[i].getKey(), fits[i].getID()) == EMPTY)
+            return false;
+    }
+
+    // a second copy of everyone is skipped, not taken for a full table
+    vector<Person> twice(fits);
+    twice.insert(twice.end(), fits.begin(), fits.end());
+    Cache deduplicated(twice, hashCode);
+    if (deduplicated.m_currentSize != (int)fits.size() || deduplicated.m_oldTable != nullptr)
+        return false;
+
+    // more people than buckets
+    try {
+        Cache tooMany(dataList, hashCode);
+    } catch (length_error&) {
+        return true;
+    }
+    return false;
+}
+
+bool Tester::testPolicyShrink(Cache& cache) {
+    vector<Person> newDataList;
+    int addSize = 2000;
+
+    for (int i=0;i<addSize;i++){
+        Person dataObj = Person("person" + to_string(i), MINID + i);
+        newDataList.push_back(dataObj);
+        cache.insert(dataObj);
+    }
+    int grownCap = cache.m_currentCap;
+
+    // remove people until the table starts to shrink...
+    while (cache.m_oldTable == nullptr) {
+        // the next remove would trigger a cleanup instead, nothing to test
+        if ((float)(cache.m_currNumDeleted + 1) / cache.m_currentSize > cache.m_policy.cleanupThreshold())
+            return false;
+        cache.remove(newDataList.back());
+        newDataList.pop_back();
+    }
+
+    // ...and let the transfer finish
+    while (cache.m_oldTable != nullptr) {
+        cache.remove(newDataList.back());
+        newDataList.pop_back();
+    }
+
+    // everybody left is still there
+    for (vector<Person>::iterator it = newDataList.begin(); it != newDataList.end(); it++){
+        if(cache.getPerson((*it).getKey(), (*it).getID()) == EMPTY) {
+            return false;
+        }
+    }
+
+    return cache.m_currentCap < grownCap;
+}
+
+bool Tester::testSharedMemoryReader() {
+    string name = "/mytest_shmcache_" + to_string(getpid());
+    vector<Person> newDataList;
+    Random RndID(MINID,MAXID);
+    int addSize = 100;
+
+    ShmCache writer(name, addSize, 4096, hashCode);
+    if (writer.isOpen() == false) {
+        return false;
+    }
+
+    for (int i=0;i<addSize;i++){
+        Person dataObj = Person("person" + to_string(i), RndID.getRandNum());
+        newDataList.push_back(dataObj);
+        writer.insert(dataObj);
+    }
+    Person removed = newDataList.back();
+    writer.remove(removed);
+    newDataList.pop_back();
+
+    // a second process maps the same table and looks everybody up
+    cout.flush();
+    pid_t child = fork();
+    if (child == 0) {
+        ShmCache reader(name, hashCode);
+        bool result = reader.isOpen() && not reader.isWriter();
+        result = result && (reader.insert(Person("reader", MINID)) == false);
+        for (vector<Person>::iterator it = newDataList.begin(); it != newDataList.end(); it++){
+            result = result && (*it == reader.getPerson((*it).getKey(), (*it).getID()));
+        }
+        result = result && (reader.getPerson(removed.getKey(), removed.getID()) == EMPTY);
+        _exit(result ? 0 : 1);
+    }
+
+    int status = 1;
+    waitpid(child, &status, 0);
+
+    // a reader built with another hash function has to refuse the segment
+    ShmCache otherHash(name, badHashCode);
+    bool refused = not otherHash.isOpen();
+    ShmCache::unlinkSegment(name);
+
+    return refused && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+bool Tester::testSharedMemoryReuse() {
+    string name = "/mytest_shmcache_reuse_" + to_string(getpid());
+    // just enough arena for one table full of keys
+    ShmCache writer(name, 100, 1200, hashCode);
+    ShmCache::unlinkSegment(name);
+    if (writer.isOpen() == false)
+        return false;
+
+    // fill the table up to its load limit
+    int filled = 0;
+    while (writer.insert(Person("person" + to_string(filled), MINID + filled)))
+        filled++;
+    if (filled < 50 || writer.lambda() > 0.5)
+        return false;
+
+    // every remove makes room for somebody new, however often the table was full
+    for (int round = 1; round <= 3; round++) {
+        for (int i = 0; i < filled; i++) {
+            if (not writer.remove(Person("person" + to_string(i + (round - 1) * filled), MINID + i)))
+                return false;
+        }
+        for (int i = 0; i < filled; i++) {
+            if (not writer.insert(Person("person" + to_string(i + round * filled), MINID + i)))
+                return false;
+        }
+    }
+    for (int i = 0; i < filled; i++) {
+        if (writer.contains("person" + to_string(i + 3 * filled), MINID + i) == false
+            || writer.contains("person" + to_string(i + 2 * filled), MINID + i) == true)
+            return false;
+    }
+    return writer.lambda() <= 0.5;
+}
+
+bool Tester::testServerHalfClose() {
+    const char* path = "mytest-cache.sock";
+    const int numRequests = 16000; // half of them inserts, every ID stays below MAXID
+    int listenFd = listenUnix(path);
+    if (listenFd < 0)
+        return false;
+
+    // the server runs in a child process until it is killed
+    cout.flush();
+    pid_t child = fork();
+    if (child == 0) {
+        static volatile sig_atomic_t stop = 0;
+        runServer(listenFd, false, hashCode, stop);
+        _exit(0);
+    }
+    close(listenFd);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+    bool result = fd >= 0 && connect(fd, (struct sockaddr*)&address, sizeof(address)) == 0;
+
+    // every request goes out in one pipeline, then the client stops sending
+    string requests;
+    for (int i = 0; i < numRequests; i++) {
+        int person = i % (numRequests / 2);
+        protoAppend(requests, (i < numRequests / 2) ? OPINSERT : OPGET, MINID + person, "person" + to_string(person));
+    }
+    size_t sent = 0;
+    while (result && sent < requests.size()) {
+        ssize_t written = write(fd, requests.data() + sent, requests.size() - sent);
+        result = written > 0;
+        sent += (written > 0) ? written : 0;
+    }
+    result = result && shutdown(fd, SHUT_WR) == 0;
+
+    // every request is still answered, then the server closes its end
+    string responses;
+    char chunk[4096];
+    ssize_t got;
+    while (result && (got = read(fd, chunk, sizeof(chunk))) > 0)
+        responses.append(chunk, got);
+    int answered = 0;
+    int offset = 0;
+    unsigned char status;
+    int id;
+    string key;
+    int used;
+    while ((used = protoParse(responses.data() + offset, responses.size() - offset, status, id, key)) > 0) {
+        result = result && status == STATUSTRUE;
+        offset += used;
+        answered++;
+    }
+    if (fd >= 0)
+        close(fd);
+
+    kill(child, SIGKILL);
+    waitpid(child, nullptr, 0);
+    unlink(path);
+    return result && answered == numRequests && offset == (int)responses.size();
+}
+
+bool Tester::testSharedMemoryDeadWriter() {
+    string name = "/mytest_shmcache_dead_" + to_string(getpid());
+    ShmCache writer(name, 10, 256, hashCode);
+    ShmCache reader(name, hashCode);
+    ShmCache::unlinkSegment(name);
+    if (writer.isOpen() == false || reader.isOpen() == false)
+        return false;
+    Person kept("person0", MINID);
+    writer.insert(kept);
+
+    // a writer that stops inside a change must not leave its readers spinning
+    writer.beginWrite();
+    bool threwGet = false, threwContains = false;
+    try {
+        reader.getPerson(kept.getKey(), kept.getID());
+    } catch (runtime_error&) {
+        threwGet = true;
+    }
+    try {
+        reader.contains(kept.getKey(), kept.getID());
+    } catch (runtime_error&) {
+        threwContains = true;
+    }
+
+    // once the change is finished the reader sees the table again
+    writer.endWrite();
+    return threwGet && threwContains && reader.getPerson(kept.getKey(), kept.getID()) == kept;
+}
@@ -0,0 +1,352 @@
+#include "shmcache.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <new>
+#include <cstring>
+#include <vector>
+#include <chrono>
+#include <stdexcept>
+#include <sched.h>
+
+const char SHMMAGICKEY[] = "shmcache";  // hashed by the writer and checked by readers
+
+// smallest prime that is at least number
+static int nextPrime(int number) {
+    if (number < 2)
+        return 2;
+    while (true) {
+        bool prime = true;
+        for (int j = 2; j * j <= number; j++) {
+            if (number % j == 0) {
+                prime = false;
+                break;
+            }
+        }
+        if (prime)
+            return number;
+        number++;
+    }
+}
+
+ShmCache::ShmCache(string name, int capacity, unsigned int arenaBytes, hash_fn hash){
+    m_hash = hash;
+    m_writer = true;
+    m_header = nullptr;
+    m_slots = nullptr;
+    m_arena = nullptr;
+    m_length = 0;
+
+    // twice the buckets keeps lambda at 0.5, where quadratic probing still finds a spot
+    int buckets = nextPrime(2 * (capacity < 1 ? 1 : capacity));
+    m_length = sizeof(ShmHeader) + buckets * sizeof(ShmSlot) + arenaBytes;
+
+    // O_EXCL, there is only ever one writer for a segment
+    m_fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (m_fd < 0)
+        return;
+    if (ftruncate(m_fd, m_length) < 0) {
+        close(m_fd);
+        m_fd = -1;
+        shm_unlink(name.c_str());
+        return;
+    }
+
+    void* mapping = mmap(nullptr, m_length, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (mapping == MAP_FAILED) {
+        close(m_fd);
+        m_fd = -1;
+        shm_unlink(name.c_str());
+        return;
+    }
+
+    // ftruncate hands us zeroed pages, so every bucket already is SLOTEMPTY
+    ShmHeader* header = new (mapping) ShmHeader;
+    header->m_hashCheck = m_hash(SHMMAGICKEY);
+    header->m_capacity = buckets;
+    header->m_size = 0;
+    header->m_numDeleted = 0;
+    header->m_arenaSize = arenaBytes;
+    header->m_arenaUsed = 0;
+    header->m_sequence.store(0, memory_order_relaxed);
+    attach(mapping);
+
+    // readers check the magic last, it is only there once the rest is
+    atomic_thread_fence(memory_order_release);
+    header->m_magic = SHMMAGIC;
+}
+
+ShmCache::ShmCache(string name, hash_fn hash){
+    m_hash = hash;
+    m_writer = false;
+    m_header = nullptr;
+    m_slots = nullptr;
+    m_arena = nullptr;
+    m_length = 0;
+
+    m_fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (m_fd < 0)
+        return;
+
+    struct stat info;
+    if (fstat(m_fd, &info) < 0 || info.st_size < (off_t)sizeof(ShmHeader)) {
+        close(m_fd);
+        m_fd = -1;
+        return;
+    }
+    m_length = info.st_size;
+
+    void* mapping = mmap(nullptr, m_length, PROT_READ, MAP_SHARED, m_fd, 0);
+    if (mapping == MAP_FAILED) {
+        close(m_fd);
+        m_fd = -1;
+        return;
+    }
+
+    // a segment that is not set up yet, or one built with another hash, is useless to us
+    ShmHeader* header = (ShmHeader*)mapping;
+    atomic_thread_fence(memory_order_acquire);
+    if (header->m_magic != SHMMAGIC || header->m_hashCheck != m_hash(SHMMAGICKEY)
+        || sizeof(ShmHeader) + header->m_capacity * sizeof(ShmSlot) + header->m_arenaSize > m_length) {
+        munmap(mapping, m_length);
+        close(m_fd);
+        m_fd = -1;
+        return;
+    }
+    attach(mapping);
+}
+
+ShmCache::~ShmCache(){
+    if (m_header != nullptr)
+        munmap(m_header, m_length);
+    if (m_fd >= 0)
+        close(m_fd);
+    m_header = nullptr;
+    m_slots = nullptr;
+    m_arena = nullptr;
+    m_fd = -1;
+}
+
+bool ShmCache::isOpen() const {
+    return m_header != nullptr;
+}
+
+bool ShmCache::isWriter() const {
+    return m_writer && m_header != nullptr;
+}
+
+bool ShmCache::insert(Person person){
+    if (not isWriter())
+        return false;
+
+    // check if ID is valid and within range.
+    if (person.getID() < MINID || person.getID() > MAXID)
+        return false;
+
+    string key = person.getKey();
+    if (find(key, person.getID()) != -1) // if it's a duplicate. we can't have that here...
+        return false;
+
+    // a removed person leaves a tombstone and its key bytes behind, once
+    // they are all that stands in the way the table is laid out again
+    ShmHeader* header = m_header;
+    int index = freeSlot(key);
+    auto blocked = [this, header, &key, &index]() {
+        // only a new bucket counts against the load limit, a reused tombstone does not
+        return index == -1 || key.size() > header->m_arenaSize - header->m_arenaUsed
+               || (m_slots[index].m_state == SLOTEMPTY
+                   && (float)(header->m_size + 1) / header->m_capacity > 0.5);
+    };
+    if (blocked() && header->m_numDeleted > 0) {
+        compact();
+        index = freeSlot(key);
+    }
+    if (blocked())
+        return false;
+
+    // the key bytes are not reachable until the bucket points at them,
+    // but the bucket itself has to change under the sequence counter
+    memcpy(m_arena + header->m_arenaUsed, key.data(), key.size());
+    beginWrite();
+    ShmSlot& slot = m_slots[index];
+    if (slot.m_state == SLOTDELETED)
+        header->m_numDeleted--;
+    else
+        header->m_size++;
+    slot.m_keyOffset = header->m_arenaUsed;
+    slot.m_keyLength = key.size();
+    slot.m_id = person.getID();
+    slot.m_state = SLOTLIVE;
+    header->m_arenaUsed += key.size();
+    endWrite();
+
+    return true;
+}
+
+bool ShmCache::remove(Person person){
+    if (not isWriter())
+        return false;
+
+    int index = find(person.getKey(), person.getID());
+    if (index == -1)
+        return false;
+
+    // the key bytes stay in the arena, a reader may still be looking at them
+    beginWrite();
+    m_slots[index].m_state = SLOTDELETED;
+    m_header->m_numDeleted++;
+    endWrite();
+
+    return true;
+}
+
+Person ShmCache::getPerson(string key, int id) const {
+    if (not isOpen())
+        return EMPTY;
+
+    // retry until no write happened while we were looking
+    while (true) {
+        unsigned int before = waitForWriter();
+
+        int index = find(key, id);
+        Person person = EMPTY;
+        if (index != -1)
+            person = Person(key, id);
+
+        atomic_thread_fence(memory_order_acquire);
+        if (m_header->m_sequence.load(memory_order_relaxed) == before)
+            return person;
+    }
+}
+
+bool ShmCache::contains(const string& key, int id) const {
+    if (not isOpen())
+        return false;
+
+    while (true) {
+        unsigned int before = waitForWriter();
+
+        bool found = find(key, id) != -1;
+
+        atomic_thread_fence(memory_order_acquire);
+        if (m_header->m_sequence.load(memory_order_relaxed) == before)
+            return found;
+    }
+}
+
+float ShmCache::lambda() const {
+    if (not isOpen())
+        return 0;
+    return ((float)m_header->m_size / (float)m_header->m_capacity);
+}
+
+bool ShmCache::unlinkSegment(string name){
+    return shm_unlink(name.c_str()) == 0;
+}
+
+void ShmCache::attach(void* mapping){
+    m_header = (ShmHeader*)mapping;
+    m_slots = (ShmSlot*)((char*)mapping + sizeof(ShmHeader));
+    m_arena = (char*)(m_slots + m_header->m_capacity);
+}
+
+int ShmCache::find(const string& key, int id) const {
+    int capacity = m_header->m_capacity;
+    unsigned int arenaSize = m_header->m_arenaSize;
+    int hashKey = m_hash(key) % capacity;
+
+    for (long long i = 0; i <= capacity / 2; i++) {
+        int index = (int)((hashKey + i * i) % capacity);
+        const ShmSlot& slot = m_slots[index];
+
+        // nothing was ever stored past an empty bucket
+        if (slot.m_state == SLOTEMPTY)
+            return -1;
+
+        // a racing writer can leave anything in the bucket, so the offsets are
+        // checked before we touch the arena, the sequence check sorts out the rest
+        if (slot.m_state == SLOTLIVE && slot.m_id == id && slot.m_keyLength == key.size()
+            && slot.m_keyOffset <= arenaSize && slot.m_keyLength <= arenaSize - slot.m_keyOffset
+            && memcmp(m_arena + slot.m_keyOffset, key.data(), key.size()) == 0)
+            return index;
+    }
+
+    return -1;
+}
+
+int ShmCache::freeSlot(const string& key) const {
+    int capacity = m_header->m_capacity;
+    int hashKey = m_hash(key) % capacity;
+
+    for (long long i = 0; i <= capacity / 2; i++) {
+        int index = (int)((hashKey + i * i) % capacity);
+        if (m_slots[index].m_state != SLOTLIVE)
+            return index;
+    }
+    return -1;
+}
+
+void ShmCache::compact(){
+    // the live buckets and their keys are copied out first, the writer is
+    // the only one changing the segment, so they cannot move meanwhile
+    int capacity = m_header->m_capacity;
+    vector<ShmSlot> live;
+    string keys;
+    for (int i = 0; i < capacity; i++) {
+        if (m_slots[i].m_state != SLOTLIVE)
+            continue;
+        ShmSlot slot = m_slots[i];
+        slot.m_keyOffset = keys.size();
+        keys.append(m_arena + m_slots[i].m_keyOffset, m_slots[i].m_keyLength);
+        live.push_back(slot);
+    }
+
+    // readers that look while the table is rebuilt see the sequence move and retry
+    beginWrite();
+    memset((void*)m_slots, 0, capacity * sizeof(ShmSlot));
+    memcpy(m_arena, keys.data(), keys.size());
+    for (unsigned int p = 0; p < live.size(); p++) {
+        int hashKey = m_hash(string(m_arena + live[p].m_keyOffset, live[p].m_keyLength)) % capacity;
+        int index = hashKey;
+        for (long long i = 0; m_slots[index].m_state != SLOTEMPTY; i++)
+            index = (int)((hashKey + i * i) % capacity);
+        m_slots[index] = live[p];
+    }
+    m_header->m_size = live.size();
+    m_header->m_numDeleted = 0;
+    m_header->m_arenaUsed = keys.size();
+    endWrite();
+}
+
+unsigned int ShmCache::waitForWriter() const {
+    unsigned int sequence = m_header->m_sequence.load(memory_order_acquire);
+    if ((sequence & 1) == 0)
+        return sequence;
+
+    // a writer in the middle of a change keeps the counter odd for microseconds,
+    // one that keeps the same odd value for SHMWRITERTIMEOUT has died there
+    unsigned int stuck = sequence;
+    chrono::steady_clock::time_point since = chrono::steady_clock::now();
+    while (true) {
+        sched_yield();
+        sequence = m_header->m_sequence.load(memory_order_acquire);
+        if ((sequence & 1) == 0)
+            return sequence;
+        if (sequence != stuck) {
+            stuck = sequence;
+            since = chrono::steady_clock::now();
+        } else if (chrono::steady_clock::now() - since > chrono::milliseconds(SHMWRITERTIMEOUT)) {
+            throw runtime_error("The writer of a shared memory cache stopped in the middle of a change!");
+        }
+    }
+}
+
+void ShmCache::beginWrite(){
+    m_header->m_sequence.fetch_add(1, memory_order_acq_rel);
+    atomic_thread_fence(memory_order_release);
+}
+
+void ShmCache::endWrite(){
+    m_header->m_sequence.fetch_add(1, memory_order_release);
+}
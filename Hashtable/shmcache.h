@@ -0,0 +1,92 @@
+// Date Created: December, 2022
+// A Cache whose buckets and keys live in a named POSIX shared memory
+// segment, so processes on the same box can look people up without a
+// socket hop. One process creates the segment and is the only writer,
+// any number of processes can open it read-only at the same time.
+//
+// Nothing inside the segment is a pointer. A bucket finds its key by an
+// offset from the start of the key arena, so every process can map the
+// segment at a different address. Readers never lock, a sequence counter
+// tells them to retry a lookup that raced with the writer.
+#ifndef SHMCACHE_H
+#define SHMCACHE_H
+#include "cache.h"
+#include <atomic>
+
+const unsigned int SHMMAGIC = 0x53484d43;   // "SHMC", marks an initialized segment
+const int SHMWRITERTIMEOUT = 500;           // ms a reader waits on an unfinished write
+
+// Layout of the segment: ShmHeader, then m_capacity ShmSlots, then the key arena
+struct ShmHeader{
+    unsigned int m_magic;       // SHMMAGIC once the writer is done setting up
+    unsigned int m_hashCheck;   // hash of SHMMAGICKEY, readers must hash the same way
+    int m_capacity;             // number of buckets, a prime
+    int m_size;                 // current number of entries, includes deleted entries
+    int m_numDeleted;           // number of deleted entries
+    unsigned int m_arenaSize;   // bytes reserved for keys
+    unsigned int m_arenaUsed;   // bytes of the arena handed out so far
+    atomic<unsigned int> m_sequence; // odd while the writer is changing something
+};
+
+struct ShmSlot{
+    unsigned int m_keyOffset;   // where the key starts in the arena
+    unsigned int m_keyLength;   // bytes in the key
+    int m_id;                   // the person ID
+    unsigned int m_state;       // SLOTEMPTY, SLOTLIVE or SLOTDELETED
+};
+
+class ShmCache{
+    public:
+    friend class Grader; // for grading purposes
+    friend class Tester; // for testing purposes
+
+    // Creates the segment name (it has to start with '/') with room for
+    // capacity people and arenaBytes of keys, this process becomes the writer
+    ShmCache(string name, int capacity, unsigned int arenaBytes, hash_fn hash);
+    // Opens an existing segment read-only
+    ShmCache(string name, hash_fn hash);
+    ~ShmCache();
+    // Returns false if the segment could not be created or opened
+    bool isOpen() const;
+    bool isWriter() const;
+    // Writer only. Returns false when the table or the key arena is full,
+    // if removes left room behind the table is compacted first
+    bool insert(Person person);
+    // Writer only
+    bool remove(Person person);
+    // Returns the person if it is found, otherwise returns EMPTY. Throws
+    // runtime_error if the writer died in the middle of a change, the
+    // segment cannot be trusted any more then
+    Person getPerson(string key, int id) const;
+    // Same lookup without building a Person, throws the same way
+    bool contains(const string& key, int id) const;
+    float lambda() const;
+    // Removes the name, mappings that are already open keep working
+    static bool unlinkSegment(string name);
+
+    private:
+    hash_fn m_hash;         // hash function, the same in every process
+    int m_fd;               // shared memory descriptor
+    size_t m_length;        // bytes mapped
+    bool m_writer;          // true in the process that created the segment
+    ShmHeader* m_header;    // start of the mapping
+    ShmSlot* m_slots;       // buckets, right after the header
+    char* m_arena;          // keys, right after the buckets
+
+    ShmCache(const ShmCache&);            // a mapping is never copied
+    ShmCache& operator=(const ShmCache&);
+
+    void attach(void* mapping);
+    // Returns the bucket of the person or -1, does not check the sequence
+    int find(const string& key, int id) const;
+    // First bucket that is not live on the probe sequence of key, or -1
+    int freeSlot(const string& key) const;
+    // Lays the live people out again, without tombstones or dead key bytes
+    void compact();
+    // Waits until no write is in progress and returns the even sequence
+    // number, throws runtime_error if one never ends
+    unsigned int waitForWriter() const;
+    void beginWrite();
+    void endWrite();
+};
+#endif
@@ -0,0 +1,150 @@
+// Date Created: November, 2022
+// Keeps only the capacity most urgent crops of a stream of any length. The
+// crops sit in an interval heap whose vectors are allocated once, up front,
+// so nothing allocates after construction. Once the queue is full a crop
+// that does not beat the least urgent one is turned away in O(1) by a look
+// at the worst slot, any other crop takes that slot in O(log capacity).
+#ifndef BOUNDEDQUEUE_H
+#define BOUNDEDQUEUE_H
+#include "intervalheap.h"
+
+template <class Priority, class Order>
+class BoundedIQueue{
+    public:
+    friend class Grader; // for grading purposes
+    friend class Tester; // for testing purposes
+
+    // Throws domain_error unless capacity is at least 1
+    BoundedIQueue(int capacity, Priority priority = Priority(), Order order = Order());
+    // Returns false if the crop was turned away. A full queue gives up its
+    // least urgent crop for it, ties stay with the crop already in
+    bool insertCrop(const Crop& crop);
+    // Offers count crops one after another, returns how many were kept
+    int insertCrops(const Crop* crops, int count);
+    Crop getNextCrop(); // Return the highest priority crop
+    Crop getLastCrop(); // Return the lowest priority crop kept
+    // Priority a crop has to beat once the queue is full, throws domain_error if empty
+    int getLastPriority() const;
+    // Takes the k highest priority crops out, highest first, into out
+    int getNextCrops(int k, Crop* out);
+    void clear();
+    int numCrops() const; // Return number of crops in queue
+    int getCapacity() const;
+    long long numRejected() const; // crops turned away or pushed out since construction or clear
+    void printCropsQueue() const;
+    void dump() const; // For debugging purposes
+
+    private:
+    IntervalIQueue<Priority, Order> m_heap;
+    int m_capacity;
+    long long m_rejected;
+};
+
+template <class Priority, class Order>
+BoundedIQueue<Priority, Order>::BoundedIQueue(int capacity, Priority priority, Order order)
+  : m_heap(priority, order)
+{
+    if(capacity < 1) {
+        throw std::domain_error("A bounded queue needs room for at least one crop!");
+    }
+    m_capacity = capacity;
+    m_rejected = 0;
+    m_heap.reserve(capacity);
+}
+
+template <class Priority, class Order>
+bool BoundedIQueue<Priority, Order>::insertCrop(const Crop& crop) {
+    IntervalIQueue<Priority, Order>& heap = m_heap;
+    int size = heap.m_crops.size();
+    if(size < m_capacity) {
+        heap.insertCrop(crop);
+        return true;
+    }
+
+    // full: the newcomer has to strictly beat the worst crop
+    int priority = heap.m_priorFunc(crop);
+    int worst = (size == 1) ? 0 : 1;
+    if(!heap.beats(priority, heap.m_priorities[worst])) {
+        m_rejected++;
+        return false;
+    }
+
+    heap.m_priorities[worst] = priority;
+    heap.m_crops[worst] = crop;
+    if(worst == 1) {
+        // it may even be the new best, then the old best sinks on the worst side
+        if(heap.beats(heap.m_priorities[1], heap.m_priorities[0])) {
+            swap(heap.m_priorities[0], heap.m_priorities[1]);
+            swap(heap.m_crops[0], heap.m_crops[1]);
+        }
+        heap.trickleDownWorst(1);
+    }
+    m_rejected++; // the displaced crop is turned away too
+    return true;
+}
+
+template <class Priority, class Order>
+int BoundedIQueue<Priority, Order>::insertCrops(const Crop* crops, int count) {
+    int kept = 0;
+    for(int i = 0; i < count; i++) {
+        if(insertCrop(crops[i])) {
+            kept++;
+        }
+    }
+    return kept;
+}
+
+template <class Priority, class Order>
+Crop BoundedIQueue<Priority, Order>::getNextCrop() {
+    return m_heap.getNextCrop();
+}
+
+template <class Priority, class Order>
+Crop BoundedIQueue<Priority, Order>::getLastCrop() {
+    return m_heap.getLastCrop();
+}
+
+template <class Priority, class Order>
+int BoundedIQueue<Priority, Order>::getLastPriority() const {
+    if(m_heap.m_crops.empty()) {
+        throw std::domain_error("You are attempting to look at the last crop of an empty heap!");
+    }
+    return m_heap.m_priorities[m_heap.m_crops.size() == 1 ? 0 : 1];
+}
+
+template <class Priority, class Order>
+int BoundedIQueue<Priority, Order>::getNextCrops(int k, Crop* out) {
+    return m_heap.getNextCrops(k, out);
+}
+
+template <class Priority, class Order>
+void BoundedIQueue<Priority, Order>::clear() {
+    m_heap.clear(); // keeps the vectors' memory
+    m_rejected = 0;
+}
+
+template <class Priority, class Order>
+int BoundedIQueue<Priority, Order>::numCrops() const {
+    return m_heap.numCrops();
+}
+
+template <class Priority, class Order>
+int BoundedIQueue<Priority, Order>::getCapacity() const {
+    return m_capacity;
+}
+
+template <class Priority, class Order>
+long long BoundedIQueue<Priority, Order>::numRejected() const {
+    return m_rejected;
+}
+
+template <class Priority, class Order>
+void BoundedIQueue<Priority, Order>::printCropsQueue() const {
+    m_heap.printCropsQueue();
+}
+
+template <class Priority, class Order>
+void BoundedIQueue<Priority, Order>::dump() const {
+    m_heap.dump();
+}
+#endif
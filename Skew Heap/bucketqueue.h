@@ -0,0 +1,389 @@
+// Date Created: November, 2022
+// Bucket queue for priority functions with a small integer range, like
+// priorityFn1 (30-116) and priorityFn2 (0-103). There is one bucket of
+// Crops per priority value and a bitmap with one bit per non-empty bucket,
+// so an insert is a push_back and a pop finds the top bucket with a
+// count-leading/trailing-zeros on a few 64-bit words.
+#ifndef BUCKETQUEUE_H
+#define BUCKETQUEUE_H
+#include "iqueue.h"
+#include <algorithm>
+#include <cstdint>
+
+const int MAXBUCKETS = 4096; // widest priority range a BucketIQueue takes
+
+template <class Priority, class Order>
+class BucketIQueue{
+    public:
+    friend class Grader; // for grading purposes
+    friend class Tester; // for testing purposes
+
+    // minPriority and maxPriority are the range the priority function is
+    // declared to have, throws out_of_range if it is wider than MAXBUCKETS
+    BucketIQueue(int minPriority, int maxPriority, Priority priority = Priority(), Order order = Order());
+    // A crop with a priority outside the range widens it, throws
+    // out_of_range (and keeps the queue as it was) if it gets too wide
+    void insertCrop(const Crop& crop);
+    // Same as insertCrop for each crop, but the range is widened once and a
+    // range that gets too wide leaves the queue as it was
+    void insertCrops(const Crop* crops, int count);
+    Crop getNextCrop(); // Return the highest priority crop
+    // Priority of the crop getNextCrop would return, throws domain_error if empty
+    int getNextPriority() const;
+    // Takes the k highest priority crops out, highest first, into out (room
+    // for k crops). Returns how many there were
+    int getNextCrops(int k, Crop* out);
+    // Same crops in the same order as getNextCrops, but the queue does not change
+    int peekTopK(int k, Crop* out) const;
+    // Throws out_of_range (and keeps both queues as they were) if the
+    // combined range is too wide
+    void mergeWithQueue(BucketIQueue& rhs);
+    void clear();
+    int numCrops() const; // Return number of crops in queue
+    void cropIDs(vector<int>& out) const; // Appends every crop ID, bucket by bucket
+    void printCropsQueue() const; // Print the queue in pop order
+    const Priority& getPriority() const;
+    const Order& getOrder() const;
+    // Set a new priority and order, throws out_of_range (and keeps the queue
+    // as it was) if the new priorities do not fit into MAXBUCKETS
+    void setPriority(Priority priority, Order order);
+    int getMinPriority() const;
+    int getMaxPriority() const;
+    void dump() const; // For debugging purposes
+
+    private:
+    vector<vector<Crop> > m_buckets;    // m_buckets[p - m_minPriority] holds the crops with priority p
+    vector<uint64_t> m_bitmap;          // bit b is set if m_buckets[b] is not empty
+    int m_minPriority;                  // priority of m_buckets[0]
+    int m_maxPriority;                  // priority of m_buckets.back()
+    int m_size;                         // Current number of crops
+    Priority m_priorFunc;               // Computes the priority of a crop
+    Order m_order;                      // Decides which of two priorities goes on top
+    bool m_maxFirst;                    // true if higher priorities come out first
+
+    // makes the range cover [low, high], existing crops keep their buckets
+    void widen(int low, int high);
+    // index of the bucket the next crop comes from, m_size must not be 0
+    int topBucket() const;
+    void markBucket(int bucket);
+    void unmarkBucket(int bucket);
+};
+
+template <class Priority, class Order>
+BucketIQueue<Priority, Order>::BucketIQueue(int minPriority, int maxPriority, Priority priority, Order order) {
+    if(minPriority > maxPriority || (long long)maxPriority - minPriority + 1 > MAXBUCKETS) {
+        throw std::out_of_range("The priority range does not fit into a bucket queue!");
+    }
+    m_minPriority = minPriority;
+    m_maxPriority = maxPriority;
+    m_buckets.resize(maxPriority - minPriority + 1);
+    m_bitmap.assign((m_buckets.size() + 63) / 64, 0);
+    m_size = 0;
+    m_priorFunc = priority;
+    m_order = order;
+    m_maxFirst = m_order(1, 0);
+}
+
+template <class Priority, class Order>
+void BucketIQueue<Priority, Order>::insertCrop(const Crop& crop) {
+    int priority = m_priorFunc(crop);
+    if(priority < m_minPriority || priority > m_maxPriority) {
+        widen(priority < m_minPriority ? priority : m_minPriority,
+              priority > m_maxPriority ? priority : m_maxPriority);
+    }
+
+    int bucket = priority - m_minPriority;
+    if(m_buckets[bucket].empty()) {
+        markBucket(bucket);
+    }
+    m_buckets[bucket].push_back(crop);
+    m_size++;
+}
+
+template <class Priority, class Order>
+void BucketIQueue<Priority, Order>::insertCrops(const Crop* crops, int count) {
+    if(count <= 0) {
+        return;
+    }
+
+    vector<int> priorities(count);
+    computePriorities(m_priorFunc, crops, count, priorities.data());
+    int low = m_minPriority;
+    int high = m_maxPriority;
+    for(int i = 0; i < count; i++) {
+        low = min(low, priorities[i]);
+        high = max(high, priorities[i]);
+    }
+    widen(low, high);
+
+    for(int i = 0; i < count; i++) {
+        int bucket = priorities[i] - m_minPriority;
+        if(m_buckets[bucket].empty()) {
+            markBucket(bucket);
+        }
+        m_buckets[bucket].push_back(crops[i]);
+    }
+    m_size += count;
+}
+
+template <class Priority, class Order>
+Crop BucketIQueue<Priority, Order>::getNextCrop() {
+    if(m_size == 0) {
+        throw std::domain_error("You are attempting to get next crop from an empty bucket queue!");
+    }
+
+    int bucket = topBucket();
+    Crop nextCrop = m_buckets[bucket].back();
+    m_buckets[bucket].pop_back(); // the bucket keeps its capacity for the next insert
+    if(m_buckets[bucket].empty()) {
+        unmarkBucket(bucket);
+    }
+    m_size--;
+
+    return nextCrop;
+}
+
+template <class Priority, class Order>
+int BucketIQueue<Priority, Order>::getNextPriority() const {
+    if(m_size == 0) {
+        throw std::domain_error("You are attempting to look at the next crop of an empty bucket queue!");
+    }
+    return m_minPriority + topBucket();
+}
+
+template <class Priority, class Order>
+int BucketIQueue<Priority, Order>::getNextCrops(int k, Crop* out) {
+    // whole runs come off the back of each bucket, the bitmap is read once per bucket
+    int count = 0;
+    while(count < k && m_size > 0) {
+        int bucket = topBucket();
+        vector<Crop>& crops = m_buckets[bucket];
+        int take = min(k - count, (int)crops.size());
+        for(int i = 0; i < take; i++) {
+            out[count++] = crops[crops.size() - 1 - i];
+        }
+        crops.resize(crops.size() - take);
+        if(crops.empty()) {
+            unmarkBucket(bucket);
+        }
+        m_size -= take;
+    }
+    return count;
+}
+
+template <class Priority, class Order>
+int BucketIQueue<Priority, Order>::peekTopK(int k, Crop* out) const {
+    int count = 0;
+    int buckets = m_buckets.size();
+    for(int i = 0; i < buckets && count < k; i++) {
+        int b = m_maxFirst ? buckets - 1 - i : i;
+        for(int c = m_buckets[b].size() - 1; c >= 0 && count < k; c--) {
+            out[count++] = m_buckets[b][c];
+        }
+    }
+    return count;
+}
+
+template <class Priority, class Order>
+void BucketIQueue<Priority, Order>::mergeWithQueue(BucketIQueue& rhs) {
+    if(this == &rhs || rhs.m_size == 0) {
+        return;
+    }
+
+    widen(min(m_minPriority, rhs.m_minPriority), max(m_maxPriority, rhs.m_maxPriority));
+
+    int offset = rhs.m_minPriority - m_minPriority;
+    for(unsigned int b = 0; b < rhs.m_buckets.size(); b++) {
+        vector<Crop>& from = rhs.m_buckets[b];
+        if(from.empty()) {
+            continue;
+        }
+        vector<Crop>& to = m_buckets[b + offset];
+        if(to.empty()) {
+            to.swap(from);
+            markBucket(b + offset);
+        } else {
+            to.insert(to.end(), from.begin(), from.end());
+        }
+    }
+    m_size += rhs.m_size;
+    rhs.clear();
+}
+
+template <class Priority, class Order>
+void BucketIQueue<Priority, Order>::clear() {
+    for(unsigned int b = 0; b < m_buckets.size(); b++) {
+        m_buckets[b].clear();
+    }
+    m_bitmap.assign(m_bitmap.size(), 0);
+    m_size = 0;
+}
+
+template <class Priority, class Order>
+int BucketIQueue<Priority, Order>::numCrops() const {
+    return m_size;
+}
+
+template <class Priority, class Order>
+void BucketIQueue<Priority, Order>::cropIDs(vector<int>& out) const {
+    for(unsigned int b = 0; b < m_buckets.size(); b++) {
+        for(unsigned int i = 0; i < m_buckets[b].size(); i++) {
+            out.push_back(m_buckets[b][i].getCropID());
+        }
+    }
+}
+
+template <class Priority, class Order>
+void BucketIQueue<Priority, Order>::printCropsQueue() const {
+    int buckets = m_buckets.size();
+    for(int i = 0; i < buckets; i++) {
+        int b = m_maxFirst ? buckets - 1 - i : i;
+        for(int c = m_buckets[b].size() - 1; c >= 0; c--) {
+            const Crop& crop = m_buckets[b][c];
+            cout << "[" << b + m_minPriority << "] Crop ID:" <<  crop.getCropID() << ", current temperature: " << crop.getTemperature() << ", current soil moisture: " << crop.getMoisture() << "%, current time: " << crop.getTimeString() << ", plant type: " << crop.getTypeString() << endl;
+        }
+    }
+}
+
+template <class Priority, class Order>
+const Priority& BucketIQueue<Priority, Order>::getPriority() const {
+    return m_priorFunc;
+}
+
+template <class Priority, class Order>
+const Order& BucketIQueue<Priority, Order>::getOrder() const {
+    return m_order;
+}
+
+template <class Priority, class Order>
+void BucketIQueue<Priority, Order>::setPriority(Priority priority, Order order) {
+    // every new priority is computed before anything changes, so a range
+    // that turns out too wide leaves the queue untouched
+    vector<Crop> crops;
+    crops.reserve(m_size);
+    for(unsigned int b = 0; b < m_buckets.size(); b++) {
+        crops.insert(crops.end(), m_buckets[b].begin(), m_buckets[b].end());
+    }
+    vector<int> priorities(crops.size());
+    computePriorities(priority, crops.data(), crops.size(), priorities.data());
+
+    // the new range is whatever the new priorities cover, the old one means nothing now
+    int low = m_minPriority;
+    int high = m_maxPriority;
+    if(!priorities.empty()) {
+        low = *min_element(priorities.begin(), priorities.end());
+        high = *max_element(priorities.begin(), priorities.end());
+    }
+    if((long long)high - low + 1 > MAXBUCKETS) {
+        throw std::out_of_range("The new priorities do not fit into a bucket queue!");
+    }
+
+    m_buckets.assign(high - low + 1, vector<Crop>());
+    m_bitmap.assign((m_buckets.size() + 63) / 64, 0);
+    m_minPriority = low;
+    m_maxPriority = high;
+    m_priorFunc = priority;
+    m_order = order;
+    m_maxFirst = m_order(1, 0);
+
+    for(unsigned int i = 0; i < crops.size(); i++) {
+        int bucket = priorities[i] - m_minPriority;
+        if(m_buckets[bucket].empty()) {
+            markBucket(bucket);
+        }
+        m_buckets[bucket].push_back(crops[i]);
+    }
+    m_size = crops.size();
+}
+
+template <class Priority, class Order>
+int BucketIQueue<Priority, Order>::getMinPriority() const {
+    return m_minPriority;
+}
+
+template <class Priority, class Order>
+int BucketIQueue<Priority, Order>::getMaxPriority() const {
+    return m_maxPriority;
+}
+
+template <class Priority, class Order>
+void BucketIQueue<Priority, Order>::dump() const {
+    if (m_size == 0) {
+        cout << "Empty bucket queue.\n" ;
+        return;
+    }
+
+    // one pair of brackets per non-empty bucket, in pop order
+    int buckets = m_buckets.size();
+    for(int i = 0; i < buckets; i++) {
+        int b = m_maxFirst ? buckets - 1 - i : i;
+        if(m_buckets[b].empty()) {
+            continue;
+        }
+        cout << "[" << b + m_minPriority << ":";
+        for(int c = m_buckets[b].size() - 1; c >= 0; c--) {
+            cout << " " << m_buckets[b][c].getCropID();
+        }
+        cout << "]";
+    }
+    cout << endl;
+}
+
+template <class Priority, class Order>
+void BucketIQueue<Priority, Order>::widen(int low, int high) {
+    if(low >= m_minPriority && high <= m_maxPriority) {
+        return;
+    }
+    if((long long)high - low + 1 > MAXBUCKETS) {
+        throw std::out_of_range("The priority range does not fit into a bucket queue!");
+    }
+
+    // new buckets go in front and behind, the existing ones move as a block
+    int front = m_minPriority - low;
+    int back = high - m_maxPriority;
+    if(front > 0) {
+        m_buckets.insert(m_buckets.begin(), front, vector<Crop>());
+        m_minPriority = low;
+    }
+    if(back > 0) {
+        m_buckets.resize(m_buckets.size() + back);
+        m_maxPriority = high;
+    }
+
+    m_bitmap.assign((m_buckets.size() + 63) / 64, 0);
+    for(unsigned int b = 0; b < m_buckets.size(); b++) {
+        if(!m_buckets[b].empty()) {
+            markBucket(b);
+        }
+    }
+}
+
+template <class Priority, class Order>
+int BucketIQueue<Priority, Order>::topBucket() const {
+    int words = m_bitmap.size();
+    if(m_maxFirst) {
+        for(int w = words - 1; w >= 0; w--) {
+            if(m_bitmap[w] != 0) {
+                return w * 64 + 63 - __builtin_clzll(m_bitmap[w]);
+            }
+        }
+    } else {
+        for(int w = 0; w < words; w++) {
+            if(m_bitmap[w] != 0) {
+                return w * 64 + __builtin_ctzll(m_bitmap[w]);
+            }
+        }
+    }
+    return -1;
+}
+
+template <class Priority, class Order>
+void BucketIQueue<Priority, Order>::markBucket(int bucket) {
+    m_bitmap[bucket / 64] |= (uint64_t)1 << (bucket % 64);
+}
+
+template <class Priority, class Order>
+void BucketIQueue<Priority, Order>::unmarkBucket(int bucket) {
+    m_bitmap[bucket / 64] &= ~((uint64_t)1 << (bucket % 64));
+}
+#endif
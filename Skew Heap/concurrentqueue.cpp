@@ -0,0 +1,123 @@
+#include "concurrentqueue.h"
+#include <thread>
+#include <functional>
+
+const int MAXSAMPLES = 64;  // failed samples before a pop checks every sub-queue
+
+ConcurrentIQueue::ConcurrentIQueue(prifn_t priFn, HEAPTYPE heapType, int numThreads, int queuesPerThread){
+    m_priorFunc = priFn;
+    m_heapType = heapType;
+    m_numQueues = max(2, max(1, numThreads) * max(1, queuesPerThread)); // two choices need two queues
+    m_queues = new SubQueue[m_numQueues];
+    for (int i = 0; i < m_numQueues; i++) {
+        m_queues[i].m_heap.setPriority(FnPriority(priFn), HeapOrder(heapType));
+        m_queues[i].m_empty.store(true, memory_order_relaxed);
+        m_queues[i].m_topPriority.store(0, memory_order_relaxed);
+    }
+    m_size.store(0, memory_order_relaxed);
+}
+
+ConcurrentIQueue::~ConcurrentIQueue(){
+    delete [] m_queues;
+    m_queues = nullptr;
+    m_numQueues = 0;
+}
+
+void ConcurrentIQueue::insertCrop(const Crop& crop){
+    // a busy sub-queue is skipped rather than waited for
+    while (true) {
+        SubQueue& queue = m_queues[randomQueue()];
+        if (!queue.m_lock.try_lock())
+            continue;
+        queue.m_heap.insertCrop(crop);
+        publishTop(queue);
+        m_size.fetch_add(1, memory_order_relaxed); // before unlocking, so it never goes below 0
+        queue.m_lock.unlock();
+        return;
+    }
+}
+
+bool ConcurrentIQueue::getNextCrop(Crop& crop){
+    for (int sample = 0; sample < MAXSAMPLES; sample++) {
+        if (m_size.load(memory_order_relaxed) == 0)
+            return false;
+
+        int first = randomQueue();
+        int second = randomQueue();
+        if (second == first)
+            second = (first + 1) % m_numQueues;
+        SubQueue* chosen = looksBetter(m_queues[first], m_queues[second]) ? &m_queues[first] : &m_queues[second];
+        if (chosen->m_empty.load(memory_order_acquire))
+            continue;
+
+        if (!chosen->m_lock.try_lock())
+            continue;
+        bool popped = popLocked(*chosen, crop);
+        chosen->m_lock.unlock();
+        if (popped)
+            return true;
+    }
+
+    // nothing found by sampling, so look at every sub-queue before saying it is empty
+    for (int i = 0; i < m_numQueues; i++) {
+        lock_guard<mutex> guard(m_queues[i].m_lock);
+        if (popLocked(m_queues[i], crop))
+            return true;
+    }
+    return false;
+}
+
+int ConcurrentIQueue::numCrops() const {
+    return m_size.load(memory_order_relaxed);
+}
+
+int ConcurrentIQueue::numQueues() const {
+    return m_numQueues;
+}
+
+prifn_t ConcurrentIQueue::getPriorityFn() const {
+    return m_priorFunc;
+}
+
+HEAPTYPE ConcurrentIQueue::getHeapType() const {
+    return m_heapType;
+}
+
+int ConcurrentIQueue::randomQueue() const {
+    // xorshift, seeded differently in every thread
+    static thread_local unsigned int state = 0;
+    if (state == 0)
+        state = (unsigned int)hash<thread::id>()(this_thread::get_id()) | 1;
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state % m_numQueues;
+}
+
+bool ConcurrentIQueue::looksBetter(const SubQueue& left, const SubQueue& right) const {
+    if (left.m_empty.load(memory_order_relaxed))
+        return false;
+    if (right.m_empty.load(memory_order_relaxed))
+        return true;
+    int leftTop = left.m_topPriority.load(memory_order_relaxed);
+    int rightTop = right.m_topPriority.load(memory_order_relaxed);
+    return (m_heapType == MAXHEAP) ? leftTop >= rightTop : leftTop <= rightTop;
+}
+
+void ConcurrentIQueue::publishTop(SubQueue& queue){
+    if (queue.m_heap.numCrops() == 0) {
+        queue.m_empty.store(true, memory_order_release);
+        return;
+    }
+    queue.m_topPriority.store(queue.m_heap.getNextPriority(), memory_order_relaxed);
+    queue.m_empty.store(false, memory_order_release);
+}
+
+bool ConcurrentIQueue::popLocked(SubQueue& queue, Crop& crop){
+    if (queue.m_heap.numCrops() == 0)
+        return false;
+    crop = queue.m_heap.getNextCrop();
+    publishTop(queue);
+    m_size.fetch_sub(1, memory_order_relaxed);
+    return true;
+}
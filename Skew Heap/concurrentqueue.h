@@ -0,0 +1,69 @@
+// Date Created: November, 2022
+// A relaxed priority queue many threads can insert into and pop from at
+// the same time (a MultiQueue). It is made of c*P independent skew heaps,
+// each behind its own mutex that is only ever try-locked on the fast path.
+// An insert goes to a random sub-queue. A pop samples two sub-queues,
+// compares their cached top priorities without locking and takes from the
+// better one. When a try-lock fails the thread just samples again.
+//
+// The price is that a pop is not always the best crop in the whole queue.
+// With q sub-queues the expected rank of a popped crop (0 = the crop a
+// single IQueue would have returned) is O(q), and it is O(q log q) with
+// high probability, independent of the number of crops. The default of 2
+// sub-queues per thread keeps q at 2P.
+#ifndef CONCURRENTQUEUE_H
+#define CONCURRENTQUEUE_H
+#include "iqueue.h"
+#include <atomic>
+#include <mutex>
+
+const int QUEUESPERTHREAD = 2;  // sub-queues per thread, the c of c*P
+const int CACHELINE = 64;       // sub-queues are padded to this, no false sharing
+
+class ConcurrentIQueue{
+    public:
+    friend class Grader; // for grading purposes
+    friend class Tester; // for testing purposes
+
+    // numThreads is how many threads are expected to use the queue at once
+    ConcurrentIQueue(prifn_t priFn, HEAPTYPE heapType, int numThreads, int queuesPerThread = QUEUESPERTHREAD);
+    ~ConcurrentIQueue();
+    void insertCrop(const Crop& crop);
+    // Pops a crop close to the highest priority one into crop. Returns
+    // false if the whole queue was empty
+    bool getNextCrop(Crop& crop);
+    // Exact once every thread is done, a snapshot while they are running
+    int numCrops() const;
+    int numQueues() const;
+    prifn_t getPriorityFn() const;
+    HEAPTYPE getHeapType() const;
+
+    private:
+    typedef BasicIQueue<FnPriority, HeapOrder> SubHeap;
+    class alignas(CACHELINE) SubQueue{
+        public:
+        mutex m_lock;               // guards m_heap
+        SubHeap m_heap;             // the crops of this sub-queue
+        atomic<bool> m_empty;       // read without the lock when sampling
+        atomic<int> m_topPriority;  // priority of the top crop, only valid if !m_empty
+    };
+
+    SubQueue* m_queues;         // array of m_numQueues sub-queues
+    int m_numQueues;
+    prifn_t m_priorFunc;        // Function to compute priority
+    HEAPTYPE m_heapType;        // either a MINHEAP or a MAXHEAP
+    atomic<int> m_size;         // crops in all sub-queues together
+
+    // index of a random sub-queue, every thread has its own generator
+    int randomQueue() const;
+    // true if sub-queue left looks better than right from the cached tops
+    bool looksBetter(const SubQueue& left, const SubQueue& right) const;
+    // refreshes the cached top of a locked sub-queue
+    void publishTop(SubQueue& queue);
+    // pops from a locked sub-queue, false if it turned out to be empty
+    bool popLocked(SubQueue& queue, Crop& crop);
+
+    ConcurrentIQueue(const ConcurrentIQueue&);            // never copied
+    ConcurrentIQueue& operator=(const ConcurrentIQueue&);
+};
+#endif
@@ -0,0 +1,257 @@
+#include "cropfile.h"
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+const int MAXFIELDDIGITS = 9;   // longer numbers would overflow an int, the line is malformed
+
+CropFileLoader::CropFileLoader(const string& path, CROPFILEFORMAT format) {
+    m_data = nullptr;
+    m_size = 0;
+    m_format = format;
+    restart();
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if(fd < 0) {
+        throw std::runtime_error("Cannot open the crop file " + path + "!");
+    }
+    struct stat info;
+    if(fstat(fd, &info) != 0) {
+        close(fd);
+        throw std::runtime_error("Cannot read the size of the crop file " + path + "!");
+    }
+    m_size = info.st_size;
+    if(m_size > 0) {
+        void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(data == MAP_FAILED) {
+            close(fd);
+            throw std::runtime_error("Cannot map the crop file " + path + "!");
+        }
+        madvise(data, m_size, MADV_SEQUENTIAL); // only a hint, the file is read front to back
+        m_data = static_cast<const char*>(data);
+    }
+    close(fd); // the mapping stays
+}
+
+CropFileLoader::~CropFileLoader() {
+    stopParser(false);
+    if(m_data != nullptr) {
+        munmap(const_cast<char*>(m_data), m_size);
+    }
+}
+
+long long CropFileLoader::readCrops(vector<Crop>& crops) {
+    restart();
+    Crop block[RUNBLOCK];
+    int count;
+    while((count = parseBatch(block, RUNBLOCK)) > 0) {
+        crops.insert(crops.end(), block, block + count);
+    }
+    return m_loaded;
+}
+
+long long CropFileLoader::numLoaded() const {
+    return m_loaded;
+}
+
+long long CropFileLoader::numMalformed() const {
+    return m_malformed;
+}
+
+long long CropFileLoader::numOutOfRange() const {
+    return m_outOfRange;
+}
+
+long long CropFileLoader::fileSize() const {
+    return m_size;
+}
+
+void CropFileLoader::restart() {
+    m_pos = 0;
+    m_loaded = 0;
+    m_malformed = 0;
+    m_outOfRange = 0;
+}
+
+int CropFileLoader::parseBatch(Crop* out, int count) {
+    int parsed = 0;
+    if(m_format == BINARYFILE) {
+        const unsigned char* data = reinterpret_cast<const unsigned char*>(m_data);
+        while(parsed < count && m_pos + CROPRECORDSIZE <= m_size) {
+            const unsigned char* record = data + m_pos;
+            int ID = (int)(record[0] | (record[1] << 8) | (record[2] << 16) | ((unsigned int)record[3] << 24));
+            checkRange(ID, record[4], record[5], record[6], record[7]);
+            out[parsed++] = decodeCrop(record);
+            m_pos += CROPRECORDSIZE;
+        }
+        if(parsed < count && m_pos < m_size) {
+            m_malformed++; // a cut off record at the end
+            m_pos = m_size;
+        }
+        m_loaded += parsed;
+        return parsed;
+    }
+
+    while(parsed < count && m_pos < m_size) {
+        // memchr is vectorized, it finds the end of the line 16 or 32 bytes at a time
+        const char* begin = m_data + m_pos;
+        const char* end = static_cast<const char*>(memchr(begin, '\n', m_size - m_pos));
+        if(end == nullptr) {
+            end = m_data + m_size;
+        }
+        m_pos = end - m_data + 1;
+
+        const char* last = end;
+        if(last > begin && last[-1] == '\r') {
+            last--;
+        }
+        if(last == begin) {
+            continue; // blank line
+        }
+        if(begin == m_data && (*begin < '0' || *begin > '9') && *begin != '-' && *begin != '+') {
+            continue; // header
+        }
+        if(parseLine(begin, last, out[parsed])) {
+            parsed++;
+        } else {
+            m_malformed++;
+        }
+    }
+    m_loaded += parsed;
+    return parsed;
+}
+
+bool CropFileLoader::parseLine(const char* begin, const char* end, Crop& crop) {
+    int fields[5];
+    const char* p = begin;
+    for(int f = 0; f < 5; f++) {
+        while(p < end && (*p == ' ' || *p == '\t')) {
+            p++;
+        }
+        bool negative = false;
+        if(p < end && (*p == '-' || *p == '+')) {
+            negative = (*p == '-');
+            p++;
+        }
+        int value = 0;
+        int digits = 0;
+        while(p < end && *p >= '0' && *p <= '9') {
+            value = value * 10 + (*p - '0');
+            digits++;
+            p++;
+        }
+        if(digits == 0 || digits > MAXFIELDDIGITS) {
+            return false;
+        }
+        fields[f] = negative ? -value : value;
+
+        while(p < end && (*p == ' ' || *p == '\t')) {
+            p++;
+        }
+        if(f < 4) {
+            if(p == end || *p != ',') {
+                return false;
+            }
+            p++;
+        }
+    }
+    if(p != end) {
+        return false;
+    }
+
+    checkRange(fields[0], fields[1], fields[2], fields[3], fields[4]);
+    crop = Crop(fields[0], fields[1], fields[2], fields[3], fields[4]);
+    return true;
+}
+
+void CropFileLoader::checkRange(int ID, int temperature, int moisture, int time, int type) {
+    if(ID < MINCROPID || ID > MAXCROPID || temperature < MINTEMP || temperature > MAXTEMP
+        || moisture < MINMOISTURE || moisture > MAXMOISTURE || time < MINTIME || time > MAXTIME
+        || type < MINTYPE || type > MAXTYPE) {
+        m_outOfRange++;
+    }
+}
+
+void CropFileLoader::startParser(int batchSize) {
+    stopParser(false);
+    restart();
+    m_free.clear();
+    m_full.clear();
+    for(int i = 0; i < LOADBUFFERS; i++) {
+        m_free.push_back(&m_buffers[i]);
+    }
+    m_parsed = false;
+    m_stop = false;
+    m_error = nullptr;
+    m_parser = thread(&CropFileLoader::runParser, this, batchSize);
+}
+
+void CropFileLoader::runParser(int batchSize) {
+    try {
+        while(true) {
+            vector<Crop>* batch;
+            {
+                unique_lock<mutex> lock(m_lock);
+                m_changed.wait(lock, [this]() {return m_stop || !m_free.empty();});
+                if(m_stop) {
+                    break;
+                }
+                batch = m_free.back();
+                m_free.pop_back();
+            }
+
+            batch->resize(batchSize);
+            int count = parseBatch(batch->data(), batchSize);
+            batch->resize(count);
+
+            lock_guard<mutex> lock(m_lock);
+            if(count == 0) {
+                m_free.push_back(batch);
+                break;
+            }
+            m_full.push_back(batch);
+            m_changed.notify_all();
+        }
+    } catch(...) {
+        lock_guard<mutex> lock(m_lock);
+        m_error = current_exception();
+    }
+
+    lock_guard<mutex> lock(m_lock);
+    m_parsed = true;
+    m_changed.notify_all();
+}
+
+vector<Crop>* CropFileLoader::nextBatch() {
+    unique_lock<mutex> lock(m_lock);
+    m_changed.wait(lock, [this]() {return m_parsed || !m_full.empty();});
+    if(m_full.empty()) {
+        return nullptr;
+    }
+    vector<Crop>* batch = m_full.front();
+    m_full.erase(m_full.begin()); // never more than LOADBUFFERS long
+    return batch;
+}
+
+void CropFileLoader::releaseBatch(vector<Crop>* batch) {
+    lock_guard<mutex> lock(m_lock);
+    m_free.push_back(batch);
+    m_changed.notify_all();
+}
+
+void CropFileLoader::stopParser(bool rethrow) {
+    if(!m_parser.joinable()) {
+        return;
+    }
+    {
+        lock_guard<mutex> lock(m_lock);
+        m_stop = true;
+        m_changed.notify_all();
+    }
+    m_parser.join();
+    if(rethrow && m_error) {
+        rethrow_exception(m_error);
+    }
+}
@@ -0,0 +1,108 @@
+// Date Created: November, 2022
+// Loads crops from a sensor dump file. The file is mapped into memory with
+// mmap and parsed in place, no iostreams. Two formats are read:
+// CSVFILE     one crop per line: ID,temperature,moisture,time,type. A
+//             first line that does not start with a digit is a header
+//             and skipped, \r\n line ends are fine
+// BINARYFILE  CROPRECORDSIZE byte records, the format of the run files of
+//             ExternalIQueue (encodeCrop in externalqueue.h)
+// Every record goes through the Crop constructor, so a field out of range
+// gets its default value, the same as for any other crop. Such records are
+// counted in numOutOfRange. Lines that are not five integers are skipped
+// and counted in numMalformed.
+//
+// loadInto parses on a second thread and hands batches of crops to the
+// queue's insertCrops on the calling thread, so parsing the next batch
+// overlaps with building the heap out of the last one.
+#ifndef CROPFILE_H
+#define CROPFILE_H
+#include "externalqueue.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
+enum CROPFILEFORMAT {CSVFILE, BINARYFILE};
+const int LOADBATCH = 65536;    // crops parsed before they are handed to the queue
+const int LOADBUFFERS = 3;      // batches in flight between the two threads
+
+class CropFileLoader{
+    public:
+    friend class Grader; // for grading purposes
+    friend class Tester; // for testing purposes
+
+    // Maps the file, throws runtime_error if it cannot be opened or mapped
+    CropFileLoader(const string& path, CROPFILEFORMAT format);
+    ~CropFileLoader();
+    // Appends every crop of the file to crops, returns how many
+    long long readCrops(vector<Crop>& crops);
+    // Puts every crop of the file into queue, which can be any queue with
+    // insertCrops(const Crop*, int). Returns how many. An exception from
+    // the queue or the parser stops both threads and is passed on
+    template <class Queue>
+    long long loadInto(Queue& queue, int batchSize = LOADBATCH);
+    // What the last readCrops or loadInto found
+    long long numLoaded() const;
+    long long numMalformed() const;
+    long long numOutOfRange() const;
+    long long fileSize() const;
+
+    private:
+    const char* m_data;         // the mapped file, nullptr if it is empty
+    long long m_size;           // bytes in the file
+    CROPFILEFORMAT m_format;
+    long long m_pos;            // next byte to parse
+    long long m_loaded;
+    long long m_malformed;
+    long long m_outOfRange;
+
+    // the parser thread of loadInto and the batches it shares with the caller
+    thread m_parser;
+    mutex m_lock;
+    condition_variable m_changed;
+    vector<Crop> m_buffers[LOADBUFFERS];
+    vector<vector<Crop>*> m_free;   // buffers the parser may fill
+    vector<vector<Crop>*> m_full;   // parsed batches, oldest first
+    bool m_parsed;                  // the parser is done, m_full is all there is
+    bool m_stop;                    // the caller gave up, the parser should too
+    exception_ptr m_error;          // what stopped the parser
+
+    CropFileLoader(const CropFileLoader&);            // a mapping is never copied
+    CropFileLoader& operator=(const CropFileLoader&);
+
+    void restart(); // back to the first record, counters reset
+    // Parses up to count crops into out, returns how many. 0 at the end of the file
+    int parseBatch(Crop* out, int count);
+    // false if the line [begin, end) is not five integers
+    bool parseLine(const char* begin, const char* end, Crop& crop);
+    // counts crop as out of range if a field did not survive the constructor
+    void checkRange(int ID, int temperature, int moisture, int time, int type);
+    void startParser(int batchSize);
+    void runParser(int batchSize);
+    // the next parsed batch, nullptr once every crop was handed out
+    vector<Crop>* nextBatch();
+    void releaseBatch(vector<Crop>* batch);
+    // joins the parser, rethrows its exception if rethrow is set
+    void stopParser(bool rethrow);
+};
+
+template <class Queue>
+long long CropFileLoader::loadInto(Queue& queue, int batchSize) {
+    if(batchSize < 1) {
+        throw std::domain_error("A batch needs room for at least one crop!");
+    }
+    startParser(batchSize);
+    try {
+        vector<Crop>* batch;
+        while((batch = nextBatch()) != nullptr) {
+            queue.insertCrops(batch->data(), batch->size());
+            releaseBatch(batch);
+        }
+    } catch(...) {
+        stopParser(false);
+        throw;
+    }
+    stopParser(true);
+    return m_loaded;
+}
+#endif
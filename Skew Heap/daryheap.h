@@ -0,0 +1,312 @@
+// Date Created: November, 2022
+// Implicit d-ary heap kept in two parallel vectors, one of priorities and
+// one of Crops. Sifting only reads the priority vector, so the D children
+// of a slot sit next to each other in one or two cache lines and the Crops
+// only move when a slot actually changes hands. It has the same interface
+// as BasicIQueue but merging two queues costs O(n) instead of O(log n).
+#ifndef DARYHEAP_H
+#define DARYHEAP_H
+#include "iqueue.h"
+
+template <class Priority, class Order, int D>
+class DaryIQueue{
+    public:
+    friend class Grader; // for grading purposes
+    friend class Tester; // for testing purposes
+
+    DaryIQueue(Priority priority = Priority(), Order order = Order());
+    void insertCrop(const Crop& crop);
+    // Appends count crops and restores the heap in O(n)
+    void insertCrops(const Crop* crops, int count);
+    Crop getNextCrop(); // Return the highest priority crop
+    // Priority of the crop getNextCrop would return, throws domain_error if empty
+    int getNextPriority() const;
+    // Takes the k highest priority crops out, highest first, into out (room
+    // for k crops). Returns how many there were
+    int getNextCrops(int k, Crop* out);
+    // The crops getNextCrops would take out, without changing the queue.
+    // Crops with equal priorities may come in a different order
+    int peekTopK(int k, Crop* out) const;
+    void mergeWithQueue(DaryIQueue& rhs);
+    void clear();
+    int numCrops() const; // Return number of crops in queue
+    void cropIDs(vector<int>& out) const; // Appends every crop ID, in array order
+    void printCropsQueue() const; // Print the queue in array (level) order
+    const Priority& getPriority() const;
+    const Order& getOrder() const;
+    // Set a new priority and order, rebuilds the heap in O(n)
+    void setPriority(Priority priority, Order order);
+    void dump() const; // For debugging purposes
+
+    private:
+    vector<int> m_priorities;   // m_priorities[i] is the priority of m_crops[i]
+    vector<Crop> m_crops;       // the heap, children of i are D*i+1 ... D*i+D
+    Priority m_priorFunc;       // Computes the priority of a crop
+    Order m_order;              // Decides which of two priorities goes on top
+
+    // moves the entry at index up until its parent outranks it
+    void siftUp(int index);
+    // moves the entry at index down until it outranks all its children
+    void siftDown(int index);
+    // Floyd's bottom-up build, O(n)
+    void heapify();
+    // fixes the heap after entries were appended behind the first oldSize
+    void restoreAfterAppend(int oldSize);
+};
+
+template <class Priority, class Order, int D>
+DaryIQueue<Priority, Order, D>::DaryIQueue(Priority priority, Order order) {
+    m_priorFunc = priority;
+    m_order = order;
+}
+
+template <class Priority, class Order, int D>
+void DaryIQueue<Priority, Order, D>::insertCrop(const Crop& crop) {
+    m_priorities.push_back(m_priorFunc(crop));
+    m_crops.push_back(crop);
+    siftUp(m_crops.size() - 1);
+}
+
+template <class Priority, class Order, int D>
+void DaryIQueue<Priority, Order, D>::insertCrops(const Crop* crops, int count) {
+    if(count <= 0) {
+        return;
+    }
+
+    int oldSize = m_crops.size();
+    m_priorities.resize(oldSize + count);
+    m_crops.insert(m_crops.end(), crops, crops + count);
+    computePriorities(m_priorFunc, crops, count, m_priorities.data() + oldSize);
+    restoreAfterAppend(oldSize);
+}
+
+template <class Priority, class Order, int D>
+Crop DaryIQueue<Priority, Order, D>::getNextCrop() {
+    if(m_crops.empty()) {
+        throw std::domain_error("You are attempting to get next crop from an empty heap!");
+    }
+
+    Crop nextCrop = m_crops[0];
+
+    // the last entry fills the hole at the root and sinks from there
+    m_priorities[0] = m_priorities.back();
+    m_crops[0] = m_crops.back();
+    m_priorities.pop_back();
+    m_crops.pop_back();
+    if(!m_crops.empty()) {
+        siftDown(0);
+    }
+
+    return nextCrop;
+}
+
+template <class Priority, class Order, int D>
+int DaryIQueue<Priority, Order, D>::getNextPriority() const {
+    if(m_crops.empty()) {
+        throw std::domain_error("You are attempting to look at the next crop of an empty heap!");
+    }
+    return m_priorities[0];
+}
+
+template <class Priority, class Order, int D>
+int DaryIQueue<Priority, Order, D>::getNextCrops(int k, Crop* out) {
+    int count = 0;
+    while(count < k && !m_crops.empty()) {
+        out[count++] = m_crops[0];
+        m_priorities[0] = m_priorities.back();
+        m_crops[0] = m_crops.back();
+        m_priorities.pop_back();
+        m_crops.pop_back();
+        if(!m_crops.empty()) {
+            siftDown(0);
+        }
+    }
+    return count;
+}
+
+template <class Priority, class Order, int D>
+int DaryIQueue<Priority, Order, D>::peekTopK(int k, Crop* out) const {
+    // a small heap of slot indexes over the frontier, the array is only read
+    const vector<int>& priorities = m_priorities;
+    const Order& order = m_order;
+    auto ranksBelow = [&priorities, &order](int left, int right) {
+        return !order(priorities[left], priorities[right]);
+    };
+
+    int size = m_crops.size();
+    int count = 0;
+    vector<int> frontier;
+    if(size > 0 && k > 0) {
+        frontier.push_back(0);
+    }
+    while(count < k && !frontier.empty()) {
+        pop_heap(frontier.begin(), frontier.end(), ranksBelow);
+        int index = frontier.back();
+        frontier.pop_back();
+        out[count++] = m_crops[index];
+
+        for(int child = D * index + 1; child <= D * index + D && child < size; child++) {
+            frontier.push_back(child);
+            push_heap(frontier.begin(), frontier.end(), ranksBelow);
+        }
+    }
+    return count;
+}
+
+template <class Priority, class Order, int D>
+void DaryIQueue<Priority, Order, D>::mergeWithQueue(DaryIQueue& rhs) {
+    if(this == &rhs || rhs.m_crops.empty()) {
+        return;
+    }
+
+    int oldSize = m_crops.size();
+    m_priorities.insert(m_priorities.end(), rhs.m_priorities.begin(), rhs.m_priorities.end());
+    m_crops.insert(m_crops.end(), rhs.m_crops.begin(), rhs.m_crops.end());
+    rhs.clear();
+    restoreAfterAppend(oldSize);
+}
+
+template <class Priority, class Order, int D>
+void DaryIQueue<Priority, Order, D>::clear() {
+    m_priorities.clear();
+    m_crops.clear();
+}
+
+template <class Priority, class Order, int D>
+int DaryIQueue<Priority, Order, D>::numCrops() const {
+    return m_crops.size();
+}
+
+template <class Priority, class Order, int D>
+void DaryIQueue<Priority, Order, D>::cropIDs(vector<int>& out) const {
+    for(unsigned int i = 0; i < m_crops.size(); i++) {
+        out.push_back(m_crops[i].getCropID());
+    }
+}
+
+template <class Priority, class Order, int D>
+void DaryIQueue<Priority, Order, D>::printCropsQueue() const {
+    for(unsigned int i = 0; i < m_crops.size(); i++) {
+        const Crop& crop = m_crops[i];
+        cout << "[" << m_priorities[i] << "] Crop ID:" <<  crop.getCropID() << ", current temperature: " << crop.getTemperature() << ", current soil moisture: " << crop.getMoisture() << "%, current time: " << crop.getTimeString() << ", plant type: " << crop.getTypeString() << endl;
+    }
+}
+
+template <class Priority, class Order, int D>
+const Priority& DaryIQueue<Priority, Order, D>::getPriority() const {
+    return m_priorFunc;
+}
+
+template <class Priority, class Order, int D>
+const Order& DaryIQueue<Priority, Order, D>::getOrder() const {
+    return m_order;
+}
+
+template <class Priority, class Order, int D>
+void DaryIQueue<Priority, Order, D>::setPriority(Priority priority, Order order) {
+    m_priorFunc = priority;
+    m_order = order;
+
+    computePriorities(m_priorFunc, m_crops.data(), m_crops.size(), m_priorities.data());
+    heapify();
+}
+
+template <class Priority, class Order, int D>
+void DaryIQueue<Priority, Order, D>::dump() const {
+    if (m_crops.empty()) {
+        cout << "Empty heap.\n" ;
+        return;
+    }
+
+    // one level per pair of brackets
+    unsigned int levelEnd = 1;
+    cout << "[";
+    for(unsigned int i = 0; i < m_crops.size(); i++) {
+        if(i == levelEnd) {
+            cout << "][";
+            levelEnd = levelEnd * D + 1;
+        } else if(i > 0) {
+            cout << " ";
+        }
+        cout << m_priorities[i] << ":" << m_crops[i].getCropID();
+    }
+    cout << "]" << endl;
+}
+
+template <class Priority, class Order, int D>
+void DaryIQueue<Priority, Order, D>::siftUp(int index) {
+    // carry the entry up through a hole instead of swapping at every level
+    int priority = m_priorities[index];
+    Crop crop = m_crops[index];
+
+    while(index > 0) {
+        int parent = (index - 1) / D;
+        if(m_order(m_priorities[parent], priority)) {
+            break;
+        }
+        m_priorities[index] = m_priorities[parent];
+        m_crops[index] = m_crops[parent];
+        index = parent;
+    }
+
+    m_priorities[index] = priority;
+    m_crops[index] = crop;
+}
+
+template <class Priority, class Order, int D>
+void DaryIQueue<Priority, Order, D>::siftDown(int index) {
+    int size = m_crops.size();
+    int priority = m_priorities[index];
+    Crop crop = m_crops[index];
+
+    while(true) {
+        int first = D * index + 1;
+        if(first >= size) {
+            break;
+        }
+
+        // only the priority vector is read while looking for the best child
+        int last = (first + D < size) ? first + D : size;
+        int best = first;
+        for(int child = first + 1; child < last; child++) {
+            if(!m_order(m_priorities[best], m_priorities[child])) {
+                best = child;
+            }
+        }
+
+        if(m_order(priority, m_priorities[best])) {
+            break;
+        }
+        m_priorities[index] = m_priorities[best];
+        m_crops[index] = m_crops[best];
+        index = best;
+    }
+
+    m_priorities[index] = priority;
+    m_crops[index] = crop;
+}
+
+template <class Priority, class Order, int D>
+void DaryIQueue<Priority, Order, D>::heapify() {
+    int size = m_crops.size();
+    if(size < 2) {
+        return;
+    }
+    for(int i = (size - 2) / D; i >= 0; i--) {
+        siftDown(i);
+    }
+}
+
+template <class Priority, class Order, int D>
+void DaryIQueue<Priority, Order, D>::restoreAfterAppend(int oldSize) {
+    // a few crops are cheaper to sift up one by one, many are cheaper to rebuild
+    int size = m_crops.size();
+    if(size - oldSize < oldSize / 8) {
+        for(int i = oldSize; i < size; i++) {
+            siftUp(i);
+        }
+    } else {
+        heapify();
+    }
+}
+#endif
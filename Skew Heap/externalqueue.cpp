@@ -0,0 +1,338 @@
+#include "externalqueue.h"
+#include <cstdlib>
+#include <unistd.h>
+
+ExternalIQueue::ExternalIQueue(prifn_t priFn, HEAPTYPE heapType, int memoryCrops, const string& spillDir)
+  : m_memory(priFn, heapType, DARYHEAP4)
+{
+    if(memoryCrops < RUNBLOCK) {
+        throw std::domain_error("An external queue needs room for at least one block of crops in memory!");
+    }
+    m_memoryCrops = memoryCrops;
+    m_spillDir = spillDir;
+    m_size = 0;
+    m_spilled = 0;
+    m_priorFunc = priFn;
+    m_heapType = heapType;
+    m_records.resize(RUNBLOCK * CROPRECORDSIZE);
+}
+
+ExternalIQueue::~ExternalIQueue() {
+    clear();
+}
+
+void ExternalIQueue::insertCrop(const Crop& crop) {
+    if(m_memory.numCrops() >= m_memoryCrops) {
+        spill();
+    }
+    m_memory.insertCrop(crop);
+    m_size++;
+}
+
+void ExternalIQueue::insertCrops(const Crop* crops, int count) {
+    // fill the heap up in batches, spilling in between
+    while(count > 0) {
+        if(m_memory.numCrops() >= m_memoryCrops) {
+            spill();
+        }
+        int batch = min(count, m_memoryCrops - m_memory.numCrops());
+        m_memory.insertCrops(crops, batch);
+        m_size += batch;
+        crops += batch;
+        count -= batch;
+    }
+}
+
+Crop ExternalIQueue::getNextCrop() {
+    if(m_size == 0) {
+        throw std::domain_error("You are attempting to get next crop from an empty external queue!");
+    }
+
+    // the memory heap wins ties, a run head has to be strictly better
+    if(!m_runs.empty() && (m_memory.numCrops() == 0
+        || !outranks(m_memory.getNextPriority(), m_runs[0]->m_headPriority))) {
+        Run* top = m_runs[0];
+        Crop crop = top->m_block[top->m_next];
+        m_size--;
+        advanceTopRun();
+        return crop;
+    }
+    m_size--;
+    return m_memory.getNextCrop();
+}
+
+int ExternalIQueue::getNextPriority() const {
+    if(m_size == 0) {
+        throw std::domain_error("You are attempting to look at the next crop of an empty external queue!");
+    }
+    if(m_runs.empty()) {
+        return m_memory.getNextPriority();
+    }
+    if(m_memory.numCrops() == 0) {
+        return m_runs[0]->m_headPriority;
+    }
+    int memoryPriority = m_memory.getNextPriority();
+    int runPriority = m_runs[0]->m_headPriority;
+    return outranks(memoryPriority, runPriority) ? memoryPriority : runPriority;
+}
+
+void ExternalIQueue::clear() {
+    for(unsigned int i = 0; i < m_runs.size(); i++) {
+        fclose(m_runs[i]->m_file);
+        delete m_runs[i];
+    }
+    m_runs.clear();
+    m_memory.clear();
+    m_size = 0;
+    m_spilled = 0;
+}
+
+long long ExternalIQueue::numCrops() const {
+    return m_size;
+}
+
+int ExternalIQueue::numRuns() const {
+    return m_runs.size();
+}
+
+long long ExternalIQueue::numSpilled() const {
+    return m_spilled;
+}
+
+prifn_t ExternalIQueue::getPriorityFn() const {
+    return m_priorFunc;
+}
+
+HEAPTYPE ExternalIQueue::getHeapType() const {
+    return m_heapType;
+}
+
+void ExternalIQueue::dump() const {
+    if(m_size == 0) {
+        cout << "Empty external queue.\n";
+        return;
+    }
+
+    cout << "memory: " << m_memory.numCrops() << " crops";
+    if(m_memory.numCrops() > 0) {
+        cout << ", top priority " << m_memory.getNextPriority();
+    }
+    cout << endl;
+    for(unsigned int i = 0; i < m_runs.size(); i++) {
+        cout << "run " << i << ": " << m_runs[i]->m_left << " crops, head priority "
+             << m_runs[i]->m_headPriority << endl;
+    }
+}
+
+void ExternalIQueue::spill() {
+    if(m_runs.size() >= (unsigned int)MAXRUNS) {
+        mergeRuns();
+    }
+
+    // the crops stay in memory until their run is on disk and readable
+    long long count = m_memory.numCrops();
+    vector<Crop> crops(count);
+    m_memory.peekTopK(count, crops.data());
+    FILE* file = createRunFile();
+    Run* run;
+    try {
+        for(long long i = 0; i < count; i += RUNBLOCK) {
+            writeBlock(file, crops.data() + i, (int)min((long long)RUNBLOCK, count - i));
+        }
+        run = openRun(file, count, 0);
+    } catch(...) {
+        fclose(file);
+        throw;
+    }
+    m_memory.clear();
+    m_spilled += count;
+    pushRun(m_runs, run);
+}
+
+void ExternalIQueue::mergeRuns() {
+    // merging everything each time would rewrite the biggest run over and
+    // over, so only runs of the same level meet, like the passes of a merge
+    // sort. With MAXRUNS runs and far fewer levels some level has two
+    vector<int> perLevel;
+    for(unsigned int i = 0; i < m_runs.size(); i++) {
+        if(m_runs[i]->m_level >= (int)perLevel.size()) {
+            perLevel.resize(m_runs[i]->m_level + 1, 0);
+        }
+        perLevel[m_runs[i]->m_level]++;
+    }
+    int level = 0;
+    while(perLevel[level] < 2) {
+        level++;
+    }
+    vector<int> atLevel;
+    for(unsigned int i = 0; i < m_runs.size(); i++) {
+        if(m_runs[i]->m_level == level) {
+            atLevel.push_back(i);
+        }
+    }
+
+    // the merge reads copies of the runs, the runs themselves are only
+    // released once the merged run is on disk, a failure seeks them back
+    FILE* file = createRunFile();
+    vector<Run*> merge;
+    vector<long> positions;
+    for(unsigned int i = 0; i < atLevel.size(); i++) {
+        merge.push_back(new Run(*m_runs[atLevel[i]]));
+        positions.push_back(ftell(m_runs[atLevel[i]]->m_file));
+    }
+
+    long long count = 0;
+    Run* run;
+    try {
+        vector<Crop> block(RUNBLOCK);
+        int filled = 0;
+        while(!merge.empty()) {
+            Run* top = popRun(merge);
+            block[filled++] = top->m_block[top->m_next];
+            if(advanceRun(top)) {
+                pushRun(merge, top);
+            } else {
+                delete top;
+            }
+            if(filled == RUNBLOCK) {
+                writeBlock(file, block.data(), filled);
+                count += filled;
+                filled = 0;
+            }
+        }
+        writeBlock(file, block.data(), filled);
+        count += filled;
+        run = openRun(file, count, level + 1);
+    } catch(...) {
+        fclose(file);
+        for(unsigned int i = 0; i < merge.size(); i++) {
+            delete merge[i];
+        }
+        for(unsigned int i = 0; i < atLevel.size(); i++) {
+            fseek(m_runs[atLevel[i]]->m_file, positions[i], SEEK_SET);
+        }
+        throw;
+    }
+
+    // the runs of the other levels stay, the heap is rebuilt around the gaps
+    vector<Run*> kept;
+    for(unsigned int i = 0; i < m_runs.size(); i++) {
+        if(m_runs[i]->m_level == level) {
+            fclose(m_runs[i]->m_file);
+            delete m_runs[i];
+        } else {
+            kept.push_back(m_runs[i]);
+        }
+    }
+    m_runs.swap(kept);
+    make_heap(m_runs.begin(), m_runs.end(),
+              [this](const Run* left, const Run* right) {return runBelow(left, right);});
+    m_spilled += count;
+    pushRun(m_runs, run);
+}
+
+FILE* ExternalIQueue::createRunFile() const {
+    string path = m_spillDir + "/iqueue-run-XXXXXX";
+    vector<char> name(path.begin(), path.end());
+    name.push_back('\0');
+    int fd = mkstemp(name.data());
+    if(fd < 0) {
+        throw std::runtime_error("Cannot create a run file in " + m_spillDir + "!");
+    }
+    unlink(name.data()); // the file lives on until it is closed
+    FILE* file = fdopen(fd, "w+b");
+    if(file == nullptr) {
+        close(fd);
+        throw std::runtime_error("Cannot open a run file in " + m_spillDir + "!");
+    }
+    return file;
+}
+
+void ExternalIQueue::writeBlock(FILE* file, const Crop* crops, int count) {
+    for(int i = 0; i < count; i++) {
+        encodeCrop(crops[i], &m_records[i * CROPRECORDSIZE]);
+    }
+    if(fwrite(m_records.data(), CROPRECORDSIZE, count, file) != (size_t)count) {
+        throw std::runtime_error("Cannot write a run file, is " + m_spillDir + " full?");
+    }
+}
+
+void ExternalIQueue::readBlock(Run* run) {
+    int count = (int)min((long long)RUNBLOCK, run->m_left);
+    if(fread(m_records.data(), CROPRECORDSIZE, count, run->m_file) != (size_t)count) {
+        throw std::runtime_error("A run file ended early!");
+    }
+    run->m_block.resize(count);
+    for(int i = 0; i < count; i++) {
+        run->m_block[i] = decodeCrop(&m_records[i * CROPRECORDSIZE]);
+    }
+    run->m_next = 0;
+    run->m_headPriority = m_priorFunc(run->m_block[0]);
+}
+
+ExternalIQueue::Run* ExternalIQueue::openRun(FILE* file, long long count, int level) {
+    if(fflush(file) != 0) {
+        throw std::runtime_error("Cannot write a run file, is " + m_spillDir + " full?");
+    }
+    rewind(file);
+
+    Run* run = new Run;
+    run->m_file = file;
+    run->m_left = count;
+    run->m_level = level;
+    try {
+        readBlock(run);
+    } catch(...) {
+        delete run;
+        throw;
+    }
+    return run;
+}
+
+bool ExternalIQueue::advanceRun(Run* run) {
+    run->m_left--;
+    run->m_next++;
+    if(run->m_left == 0) {
+        return false;
+    }
+    if(run->m_next == (int)run->m_block.size()) {
+        readBlock(run);
+    } else {
+        run->m_headPriority = m_priorFunc(run->m_block[run->m_next]);
+    }
+    return true;
+}
+
+void ExternalIQueue::advanceTopRun() {
+    Run* run = popRun(m_runs);
+    bool more;
+    try {
+        more = advanceRun(run);
+    } catch(...) {
+        // the rest of the run cannot be read, it is no longer counted
+        m_size -= run->m_left;
+        fclose(run->m_file);
+        delete run;
+        throw;
+    }
+    if(!more) {
+        fclose(run->m_file);
+        delete run;
+        return;
+    }
+    pushRun(m_runs, run);
+}
+
+void ExternalIQueue::pushRun(vector<Run*>& runs, Run* run) {
+    runs.push_back(run);
+    push_heap(runs.begin(), runs.end(),
+              [this](const Run* left, const Run* right) {return runBelow(left, right);});
+}
+
+ExternalIQueue::Run* ExternalIQueue::popRun(vector<Run*>& runs) {
+    pop_heap(runs.begin(), runs.end(),
+             [this](const Run* left, const Run* right) {return runBelow(left, right);});
+    Run* run = runs.back();
+    runs.pop_back();
+    return run;
+}
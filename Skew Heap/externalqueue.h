@@ -0,0 +1,123 @@
+// Date Created: November, 2022
+// A priority queue for more crops than fit in memory. At most memoryCrops
+// crops sit in an in-memory 4-ary heap. When it is full they are written
+// out, highest priority first, as a sorted run in a temporary file, and the
+// heap starts over empty. A pop compares the top of the heap with the heads
+// of the runs (kept in a small heap of their own) and takes the best one,
+// so the runs are only ever read front to back, RUNBLOCK crops at a time.
+//
+// On disk a crop is a CROPRECORDSIZE byte record: the ID as a little-endian
+// 32-bit int, then temperature, moisture, time and type one byte each.
+// Priorities are not stored, they are computed again when a crop is read.
+#ifndef EXTERNALQUEUE_H
+#define EXTERNALQUEUE_H
+#include "iqueue.h"
+#include <cstdio>
+
+const int CROPRECORDSIZE = 8;   // bytes per crop on disk
+const int RUNBLOCK = 4096;      // crops read or written per I/O call
+const int MAXRUNS = 64;         // at this many runs, runs of one level are merged into one
+
+// The binary record format, also what the crop file loader reads
+inline void encodeCrop(const Crop& crop, unsigned char* record) {
+    unsigned int id = crop.getCropID();
+    record[0] = id & 0xFF;
+    record[1] = (id >> 8) & 0xFF;
+    record[2] = (id >> 16) & 0xFF;
+    record[3] = (id >> 24) & 0xFF;
+    record[4] = crop.getTemperature();
+    record[5] = crop.getMoisture();
+    record[6] = crop.getTime();
+    record[7] = crop.getType();
+}
+// Goes through the Crop constructor, so a field out of range gets its default
+inline Crop decodeCrop(const unsigned char* record) {
+    int id = (int)(record[0] | (record[1] << 8) | (record[2] << 16) | ((unsigned int)record[3] << 24));
+    return Crop(id, record[4], record[5], record[6], record[7]);
+}
+
+class ExternalIQueue{
+    public:
+    friend class Grader; // for grading purposes
+    friend class Tester; // for testing purposes
+
+    // Run files go into spillDir and are deleted as soon as they are
+    // created, nothing is left behind if the program dies. Throws
+    // domain_error if memoryCrops is below RUNBLOCK
+    ExternalIQueue(prifn_t priFn, HEAPTYPE heapType, int memoryCrops, const string& spillDir = ".");
+    ~ExternalIQueue();
+    // Spills the in-memory heap first if it is full. Throws runtime_error
+    // if a run file cannot be created or written, the queue is then left
+    // as it was and crop is not inserted
+    void insertCrop(const Crop& crop);
+    void insertCrops(const Crop* crops, int count);
+    // Return the highest priority crop. Throws runtime_error if the next
+    // block of a run cannot be read, that crop and the rest of its run are lost
+    Crop getNextCrop();
+    // Priority of the crop getNextCrop would return, throws domain_error if empty
+    int getNextPriority() const;
+    void clear(); // closes every run file
+    long long numCrops() const; // Return number of crops in queue
+    int numRuns() const;        // runs that still hold crops
+    long long numSpilled() const; // crops written to disk since construction or clear
+    prifn_t getPriorityFn() const;
+    HEAPTYPE getHeapType() const;
+    void dump() const; // For debugging purposes
+
+    private:
+    // A sorted run in a file, read one block at a time
+    class Run{
+        public:
+        FILE* m_file;
+        vector<Crop> m_block;   // the crops read last, m_next is the head
+        int m_next;
+        long long m_left;       // crops still in the run, the head included
+        int m_headPriority;
+        int m_level;            // 0 for a spill, a merge is one above its runs
+    };
+
+    IQueue m_memory;            // the crops that have not been spilled
+    int m_memoryCrops;          // m_memory is spilled once it holds this many
+    string m_spillDir;
+    vector<Run*> m_runs;        // heap of the runs, best head on top
+    long long m_size;           // crops in memory and on disk
+    long long m_spilled;
+    prifn_t m_priorFunc;
+    HEAPTYPE m_heapType;
+    vector<unsigned char> m_records; // I/O buffer, RUNBLOCK records
+
+    ExternalIQueue(const ExternalIQueue&);            // runs are never copied
+    ExternalIQueue& operator=(const ExternalIQueue&);
+
+    // true if left belongs above right, ties go to left
+    bool outranks(int left, int right) const {
+        return (m_heapType == MAXHEAP) ? left >= right : left <= right;
+    };
+    // true if the head of run left belongs below the head of right, for the std heap algorithms
+    bool runBelow(const Run* left, const Run* right) const {
+        return !outranks(left->m_headPriority, right->m_headPriority);
+    };
+    // writes every crop of m_memory out as a new run, m_memory is only
+    // emptied once the run is written
+    void spill();
+    // k-way merges the runs of the lowest level that has more than one into
+    // a single run a level up, keeps the number of open files down. Every
+    // crop is rewritten about log_MAXRUNS(spills) times, not once per merge.
+    // The old runs are untouched if the merged run cannot be written
+    void mergeRuns();
+    FILE* createRunFile() const;
+    void writeBlock(FILE* file, const Crop* crops, int count);
+    // reads the next block of run, run->m_left has to be above 0
+    void readBlock(Run* run);
+    // rewinds a freshly written file and reads its first block, count has
+    // to be above 0. The caller still owns file if this throws
+    Run* openRun(FILE* file, long long count, int level);
+    // moves the head of run on, false once the run is empty
+    bool advanceRun(Run* run);
+    // moves the head of the top run on, drops the run when it is empty or
+    // cannot be read any more
+    void advanceTopRun();
+    void pushRun(vector<Run*>& runs, Run* run);
+    Run* popRun(vector<Run*>& runs);
+};
+#endif
@@ -0,0 +1,445 @@
+// Date Created: November, 2022
+// Double-ended priority queue (interval heap) kept in two parallel vectors
+// like DaryIQueue. Tree node n holds slots 2n and 2n+1: slot 2n is the best
+// crop of its subtree and slot 2n+1 the worst, so the best slots form one
+// binary heap and the worst slots another, upside down. Only the last node
+// may hold a single crop, which then counts for both. Both getNextCrop and
+// getLastCrop take O(log n) over one copy of the crops, for any priority
+// and order.
+#ifndef INTERVALHEAP_H
+#define INTERVALHEAP_H
+#include "iqueue.h"
+
+template <class Priority, class Order> class BoundedIQueue;
+
+template <class Priority, class Order>
+class IntervalIQueue{
+    public:
+    friend class Grader; // for grading purposes
+    friend class Tester; // for testing purposes
+    template <class P, class O> friend class BoundedIQueue;
+
+    IntervalIQueue(Priority priority = Priority(), Order order = Order());
+    void insertCrop(const Crop& crop);
+    // Appends count crops and restores the heap in O(n)
+    void insertCrops(const Crop* crops, int count);
+    Crop getNextCrop(); // Return the highest priority crop
+    // Priority of the crop getNextCrop would return, throws domain_error if empty
+    int getNextPriority() const;
+    Crop getLastCrop(); // Return the lowest priority crop
+    // Takes the k highest priority crops out, highest first, into out (room
+    // for k crops). Returns how many there were
+    int getNextCrops(int k, Crop* out);
+    // The crops getNextCrops would take out, without changing the queue.
+    // Crops with equal priorities may come in a different order
+    int peekTopK(int k, Crop* out) const;
+    void mergeWithQueue(IntervalIQueue& rhs);
+    void clear();
+    // Makes room for count crops, nothing allocates until there are more
+    void reserve(int count);
+    int numCrops() const; // Return number of crops in queue
+    void cropIDs(vector<int>& out) const; // Appends every crop ID, in array order
+    void printCropsQueue() const; // Print the queue in array (level) order
+    const Priority& getPriority() const;
+    const Order& getOrder() const;
+    // Set a new priority and order, rebuilds the heap in O(n)
+    void setPriority(Priority priority, Order order);
+    void dump() const; // For debugging purposes
+
+    private:
+    vector<int> m_priorities;   // m_priorities[i] is the priority of m_crops[i]
+    vector<Crop> m_crops;       // slots 2n and 2n+1 belong to tree node n
+    Priority m_priorFunc;       // Computes the priority of a crop
+    Order m_order;              // Decides which of two priorities goes on top
+
+    // true if left strictly outranks right
+    bool beats(int left, int right) const {return !m_order(right, left);}
+    void moveSlot(int from, int to) {
+        m_priorities[to] = m_priorities[from];
+        m_crops[to] = m_crops[from];
+    }
+    // carry the crop of slot up through the best / worst slots of its ancestors
+    void bubbleUpBest(int slot);
+    void bubbleUpWorst(int slot);
+    // carry the crop of slot down through the best / worst slots below it
+    void trickleDownBest(int slot);
+    void trickleDownWorst(int slot);
+    // restores the heap after the crop in slot (the last one) went in
+    void placeLast(int slot);
+    // bottom-up build, O(n)
+    void heapify();
+    // fixes the heap after crops were appended behind the first oldSize
+    void restoreAfterAppend(int oldSize);
+    // removes slot, which must be 0 or 1, and refills it from the back
+    Crop takeSlot(int slot);
+};
+
+template <class Priority, class Order>
+IntervalIQueue<Priority, Order>::IntervalIQueue(Priority priority, Order order) {
+    m_priorFunc = priority;
+    m_order = order;
+}
+
+template <class Priority, class Order>
+void IntervalIQueue<Priority, Order>::insertCrop(const Crop& crop) {
+    m_priorities.push_back(m_priorFunc(crop));
+    m_crops.push_back(crop);
+    placeLast(m_crops.size() - 1);
+}
+
+template <class Priority, class Order>
+void IntervalIQueue<Priority, Order>::insertCrops(const Crop* crops, int count) {
+    if(count <= 0) {
+        return;
+    }
+
+    int oldSize = m_crops.size();
+    m_priorities.resize(oldSize + count);
+    m_crops.insert(m_crops.end(), crops, crops + count);
+    computePriorities(m_priorFunc, crops, count, m_priorities.data() + oldSize);
+    restoreAfterAppend(oldSize);
+}
+
+template <class Priority, class Order>
+Crop IntervalIQueue<Priority, Order>::getNextCrop() {
+    if(m_crops.empty()) {
+        throw std::domain_error("You are attempting to get next crop from an empty heap!");
+    }
+    return takeSlot(0);
+}
+
+template <class Priority, class Order>
+int IntervalIQueue<Priority, Order>::getNextPriority() const {
+    if(m_crops.empty()) {
+        throw std::domain_error("You are attempting to look at the next crop of an empty heap!");
+    }
+    return m_priorities[0];
+}
+
+template <class Priority, class Order>
+Crop IntervalIQueue<Priority, Order>::getLastCrop() {
+    if(m_crops.empty()) {
+        throw std::domain_error("You are attempting to get last crop from an empty heap!");
+    }
+    // a single crop is the best and the worst one
+    return takeSlot(m_crops.size() == 1 ? 0 : 1);
+}
+
+template <class Priority, class Order>
+int IntervalIQueue<Priority, Order>::getNextCrops(int k, Crop* out) {
+    int count = 0;
+    while(count < k && !m_crops.empty()) {
+        out[count++] = takeSlot(0);
+    }
+    return count;
+}
+
+template <class Priority, class Order>
+int IntervalIQueue<Priority, Order>::peekTopK(int k, Crop* out) const {
+    // a small heap of slots over the frontier: taking a node's best slot
+    // opens its worst slot and the best slots of its children
+    const vector<int>& priorities = m_priorities;
+    const Order& order = m_order;
+    auto ranksBelow = [&priorities, &order](int left, int right) {
+        return !order(priorities[left], priorities[right]);
+    };
+
+    int size = m_crops.size();
+    int count = 0;
+    vector<int> frontier;
+    if(size > 0 && k > 0) {
+        frontier.push_back(0);
+    }
+    while(count < k && !frontier.empty()) {
+        pop_heap(frontier.begin(), frontier.end(), ranksBelow);
+        int slot = frontier.back();
+        frontier.pop_back();
+        out[count++] = m_crops[slot];
+        if(slot % 2 == 1) {
+            continue;
+        }
+
+        int node = slot / 2;
+        int opened[3] = {slot + 1, 2 * (2 * node + 1), 2 * (2 * node + 2)};
+        for(int i = 0; i < 3; i++) {
+            if(opened[i] < size) {
+                frontier.push_back(opened[i]);
+                push_heap(frontier.begin(), frontier.end(), ranksBelow);
+            }
+        }
+    }
+    return count;
+}
+
+template <class Priority, class Order>
+void IntervalIQueue<Priority, Order>::mergeWithQueue(IntervalIQueue& rhs) {
+    if(this == &rhs || rhs.m_crops.empty()) {
+        return;
+    }
+
+    int oldSize = m_crops.size();
+    m_priorities.insert(m_priorities.end(), rhs.m_priorities.begin(), rhs.m_priorities.end());
+    m_crops.insert(m_crops.end(), rhs.m_crops.begin(), rhs.m_crops.end());
+    rhs.clear();
+    restoreAfterAppend(oldSize);
+}
+
+template <class Priority, class Order>
+void IntervalIQueue<Priority, Order>::clear() {
+    m_priorities.clear();
+    m_crops.clear();
+}
+
+template <class Priority, class Order>
+void IntervalIQueue<Priority, Order>::reserve(int count) {
+    m_priorities.reserve(count);
+    m_crops.reserve(count);
+}
+
+template <class Priority, class Order>
+int IntervalIQueue<Priority, Order>::numCrops() const {
+    return m_crops.size();
+}
+
+template <class Priority, class Order>
+void IntervalIQueue<Priority, Order>::cropIDs(vector<int>& out) const {
+    for(unsigned int i = 0; i < m_crops.size(); i++) {
+        out.push_back(m_crops[i].getCropID());
+    }
+}
+
+template <class Priority, class Order>
+void IntervalIQueue<Priority, Order>::printCropsQueue() const {
+    for(unsigned int i = 0; i < m_crops.size(); i++) {
+        const Crop& crop = m_crops[i];
+        cout << "[" << m_priorities[i] << "] Crop ID:" <<  crop.getCropID() << ", current temperature: " << crop.getTemperature() << ", current soil moisture: " << crop.getMoisture() << "%, current time: " << crop.getTimeString() << ", plant type: " << crop.getTypeString() << endl;
+    }
+}
+
+template <class Priority, class Order>
+const Priority& IntervalIQueue<Priority, Order>::getPriority() const {
+    return m_priorFunc;
+}
+
+template <class Priority, class Order>
+const Order& IntervalIQueue<Priority, Order>::getOrder() const {
+    return m_order;
+}
+
+template <class Priority, class Order>
+void IntervalIQueue<Priority, Order>::setPriority(Priority priority, Order order) {
+    m_priorFunc = priority;
+    m_order = order;
+    computePriorities(m_priorFunc, m_crops.data(), m_crops.size(), m_priorities.data());
+    heapify();
+}
+
+template <class Priority, class Order>
+void IntervalIQueue<Priority, Order>::dump() const {
+    if (m_crops.empty()) {
+        cout << "Empty heap.\n" ;
+        return;
+    }
+
+    // one level per pair of brackets, each node as best..worst
+    unsigned int levelEnd = 1;
+    cout << "[";
+    for(unsigned int node = 0; 2 * node < m_crops.size(); node++) {
+        if(node == levelEnd) {
+            cout << "][";
+            levelEnd = levelEnd * 2 + 1;
+        } else if(node > 0) {
+            cout << " ";
+        }
+        cout << m_priorities[2 * node] << ":" << m_crops[2 * node].getCropID();
+        if(2 * node + 1 < m_crops.size()) {
+            cout << ".." << m_priorities[2 * node + 1] << ":" << m_crops[2 * node + 1].getCropID();
+        }
+    }
+    cout << "]" << endl;
+}
+
+template <class Priority, class Order>
+void IntervalIQueue<Priority, Order>::bubbleUpBest(int slot) {
+    int priority = m_priorities[slot];
+    Crop crop = m_crops[slot];
+
+    while(slot > 1) {
+        int parent = 2 * ((slot / 2 - 1) / 2);
+        if(!beats(priority, m_priorities[parent])) {
+            break;
+        }
+        moveSlot(parent, slot);
+        slot = parent;
+    }
+
+    m_priorities[slot] = priority;
+    m_crops[slot] = crop;
+}
+
+template <class Priority, class Order>
+void IntervalIQueue<Priority, Order>::bubbleUpWorst(int slot) {
+    int priority = m_priorities[slot];
+    Crop crop = m_crops[slot];
+
+    while(slot > 1) {
+        int parent = 2 * ((slot / 2 - 1) / 2) + 1;
+        if(!beats(m_priorities[parent], priority)) {
+            break;
+        }
+        moveSlot(parent, slot);
+        slot = parent;
+    }
+
+    m_priorities[slot] = priority;
+    m_crops[slot] = crop;
+}
+
+template <class Priority, class Order>
+void IntervalIQueue<Priority, Order>::trickleDownBest(int slot) {
+    int size = m_crops.size();
+    int priority = m_priorities[slot];
+    Crop crop = m_crops[slot];
+
+    while(true) {
+        // the best slots of the two child nodes
+        int node = slot / 2;
+        int first = 2 * (2 * node + 1);
+        if(first >= size) {
+            break;
+        }
+        int best = first;
+        if(first + 2 < size && beats(m_priorities[first + 2], m_priorities[first])) {
+            best = first + 2;
+        }
+        if(!beats(m_priorities[best], priority)) {
+            break;
+        }
+        moveSlot(best, slot);
+        slot = best;
+
+        // the crop we carry may now be worse than the worst of its new node
+        if(slot + 1 < size && beats(m_priorities[slot + 1], priority)) {
+            swap(priority, m_priorities[slot + 1]);
+            swap(crop, m_crops[slot + 1]);
+        }
+    }
+
+    m_priorities[slot] = priority;
+    m_crops[slot] = crop;
+}
+
+template <class Priority, class Order>
+void IntervalIQueue<Priority, Order>::trickleDownWorst(int slot) {
+    int size = m_crops.size();
+    int priority = m_priorities[slot];
+    Crop crop = m_crops[slot];
+
+    while(true) {
+        // the worst slots of the two child nodes, a single crop node only has its best slot
+        int node = slot / 2;
+        int worst = -1;
+        for(int child = 2 * node + 1; child <= 2 * node + 2 && 2 * child < size; child++) {
+            int candidate = (2 * child + 1 < size) ? 2 * child + 1 : 2 * child;
+            if(worst == -1 || beats(m_priorities[worst], m_priorities[candidate])) {
+                worst = candidate;
+            }
+        }
+        if(worst == -1 || !beats(priority, m_priorities[worst])) {
+            break;
+        }
+        moveSlot(worst, slot);
+        slot = worst;
+        if(slot % 2 == 0) {
+            break; // the single crop of the last node
+        }
+
+        // the crop we carry may now be better than the best of its new node
+        if(beats(priority, m_priorities[slot - 1])) {
+            swap(priority, m_priorities[slot - 1]);
+            swap(crop, m_crops[slot - 1]);
+        }
+    }
+
+    m_priorities[slot] = priority;
+    m_crops[slot] = crop;
+}
+
+template <class Priority, class Order>
+void IntervalIQueue<Priority, Order>::placeLast(int slot) {
+    if(slot % 2 == 1) {
+        // second crop of its node, it goes to whichever end it belongs to
+        if(beats(m_priorities[slot], m_priorities[slot - 1])) {
+            swap(m_priorities[slot], m_priorities[slot - 1]);
+            swap(m_crops[slot], m_crops[slot - 1]);
+            bubbleUpBest(slot - 1);
+        } else {
+            bubbleUpWorst(slot);
+        }
+        return;
+    }
+
+    // alone in a new node, compared against both ends of the parent
+    if(slot == 0) {
+        return;
+    }
+    int parent = 2 * ((slot / 2 - 1) / 2);
+    if(beats(m_priorities[slot], m_priorities[parent])) {
+        bubbleUpBest(slot);
+    } else if(beats(m_priorities[parent + 1], m_priorities[slot])) {
+        bubbleUpWorst(slot);
+    }
+}
+
+template <class Priority, class Order>
+void IntervalIQueue<Priority, Order>::heapify() {
+    int size = m_crops.size();
+    for(int node = (size - 1) / 2; node >= 0; node--) {
+        int best = 2 * node;
+        if(best + 1 < size && beats(m_priorities[best + 1], m_priorities[best])) {
+            swap(m_priorities[best], m_priorities[best + 1]);
+            swap(m_crops[best], m_crops[best + 1]);
+        }
+        trickleDownBest(best);
+        if(best + 1 < size) {
+            trickleDownWorst(best + 1);
+        }
+    }
+}
+
+template <class Priority, class Order>
+void IntervalIQueue<Priority, Order>::restoreAfterAppend(int oldSize) {
+    // a few crops are cheaper to place one by one, many are cheaper to rebuild
+    int size = m_crops.size();
+    if(size - oldSize < oldSize / 8) {
+        for(int i = oldSize; i < size; i++) {
+            placeLast(i);
+        }
+    } else {
+        heapify();
+    }
+}
+
+template <class Priority, class Order>
+Crop IntervalIQueue<Priority, Order>::takeSlot(int slot) {
+    Crop taken = m_crops[slot];
+
+    // the last crop fills the hole and sinks from there
+    m_priorities[slot] = m_priorities.back();
+    m_crops[slot] = m_crops.back();
+    m_priorities.pop_back();
+    m_crops.pop_back();
+    if(slot >= (int)m_crops.size()) {
+        return taken;
+    }
+
+    // the crop from the back is no better than the best and no worse than
+    // the worst, so it only has to sink on the side it was put in
+    if(slot == 0) {
+        trickleDownBest(0);
+    } else {
+        trickleDownWorst(1);
+    }
+    return taken;
+}
+#endif
@@ -1,66 +1,269 @@
-
 #include "iqueue.h"
-IQueue::IQueue(prifn_t priFn, HEAPTYPE heapType)
+#include "daryheap.h"
+#include "bucketqueue.h"
+#include "intervalheap.h"
+#include "linearpriority.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <unordered_set>
+#include <exception>
+
+// What IQueue needs from an engine other than the skew heap. Only a
+// BUCKETQUEUE throws out_of_range, when a priority does not fit its range
+class QueueEngine{
+    public:
+    virtual ~QueueEngine() {}
+    virtual QueueEngine* clone() const = 0;
+    virtual void insertCrop(const Crop& crop) = 0;
+    virtual void insertCrops(const Crop* crops, int count) = 0;
+    virtual Crop getNextCrop() = 0;
+    virtual int getNextPriority() const = 0;
+    // only an INTERVALHEAP has one, IQueue checks before it calls
+    virtual Crop getLastCrop() = 0;
+    virtual int getNextCrops(int k, Crop* out) = 0;
+    virtual int peekTopK(int k, Crop* out) const = 0;
+    // rhs is always an engine of the same type
+    virtual void mergeWithEngine(QueueEngine& rhs) = 0;
+    virtual void clear() = 0;
+    virtual int numCrops() const = 0;
+    virtual void cropIDs(vector<int>& out) const = 0;
+    virtual void printCropsQueue() const = 0;
+    virtual void setPriorityFn(const FnPriority& priority, HEAPTYPE heapType) = 0;
+    virtual void dump() const = 0;
+};
+
+// The lowest priority crop of a queue, only a double-ended one can tell
+template <class Queue>
+Crop takeLastCrop(Queue&) {
+    throw std::domain_error("You attempted to get the last crop of a queue that is not an interval heap!");
+}
+template <class Priority, class Order>
+Crop takeLastCrop(IntervalIQueue<Priority, Order>& queue) {
+    return queue.getLastCrop();
+}
+
+// Runs any queue with the BasicIQueue interface as an engine
+template <class Queue>
+class EngineAdapter : public QueueEngine{
+    public:
+    EngineAdapter(const Queue& queue) : m_queue(queue) {}
+    QueueEngine* clone() const {return new EngineAdapter(*this);}
+    void insertCrop(const Crop& crop) {m_queue.insertCrop(crop);}
+    void insertCrops(const Crop* crops, int count) {m_queue.insertCrops(crops, count);}
+    Crop getNextCrop() {return m_queue.getNextCrop();}
+    int getNextPriority() const {return m_queue.getNextPriority();}
+    Crop getLastCrop() {return takeLastCrop(m_queue);}
+    int getNextCrops(int k, Crop* out) {return m_queue.getNextCrops(k, out);}
+    int peekTopK(int k, Crop* out) const {return m_queue.peekTopK(k, out);}
+    void mergeWithEngine(QueueEngine& rhs) {m_queue.mergeWithQueue(static_cast<EngineAdapter&>(rhs).m_queue);}
+    void clear() {m_queue.clear();}
+    int numCrops() const {return m_queue.numCrops();}
+    void cropIDs(vector<int>& out) const {m_queue.cropIDs(out);}
+    void printCropsQueue() const {m_queue.printCropsQueue();}
+    void setPriorityFn(const FnPriority& priority, HEAPTYPE heapType) {m_queue.setPriority(priority, HeapOrder(heapType));}
+    void dump() const {m_queue.dump();}
+    private:
+    Queue m_queue;
+};
+
+FnPriority::FnPriority(prifn_t priFn, const LinearPriority& linear)
+  : m_linear(make_shared<LinearPriority>(linear))
 {
-    m_heap = nullptr; 
-    m_size = 0; 
-    m_priorFunc = priFn; 
-    m_heapType = heapType;  
+  m_priorFunc = priFn;
+  if(priFn == nullptr) {
+    throw invalid_argument("A linear priority needs the function it stands for!");
+  }
+  // every corner of the field ranges, a linear form is fixed by a handful of
+  // them, so a function that agrees on all of them is almost surely the same
+  for(int corner = 0; corner < 16; corner++) {
+    Crop probe(MINCROPID, (corner & 1) ? MAXTEMP : MINTEMP, (corner & 2) ? MAXMOISTURE : MINMOISTURE,
+               (corner & 4) ? MAXTIME : MINTIME, (corner & 8) ? MAXTYPE : MINTYPE);
+    if(priFn(probe) != linear(probe)) {
+      throw invalid_argument("The linear priority does not match its function!");
+    }
+  }
 }
 
-IQueue::~IQueue() {
-  clear();
+void computePriorities(const FnPriority& priority, const Crop* crops, int count, int* out) {
+  if(priority.getLinear() != nullptr) {
+    computePriorities(*priority.getLinear(), crops, count, out);
+    return;
+  }
+  for(int i = 0; i < count; i++) {
+    out[i] = priority(crops[i]);
+  }
 }
 
-IQueue::IQueue(const IQueue& rhs) {
-  m_heap = nullptr; 
-  m_size = 0;
-  m_priorFunc = rhs.m_priorFunc;
-  m_heapType = rhs.m_heapType;
+typedef DaryIQueue<FnPriority, HeapOrder, 4> Dary4Queue;
+typedef DaryIQueue<FnPriority, HeapOrder, 8> Dary8Queue;
+typedef BucketIQueue<FnPriority, HeapOrder> BucketQueue;
+typedef IntervalIQueue<FnPriority, HeapOrder> IntervalQueue;
 
-  m_heap = copyRecursive(rhs.m_heap);
+IQueue::IQueue(prifn_t priFn, HEAPTYPE heapType, ENGINE engine)
+  : BasicIQueue<FnPriority, HeapOrder>(FnPriority(priFn), HeapOrder(heapType))
+{
+  if(engine == BUCKETQUEUE) {
+    throw std::domain_error("A bucket queue needs a priority range, use the constructor that takes minPriority and maxPriority!");
+  }
+  m_engine = nullptr;
+  m_engineType = SKEWHEAP;
+  if(engine == DARYHEAP4) {
+    m_engine = new EngineAdapter<Dary4Queue>(Dary4Queue(FnPriority(priFn), HeapOrder(heapType)));
+    m_engineType = DARYHEAP4;
+  } else if(engine == DARYHEAP8) {
+    m_engine = new EngineAdapter<Dary8Queue>(Dary8Queue(FnPriority(priFn), HeapOrder(heapType)));
+    m_engineType = DARYHEAP8;
+  } else if(engine == INTERVALHEAP) {
+    m_engine = new EngineAdapter<IntervalQueue>(IntervalQueue(FnPriority(priFn), HeapOrder(heapType)));
+    m_engineType = INTERVALHEAP;
+  }
+}
+
+IQueue::IQueue(prifn_t priFn, HEAPTYPE heapType, int minPriority, int maxPriority)
+  : BasicIQueue<FnPriority, HeapOrder>(FnPriority(priFn), HeapOrder(heapType))
+{
+  m_engine = nullptr;
+  m_engineType = SKEWHEAP;
+  if(minPriority <= maxPriority && (long long)maxPriority - minPriority + 1 <= MAXBUCKETS) {
+    m_engine = new EngineAdapter<BucketQueue>(BucketQueue(minPriority, maxPriority, FnPriority(priFn), HeapOrder(heapType)));
+    m_engineType = BUCKETQUEUE;
+  }
+}
+
+IQueue::IQueue(prifn_t priFn, HEAPTYPE heapType, const vector<Crop>& crops, ENGINE engine)
+  : IQueue(priFn, heapType, engine)
+{
+  insertCrops(crops.data(), crops.size());
+}
+
+IQueue::~IQueue() {
+  delete m_engine;
+}
+
+IQueue::IQueue(const IQueue& rhs) : BasicIQueue<FnPriority, HeapOrder>(rhs) {
+  m_engineType = rhs.m_engineType;
+  m_engine = (rhs.m_engine == nullptr) ? nullptr : rhs.m_engine->clone();
 }
 
 IQueue& IQueue::operator=(const IQueue& rhs) {
+  if(this == &rhs) {
+    return *this;
+  }
 
-  clear();
+  // copy first, so a failed allocation leaves this queue as it was
+  IQueue copy(rhs);
+  swap(copy);
 
+  return *this;
+}
+
+IQueue::IQueue(IQueue&& rhs) : BasicIQueue<FnPriority, HeapOrder>(std::move(rhs)) {
+  m_engineType = rhs.m_engineType;
+  m_engine = rhs.m_engine;
+  rhs.m_engineType = SKEWHEAP; // the skew heap part of rhs is already empty
+  rhs.m_engine = nullptr;
+}
+
+IQueue& IQueue::operator=(IQueue&& rhs) {
   if(this == &rhs) {
     return *this;
   }
 
-  m_heap = rhs.m_heap;
-  m_size = rhs.m_size;
-  m_priorFunc = rhs.m_priorFunc;
-  m_heapType = rhs.m_heapType;
+  clear();
+  swap(rhs);
 
   return *this;
 }
 
-void IQueue::insertCrop(const Crop& crop) {
-    Node* newNode = new Node(crop);
+void IQueue::swap(IQueue& rhs) {
+  BasicIQueue<FnPriority, HeapOrder>::swap(rhs);
+  std::swap(m_engineType, rhs.m_engineType);
+  std::swap(m_engine, rhs.m_engine);
+}
 
-    m_heap = merge(m_heap, newNode);
-    m_size++;
+CropHandle IQueue::insertCrop(const Crop& crop) {
+  if(m_engine != nullptr) {
+    try {
+      m_engine->insertCrop(crop);
+      return nullptr;
+    } catch(std::out_of_range&) {
+      fallBackToSkewHeap();
+    }
+  }
+  return BasicIQueue<FnPriority, HeapOrder>::insertCrop(crop);
+}
+
+void IQueue::insertCrops(const Crop* crops, int count) {
+  if(m_engine != nullptr) {
+    try {
+      m_engine->insertCrops(crops, count);
+      return;
+    } catch(std::out_of_range&) {
+      fallBackToSkewHeap();
+    }
+  }
+  BasicIQueue<FnPriority, HeapOrder>::insertCrops(crops, count);
 }
 
 Crop IQueue::getNextCrop() {
-  
-  if(m_heap == nullptr) {
-    throw std::domain_error("You are attempting to get next crop from an empty skew-heap!");
+  if(m_engine != nullptr) {
+    return m_engine->getNextCrop();
+  }
+  return BasicIQueue<FnPriority, HeapOrder>::getNextCrop();
+}
+
+int IQueue::getNextPriority() const {
+  if(m_engine != nullptr) {
+    return m_engine->getNextPriority();
+  }
+  return BasicIQueue<FnPriority, HeapOrder>::getNextPriority();
+}
+
+Crop IQueue::getLastCrop() {
+  if(m_engineType != INTERVALHEAP) {
+    throw std::domain_error("You attempted to get the last crop of a queue that is not an interval heap!");
   }
+  return m_engine->getLastCrop();
+}
 
-  Node* oldNode = m_heap;
-  Crop nextCrop = oldNode->getCrop();
+int IQueue::getNextCrops(int k, Crop* out) {
+  if(m_engine != nullptr) {
+    return m_engine->getNextCrops(k, out);
+  }
+  return BasicIQueue<FnPriority, HeapOrder>::getNextCrops(k, out);
+}
 
-  m_heap = merge(m_heap->m_left, m_heap->m_right);
+int IQueue::peekTopK(int k, Crop* out) const {
+  if(m_engine != nullptr) {
+    return m_engine->peekTopK(k, out);
+  }
+  return BasicIQueue<FnPriority, HeapOrder>::peekTopK(k, out);
+}
 
+void IQueue::updateCrop(CropHandle handle, const Crop& crop) {
+  requireSkewHeap();
+  BasicIQueue<FnPriority, HeapOrder>::updateCrop(handle, crop);
+}
 
-  delete oldNode;
-  oldNode = nullptr;
-  m_size--;
+Crop IQueue::removeCrop(CropHandle handle) {
+  requireSkewHeap();
+  return BasicIQueue<FnPriority, HeapOrder>::removeCrop(handle);
+}
+
+void IQueue::enableCropIndex() {
+  requireSkewHeap();
+  BasicIQueue<FnPriority, HeapOrder>::enableCropIndex();
+}
 
-  return nextCrop;
+bool IQueue::updateCrop(int cropID, const Crop& crop) {
+  requireSkewHeap();
+  return BasicIQueue<FnPriority, HeapOrder>::updateCrop(cropID, crop);
+}
+
+bool IQueue::removeCrop(int cropID) {
+  requireSkewHeap();
+  return BasicIQueue<FnPriority, HeapOrder>::removeCrop(cropID);
 }
 
 void IQueue::mergeWithQueue(IQueue& rhs) {
@@ -72,93 +275,318 @@ void IQueue::mergeWithQueue(IQueue& rhs) {
     return;
   }
 
-  
+  if(m_engine != nullptr && m_engineType == rhs.m_engineType) {
+    try {
+      m_engine->mergeWithEngine(*rhs.m_engine);
+      return;
+    } catch(std::out_of_range&) {
+      fallBackToSkewHeap();
+    }
+  }
 
-  m_heap = merge(m_heap, rhs.m_heap);
-  rhs.m_heap = nullptr;
+  if(m_engineType != rhs.m_engineType) {
+    // different engines, the crops have to move one by one
+    while(rhs.numCrops() > 0) {
+      insertCrop(rhs.getNextCrop());
+    }
+  } else {
+    BasicIQueue<FnPriority, HeapOrder>::mergeWithQueue(rhs);
+  }
 }
 
-void IQueue::clear() {
-  clearRecursive(m_heap);
+void IQueue::mergeAll(IQueue* const* queues, int count, int numThreads) {
+  // we are the root of the tree, every queue shows up once and the rest
+  // keep the order the caller gave them
+  vector<IQueue*> level(1, this);
+  unordered_set<IQueue*> seen(level.begin(), level.end());
+  for(int i = 0; i < count; i++) {
+    if(queues[i] == nullptr || !seen.insert(queues[i]).second) {
+      continue;
+    }
+    if(getPriorityFn() != queues[i]->getPriorityFn()) {
+      throw std::domain_error("You attempted to merge queues with different priority functions!!");
+    }
+    level.push_back(queues[i]);
+  }
 
-  m_heap = nullptr;
-  m_size = 0;
-  m_priorFunc = nullptr;
+  // an array heap pays O(n) per merge however the pairs are chosen, appended
+  // to one growing heap the crops are mostly sifted up instead of rebuilt.
+  // Only a skew heap has an index and it is never the receiver here
+  if(m_engineType == DARYHEAP4 || m_engineType == DARYHEAP8 || m_engineType == INTERVALHEAP) {
+    for(unsigned int i = 1; i < level.size(); i++) {
+      mergeWithQueue(*level[i]);
+    }
+    return;
+  }
+  checkMergeIDs(level);
+
+  // each round merges queue i + stride into queue i, the pairs don't share a queue
+  int size = level.size();
+  int workers = min(max(numThreads, 1), size / 2);
+  if(workers <= 1) {
+    for(int stride = 1; stride < size; stride *= 2) {
+      for(int i = 0; i + stride < size; i += 2 * stride) {
+        level[i]->mergeWithQueue(*level[i + stride]);
+      }
+    }
+    return;
+  }
 
-  
+  // the same threads run every round, worker t takes pairs t, t + workers, ...
+  // and waits for the others before the next round reads what they merged
+  mutex lock;
+  condition_variable roundDone;
+  int waiting = 0;
+  int round = 0;
+  bool failed = false;
+  vector<exception_ptr> errors(workers);
+  auto work = [&](int t) {
+    for(int stride = 1; stride < size; stride *= 2) {
+      try {
+        for(int i = 2 * stride * t; i + stride < size; i += 2 * stride * workers) {
+          level[i]->mergeWithQueue(*level[i + stride]);
+        }
+      } catch(...) {
+        errors[t] = current_exception();
+      }
+
+      unique_lock<mutex> guard(lock);
+      failed = failed || errors[t] != nullptr;
+      int current = round;
+      if(++waiting == workers) {
+        waiting = 0;
+        round++;
+        roundDone.notify_all();
+      } else {
+        roundDone.wait(guard, [&round, current]() {return round != current;});
+      }
+      if(failed) {
+        return;
+      }
+    }
+  };
+  vector<thread> threads;
+  for(int t = 1; t < workers; t++) {
+    threads.push_back(thread(work, t));
+  }
+  work(0);
+  for(unsigned int t = 0; t < threads.size(); t++) {
+    threads[t].join();
+  }
+  for(int t = 0; t < workers; t++) {
+    if(errors[t] != nullptr) {
+      rethrow_exception(errors[t]);
+    }
+  }
 }
 
-int IQueue::numCrops() const
-{
-  return m_size;
+void IQueue::checkMergeIDs(const vector<IQueue*>& level) {
+  bool indexed = false;
+  for(unsigned int i = 0; i < level.size(); i++) {
+    indexed = indexed || level[i]->hasCropIndex();
+  }
+  if(!indexed) {
+    return;
+  }
+
+  // the rounds of mergeAll played on the crop IDs alone
+  int size = level.size();
+  vector<vector<int> > ids(size);
+  for(int i = 0; i < size; i++) {
+    ids[i].reserve(level[i]->numCrops());
+    level[i]->cropIDs(ids[i]);
+  }
+  for(int stride = 1; stride < size; stride *= 2) {
+    for(int i = 0; i + stride < size; i += 2 * stride) {
+      vector<int>& receiver = ids[i];
+      vector<int>& sender = ids[i + stride];
+      if(level[i]->hasCropIndex()) {
+        unordered_set<int> held(receiver.begin(), receiver.end());
+        for(unsigned int c = 0; c < sender.size(); c++) {
+          if(!held.insert(sender[c]).second) {
+            throw std::domain_error("You attempted to merge two crops with the same ID into an indexed queue!");
+          }
+        }
+      }
+      receiver.insert(receiver.end(), sender.begin(), sender.end());
+      vector<int>().swap(sender);
+    }
+  }
+}
+
+void IQueue::cropIDs(vector<int>& out) const {
+  if(m_engine != nullptr) {
+    m_engine->cropIDs(out);
+    return;
+  }
+  BasicIQueue<FnPriority, HeapOrder>::cropIDs(out);
+}
+
+void IQueue::clear() {
+  if(m_engine != nullptr) {
+    m_engine->clear();
+  }
+  BasicIQueue<FnPriority, HeapOrder>::clear();
+}
+
+int IQueue::numCrops() const {
+  if(m_engine != nullptr) {
+    return m_engine->numCrops();
+  }
+  return BasicIQueue<FnPriority, HeapOrder>::numCrops();
 }
 
 void IQueue::printCropsQueue() const {
-  printPreOrder(m_heap);  
+  if(m_engine != nullptr) {
+    m_engine->printCropsQueue();
+  } else {
+    BasicIQueue<FnPriority, HeapOrder>::printCropsQueue();
+  }
 }
 
 prifn_t IQueue::getPriorityFn() const {
-  return m_priorFunc;
+  return getPriority().getFn();
 }
 
 HEAPTYPE IQueue::getHeapType() const {
-  return m_heapType;
+  return getOrder().getHeapType();
+}
+
+ENGINE IQueue::getEngine() const {
+  return m_engineType;
 }
 
 void IQueue::setPriorityFn(prifn_t priFn, HEAPTYPE heapType) {
-  IQueue oldIQueue(*this);
+  applyPriority(FnPriority(priFn), heapType);
+}
 
-  clear();
-  m_heap = nullptr;
-  m_priorFunc = priFn;
-  m_heapType = heapType;
+void IQueue::setPriorityFn(prifn_t priFn, HEAPTYPE heapType, const LinearPriority& linear) {
+  applyPriority(FnPriority(priFn, linear), heapType);
+}
 
+void IQueue::applyPriority(const FnPriority& priority, HEAPTYPE heapType) {
+  // the base keeps the function and heap type even when it holds no crops
+  BasicIQueue<FnPriority, HeapOrder>::setPriority(priority, HeapOrder(heapType));
+  if(m_engine != nullptr) {
+    try {
+      m_engine->setPriorityFn(priority, heapType);
+    } catch(std::out_of_range&) {
+      fallBackToSkewHeap(); // the crops get their new priorities on the way
+    }
+  }
+}
 
-  while(oldIQueue.m_heap != nullptr) {
-    Crop currCrop = oldIQueue.getNextCrop();
+void IQueue::dump() const {
+  if(m_engine != nullptr) {
+    m_engine->dump();
+  } else {
+    BasicIQueue<FnPriority, HeapOrder>::dump();
+  }
+}
 
-    insertCrop(currCrop);
+void IQueue::requireSkewHeap() const {
+  if(m_engine != nullptr) {
+    throw std::domain_error("You attempted to update or remove a single crop in a queue that is not a skew heap!");
   }
+}
+
+void IQueue::fallBackToSkewHeap() {
+  while(m_engine->numCrops() > 0) {
+    BasicIQueue<FnPriority, HeapOrder>::insertCrop(m_engine->getNextCrop());
+  }
+  delete m_engine;
+  m_engine = nullptr;
+  m_engineType = SKEWHEAP;
+}
 
+NodePool::NodePool() {
+  m_chunkSize = 0;
+  m_used = 0;
+  m_freeList = nullptr;
+  m_freeTail = nullptr;
 }
 
-Node* IQueue::merge(Node* left, Node* right) {
+NodePool::~NodePool() {
+  releaseAll();
+}
 
-  Node* newSubRoot = nullptr;
+Node* NodePool::allocate(const Crop& crop, int priority) {
+  Node* slot = nullptr;
 
-  if(m_heapType == MAXHEAP) {
-    newSubRoot = mergeMax(left, right);
-  } else if (m_heapType == MINHEAP) {
-    newSubRoot = mergeMin(left, right);
+  if(m_freeList != nullptr) { // reuse the most recently released Node first, it's still in cache
+    slot = m_freeList;
+    m_freeList = slot->m_right;
+    if(m_freeList == nullptr) {
+      m_freeTail = nullptr;
+    }
+  } else {
+    if(m_chunks.empty() || m_used == m_chunkSize) {
+      m_chunkSize = (m_chunkSize == 0) ? MINPOOLCHUNK : m_chunkSize * 2;
+      if(m_chunkSize > MAXPOOLCHUNK) {
+        m_chunkSize = MAXPOOLCHUNK;
+      }
+      m_chunks.push_back(static_cast<Node*>(::operator new(sizeof(Node) * m_chunkSize)));
+      m_used = 0;
+    }
+    slot = m_chunks.back() + m_used;
+    m_used++;
   }
 
-  if(newSubRoot != nullptr) { // skew heap property
-    swap(newSubRoot->m_left, newSubRoot->m_right);
-  }
+  return new (slot) Node(crop, priority);
+}
 
+void NodePool::release(Node* node) {
+  // Node only holds ints and pointers, there is nothing to destroy
+  node->m_right = m_freeList;
+  m_freeList = node;
+  if(m_freeTail == nullptr) {
+    m_freeTail = node;
+  }
+}
 
-  return newSubRoot;
+void NodePool::releaseAll() {
+  for(unsigned int i = 0; i < m_chunks.size(); i++) {
+    ::operator delete(m_chunks[i]);
+  }
+  m_chunks.clear();
+  m_chunkSize = 0;
+  m_used = 0;
+  m_freeList = nullptr;
+  m_freeTail = nullptr;
 }
 
+void NodePool::adopt(NodePool& rhs) {
+  if(this == &rhs || rhs.m_chunks.empty()) {
+    return;
+  }
 
-void IQueue::dump() const
-{
-  if (m_size == 0) {
-    cout << "Empty skew heap.\n" ;
-  } else {
-    dump(m_heap);
-    cout << endl;
+  // the rest of rhs's newest chunk is not handed out again, it goes away with releaseAll()
+  m_chunks.insert(m_chunks.begin(), rhs.m_chunks.begin(), rhs.m_chunks.end());
+  if(rhs.m_freeList != nullptr) {
+    rhs.m_freeTail->m_right = m_freeList;
+    if(m_freeList == nullptr) {
+      m_freeTail = rhs.m_freeTail;
+    }
+    m_freeList = rhs.m_freeList;
   }
+
+  rhs.m_chunks.clear();
+  rhs.m_chunkSize = 0;
+  rhs.m_used = 0;
+  rhs.m_freeList = nullptr;
+  rhs.m_freeTail = nullptr;
 }
 
-void IQueue::dump(Node *pos) const {
-  if ( pos != nullptr ) {
-    cout << "(";
-    dump(pos->m_left);
-    cout << m_priorFunc(pos->m_crop) << ":" << pos->m_crop.getCropID();
-    dump(pos->m_right);
-    cout << ")";
-  }
+void NodePool::swap(NodePool& rhs) {
+  m_chunks.swap(rhs.m_chunks);
+  std::swap(m_chunkSize, rhs.m_chunkSize);
+  std::swap(m_used, rhs.m_used);
+  std::swap(m_freeList, rhs.m_freeList);
+  std::swap(m_freeTail, rhs.m_freeTail);
+}
+
+int NodePool::numChunks() const {
+  return m_chunks.size();
 }
 
 ostream& operator<<(ostream& sout, const Crop& crop) {
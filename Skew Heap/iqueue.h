@@ -4,10 +4,19 @@
 #include <stdexcept>
 #include <iostream>
 #include <string>
+#include <vector>
+#include <new>
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+#include <utility>
+#include <memory>
 using namespace std;
 class Grader;   // forward declaration (for grading purposes)
 class Tester;   // forward declaration
 class IQueue;   // forward declaration
+template <class Priority, class Order> class BasicIQueue;
+class QueueEngine; // defined in iqueue.cpp
 // Constant parameters, min and max values
 #define DEFAULTCROPID 100000
 const int MINCROPID = 100001;// minimum crop ID
@@ -28,12 +37,21 @@ const int MINTYPE = BEAN;       // lowest priority
 const int MAXTYPE = SUGARCANE;  // highest priority
 
 enum HEAPTYPE {MINHEAP, MAXHEAP};
+// what holds the crops of an IQueue
+// SKEWHEAP: pointer based skew heap, O(log n) merge
+// DARYHEAP4, DARYHEAP8: implicit 4-ary/8-ary heap in a vector, O(n) merge (daryheap.h)
+// BUCKETQUEUE: one bucket per priority value, O(1) insert and pop, needs a
+//              declared priority range (bucketqueue.h)
+// INTERVALHEAP: double-ended heap in a vector, also pops the lowest priority
+//               crop in O(log n) with getLastCrop (intervalheap.h)
+enum ENGINE {SKEWHEAP, DARYHEAP4, DARYHEAP8, BUCKETQUEUE, INTERVALHEAP};
 
 class Crop{
     public:
     friend class Grader; // for grading purposes
     friend class Tester; // for testing purposes
     friend class IQueue;
+    template <class Priority, class Order> friend class BasicIQueue;
     Crop(){
         m_cropID = DEFAULTCROPID;m_temperature = MINTEMP;
         m_moisture = MAXMOISTURE;m_time = MAXTIME;
@@ -84,23 +102,26 @@ class Crop{
         return result;
     }
     private:
+    // Every field fits in a byte except the ID, so a Crop packs into 8 bytes:
+    // the ID in the first 4, then temperature, moisture, time and type one
+    // byte each (computePriorities for LinearPriority relies on this order)
     int m_cropID;       // every crop is identified by a unique ID
     // m_temperature shows the temperature at the calculation time
     // the lower the temperature is the lower the priority is
-    int m_temperature;  // 30-110 degree Fahrenheit
+    unsigned char m_temperature;  // 30-110 degree Fahrenheit
     // m_moisture shows how moist is the soil for the crop object at the calculation time
     // a value of 0 indicates the highest priority
     // a value of 100 indicates the lowest proprity
-    int m_moisture;     // 0-100 %
+    unsigned char m_moisture;     // 0-100 %
     // m_time shows the time of the say at the calculation time
     // the time of day is divided into 4 windows
     // a value of 0 means a higher priority
     // a value of 3 means a lower priority
-    int m_time;         // 0-3, an enum type is defined for this
+    unsigned char m_time;         // 0-3, an enum type is defined for this
     // m_type shows the type of a crop based on the plant watering requirement
     // a value of 0 means a lower priority, 
     // a value of 6 means a higher priority 
-    int m_type;         // 0-6, an enum type is defined for this
+    unsigned char m_type;         // 0-6, an enum type is defined for this
 };
 
 class Node {
@@ -108,18 +129,58 @@ class Node {
   friend class Grader; // for grading purposes
   friend class Tester; // for testing purposes
   friend class IQueue;
-  Node(Crop crop) {  
+  template <class Priority, class Order> friend class BasicIQueue;
+  friend class NodePool;
+  Node(Crop crop, int priority = 0) {  
     m_crop = crop;
+    m_priority = priority;
     m_right = nullptr;
     m_left = nullptr;
+    m_parent = nullptr;
   }
   Crop getCrop() const {return m_crop;}
+  int getPriority() const {return m_priority;}
   private:
   Crop m_crop;      // crop information
+  int m_priority;   // priority function value of m_crop, computed once when the crop goes in
   Node * m_right;   // right child
   Node * m_left;    // left child
+  Node * m_parent;  // nullptr at the root, lets a Node be cut out of the middle of the heap
 };
 
+// Slab allocator for Nodes. Nodes are carved out of contiguous chunks and
+// released Nodes go on an intrusive free list (linked through m_right), so a
+// steady insert/pop churn never reaches the global allocator. Releasing the
+// whole pool frees one block per chunk instead of walking the tree.
+const int MINPOOLCHUNK = 64;     // Nodes in the first chunk
+const int MAXPOOLCHUNK = 65536;  // chunks double until they reach this size
+class NodePool {
+  public:
+  friend class Grader; // for grading purposes
+  friend class Tester; // for testing purposes
+  NodePool();
+  ~NodePool();
+  Node* allocate(const Crop& crop, int priority);
+  void release(Node* node);   // puts the node on the free list
+  void releaseAll();          // drops every Node, O(chunks)
+  void adopt(NodePool& rhs);  // takes over every chunk of rhs, rhs ends up empty
+  void swap(NodePool& rhs);
+  int numChunks() const;
+  private:
+  vector<Node*> m_chunks; // every chunk we own
+  int m_chunkSize;        // capacity of the newest chunk
+  int m_used;             // Nodes handed out from the newest chunk
+  Node* m_freeList;       // released Nodes, newest first
+  Node* m_freeTail;       // oldest released Node, lets adopt() splice in O(1)
+
+  NodePool(const NodePool&);            // a pool is never copied
+  NodePool& operator=(const NodePool&);
+};
+
+// Identifies a crop inside a queue until it is popped or removed, or the
+// queue is cleared. Merging keeps the handles of both queues valid
+typedef const Node* CropHandle;
+
 // Overloaded insertion operators for Crop and Node
 ostream& operator<<(ostream& sout, const Crop& crop);
 ostream& operator<<(ostream& sout, const Node& node);
@@ -127,120 +188,875 @@ ostream& operator<<(ostream& sout, const Node& node);
 // Priority function pointer type
 typedef int (*prifn_t)(const Crop&);
 
-class IQueue{
+// A Priority is any type with int operator()(const Crop&) const.
+// An Order is any type with bool operator()(int left, int right) const that
+// returns true if a crop with priority left belongs above one with priority
+// right, equal priorities have to return true.
+
+class LinearPriority;
+
+// Priority that calls a function pointer, what IQueue uses. It can also
+// carry a LinearPriority giving the same priorities, batches of crops are
+// then evaluated through that one (see computePriorities below)
+class FnPriority{
+    public:
+    FnPriority(prifn_t priFn = nullptr) {m_priorFunc = priFn;}
+    // Throws invalid_argument if priFn is nullptr or differs from linear
+    // on any corner of the crop field ranges
+    FnPriority(prifn_t priFn, const LinearPriority& linear);
+    int operator()(const Crop& crop) const {return m_priorFunc(crop);}
+    prifn_t getFn() const {return m_priorFunc;}
+    const LinearPriority* getLinear() const {return m_linear.get();} // nullptr if there is none
+    private:
+    prifn_t m_priorFunc;
+    shared_ptr<const LinearPriority> m_linear; // copies of the priority share it
+};
+
+// Orders fixed at compile time
+class MaxOrder{
+    public:
+    bool operator()(int left, int right) const {return left >= right;}
+};
+class MinOrder{
+    public:
+    bool operator()(int left, int right) const {return left <= right;}
+};
+
+// Order picked at run time, what IQueue uses
+class HeapOrder{
+    public:
+    HeapOrder(HEAPTYPE heapType = MINHEAP) {m_heapType = heapType;}
+    bool operator()(int left, int right) const {
+        if(m_heapType == MAXHEAP) {
+            return left >= right;
+        }
+        return left <= right;
+    }
+    HEAPTYPE getHeapType() const {return m_heapType;}
+    private:
+    HEAPTYPE m_heapType;
+};
+
+// Writes the priorities of count crops into out. Bulk inserts and rebuilds
+// go through here, a Priority with a faster batch version (LinearPriority)
+// overloads it
+template <class Priority>
+void computePriorities(const Priority& priority, const Crop* crops, int count, int* out) {
+    for(int i = 0; i < count; i++) {
+        out[i] = priority(crops[i]);
+    }
+}
+// Goes through the LinearPriority of priority if it has one
+void computePriorities(const FnPriority& priority, const Crop* crops, int count, int* out);
+
+// The skew heap itself. With stateless Priority and Order types (say a
+// functor calling an inline function and MaxOrder) every priority
+// computation and comparison is inlined into merge().
+template <class Priority, class Order>
+class BasicIQueue{
+    public:
+    friend class Grader; // for grading purposes
+    friend class Tester; // for testing purposes
+
+    BasicIQueue(Priority priority = Priority(), Order order = Order());
+    ~BasicIQueue();
+    BasicIQueue(const BasicIQueue& rhs);
+    BasicIQueue& operator=(const BasicIQueue& rhs);
+    // Moving takes over the Nodes of rhs in O(1), handles into rhs stay
+    // valid and now belong to this queue. rhs is left empty
+    BasicIQueue(BasicIQueue&& rhs);
+    BasicIQueue& operator=(BasicIQueue&& rhs);
+    void swap(BasicIQueue& rhs); // O(1), handles go with their crops
+    CropHandle insertCrop(const Crop& crop);
+    // Builds a heap of count crops bottom-up in O(count), then merges it in
+    void insertCrops(const Crop* crops, int count);
+    Crop getNextCrop(); // Return the highest priority crop
+    // Priority of the crop getNextCrop would return, throws domain_error if empty
+    int getNextPriority() const;
+    // Takes the k highest priority crops out, highest first, into out (room
+    // for k crops). Returns how many there were, O(k log k + k log n)
+    int getNextCrops(int k, Crop* out);
+    // Same crops in the same order as getNextCrops, but the queue does not change
+    int peekTopK(int k, Crop* out) const;
+    // Replaces the crop behind handle and moves it to where its new priority
+    // belongs, amortized O(log n)
+    void updateCrop(CropHandle handle, const Crop& crop);
+    // Takes the crop behind handle out of the queue, amortized O(log n)
+    Crop removeCrop(CropHandle handle);
+    // Keeps a cropID -> Node index from now on, so crops can be found by ID.
+    // Crop IDs have to be unique while it is on, throws domain_error if
+    // they are not (the index stays off)
+    void enableCropIndex();
+    bool hasCropIndex() const;
+    // Need the index, return false if no crop has cropID. crop may carry a new ID
+    bool updateCrop(int cropID, const Crop& crop);
+    bool removeCrop(int cropID);
+    // With the index on, throws domain_error before anything moves if a
+    // crop ID of rhs is already here or shows up twice in rhs
+    void mergeWithQueue(BasicIQueue& rhs);
+    void clear();
+    int numCrops() const; // Return number of crops in queue
+    void cropIDs(vector<int>& out) const; // Appends every crop ID, in preorder, O(n)
+    void printCropsQueue() const; // Print the queue using preorder traversal
+    const Priority& getPriority() const;
+    const Order& getOrder() const;
+    // Set a new priority and order, rebuilds the heap in place in O(n)
+    void setPriority(Priority priority, Order order);
+    void dump() const; // For debugging purposes
+
+    private:
+    Node * m_heap;          // Pointer to root of skew heap
+    int m_size;             // Current size of the heap
+    Priority m_priorFunc;   // Computes the priority of a crop
+    Order m_order;          // Decides which of two priorities goes on top
+    NodePool m_pool;        // every Node of this heap comes from here
+    bool m_indexed;         // true once enableCropIndex was called
+    unordered_map<int, Node*> m_index; // cropID -> Node, only while m_indexed
+
+    void dump(Node *pos) const; // helper function for dump
+
+    Node* merge(Node* left, Node* right);
+    // Heap-orders nodes as an implicit binary heap (Floyd), then links it into
+    // a complete tree. Returns the root, O(n)
+    Node* buildHeap(vector<Node*>& nodes);
+    // Cuts node out of the heap, its children take its place
+    void detach(Node* node);
+    // Throws domain_error if the index is on and cropID is in it
+    void checkNewID(int cropID) const;
+    // The top count Nodes in pop order, found through a small heap over the
+    // frontier, which ends up holding the roots of what is left. O(count log count)
+    void findTop(int count, vector<Node*>& top, vector<Node*>& frontier) const;
+
+    // true if left belongs above right, ties go to left
+    bool outranks(Node* left, Node* right) const {
+        return m_order(left->m_priority, right->m_priority);
+    };
+
+    // Copies the tree with an explicit stack, the depth of a skew heap is not bounded by log n
+    Node* copyTree(Node* currentNode) {
+        Node* newRoot = nullptr;
+        vector<pair<Node*, Node*> > stack; // node to copy, the copy of its parent
+        if(currentNode != nullptr) {
+            stack.push_back(make_pair(currentNode, (Node*)nullptr));
+        }
+
+        while(!stack.empty()) {
+            Node* oldNode = stack.back().first;
+            Node* newParent = stack.back().second;
+            stack.pop_back();
+
+            Node* newNode = m_pool.allocate(oldNode->m_crop, oldNode->m_priority);
+            newNode->m_parent = newParent;
+            if(newParent == nullptr) {
+                newRoot = newNode;
+            } else if(oldNode == oldNode->m_parent->m_left) {
+                newParent->m_left = newNode;
+            } else {
+                newParent->m_right = newNode;
+            }
+            if(m_indexed) {
+                m_index[newNode->m_crop.m_cropID] = newNode;
+            }
+            m_size++;
+
+            if(oldNode->m_right != nullptr) {
+                stack.push_back(make_pair(oldNode->m_right, newNode));
+            }
+            if(oldNode->m_left != nullptr) {
+                stack.push_back(make_pair(oldNode->m_left, newNode));
+            }
+        }
+
+        return newRoot;
+    }
+
+    void printPreOrder(Node* currNode) const {
+        vector<Node*> stack;
+        if (currNode != nullptr) {
+            stack.push_back(currNode);
+        }
+
+        while (!stack.empty()) {
+            currNode = stack.back();
+            stack.pop_back();
+
+            Crop crop = currNode->getCrop();
+            cout << "[" << currNode->m_priority << "] Crop ID:" <<  crop.getCropID() << ", current temperature: " << crop.getTemperature() << ", current soil moisture: " << crop.getMoisture() << "%, current time: " << crop.getTimeString() << ", plant type: " << crop.getTypeString() << endl;
+
+            // right goes first so left comes off the stack first
+            if (currNode->m_right != nullptr) {
+                stack.push_back(currNode->m_right);
+            }
+            if (currNode->m_left != nullptr) {
+                stack.push_back(currNode->m_left);
+            }
+        }
+    }
+};
+
+// The priority function, heap type and engine chosen at run time. The
+// skew heap engine is the BasicIQueue base itself, any other engine sits
+// behind m_engine and the base stays empty. The base is private, so nothing
+// reaches that empty base by going around IQueue.
+class IQueue : private BasicIQueue<FnPriority, HeapOrder>{
     public:
     friend class Grader; // for grading purposes
     friend class Tester; // for testing purposes
     
-    IQueue(prifn_t priFn, HEAPTYPE heapType);
+    // Throws domain_error for BUCKETQUEUE, that engine needs the constructor below
+    IQueue(prifn_t priFn, HEAPTYPE heapType, ENGINE engine = SKEWHEAP);
+    // priFn returns values in [minPriority, maxPriority]. Uses a BUCKETQUEUE
+    // if the range fits into MAXBUCKETS, otherwise a SKEWHEAP. If a priority
+    // later widens the range too much, the crops move to a SKEWHEAP
+    IQueue(prifn_t priFn, HEAPTYPE heapType, int minPriority, int maxPriority);
+    // Loads every crop with insertCrops, BUCKETQUEUE throws as above
+    IQueue(prifn_t priFn, HEAPTYPE heapType, const vector<Crop>& crops, ENGINE engine = SKEWHEAP);
     ~IQueue();
     IQueue(const IQueue& rhs);
     IQueue& operator=(const IQueue& rhs);
-    void insertCrop(const Crop& crop);
+    // O(1), the engine and its crops change hands and rhs is left empty
+    IQueue(IQueue&& rhs);
+    IQueue& operator=(IQueue&& rhs);
+    void swap(IQueue& rhs);
+    // Returns nullptr unless the engine is SKEWHEAP
+    CropHandle insertCrop(const Crop& crop);
+    // Adds count crops at once, in linear time for every engine
+    void insertCrops(const Crop* crops, int count);
     Crop getNextCrop(); // Return the highest priority crop
+    // Priority of the crop getNextCrop would return, throws domain_error if empty
+    int getNextPriority() const;
+    // Return the lowest priority crop, needs the INTERVALHEAP engine, the
+    // others throw domain_error
+    Crop getLastCrop();
+    // Take out / look at the k highest priority crops, see BasicIQueue
+    int getNextCrops(int k, Crop* out);
+    int peekTopK(int k, Crop* out) const;
+    // Updating and removing single crops needs the SKEWHEAP engine, the
+    // others throw domain_error. See BasicIQueue
+    void updateCrop(CropHandle handle, const Crop& crop);
+    Crop removeCrop(CropHandle handle);
+    void enableCropIndex();
+    using BasicIQueue<FnPriority, HeapOrder>::hasCropIndex; // only a SKEWHEAP ever has one
+    bool updateCrop(int cropID, const Crop& crop);
+    bool removeCrop(int cropID);
+    // Throws domain_error if the priority functions differ
     void mergeWithQueue(IQueue& rhs);
+    // Merges count queues into this one and leaves them empty. Skew heaps and
+    // bucket queues merge pairwise in a balanced tree, the pairs of one round
+    // on up to numThreads threads that stay for every round. Throws
+    // domain_error before anything moves if a priority function differs or
+    // if two crops with the same ID would meet in a queue with a crop index
+    void mergeAll(IQueue* const* queues, int count, int numThreads = 1);
     void clear();
     int numCrops() const; // Return number of crops in queue
     void printCropsQueue() const; // Print the queue using preorder traversal
     prifn_t getPriorityFn() const;
     // Set a new priority function. Must rebuild the heap!!!
     void setPriorityFn(prifn_t priFn, HEAPTYPE heapType);
+    // Same, and linear gives the same priority as priFn for every crop, so
+    // insertCrops and the rebuilds of the array engines use its batch evaluator.
+    // Throws invalid_argument before anything changes if the two disagree
+    void setPriorityFn(prifn_t priFn, HEAPTYPE heapType, const LinearPriority& linear);
     HEAPTYPE getHeapType() const;
+    ENGINE getEngine() const;
     void dump() const; // For debugging purposes
 
     private:
-    Node * m_heap;          // Pointer to root of skew heap
-    int m_size;             // Current size of the heap
-    prifn_t m_priorFunc;    // Function to compute priority
-    HEAPTYPE m_heapType;    // either a MINHEAP or a MAXHEAP
+    ENGINE m_engineType;    // which engine holds the crops
+    QueueEngine* m_engine;  // nullptr for SKEWHEAP
 
-    void dump(Node *pos) const; // helper function for dump
+    // moves every crop of m_engine into the skew heap and drops the engine
+    void fallBackToSkewHeap();
+    // throws domain_error if the crops are not in the skew heap
+    void requireSkewHeap() const;
+    // appends the ID of every crop, from the engine if there is one, O(n)
+    void cropIDs(vector<int>& out) const;
+    // hands a new priority to the base and the engine, both rebuild
+    void applyPriority(const FnPriority& priority, HEAPTYPE heapType);
+    // Throws domain_error if a merge round of mergeAll over level would bring
+    // a crop ID into an indexed queue that already holds it
+    static void checkMergeIDs(const vector<IQueue*>& level);
+};
 
-    /******************************************
-     * Private function declarations go here! *
-     ******************************************/
-    Node* merge(Node* left, Node* right);
+template <class Priority, class Order>
+BasicIQueue<Priority, Order>::BasicIQueue(Priority priority, Order order)
+{
+    m_heap = nullptr; 
+    m_size = 0; 
+    m_priorFunc = priority; 
+    m_order = order;  
+    m_indexed = false;
+}
 
-    Node* mergeMax(Node* left, Node* right) {
-        Node* newSubRoot = nullptr;
-        if(left != nullptr && right != nullptr) {
-            if(m_priorFunc(left->getCrop()) >= m_priorFunc(right->getCrop())) {
-            left->m_right = merge(left->m_right, right);
-            newSubRoot = left;
-            } else {
-            right->m_right = merge(right->m_right, left);
-            newSubRoot = right;
+template <class Priority, class Order>
+BasicIQueue<Priority, Order>::~BasicIQueue() {
+  clear();
+}
+
+template <class Priority, class Order>
+BasicIQueue<Priority, Order>::BasicIQueue(const BasicIQueue& rhs) {
+  m_heap = nullptr; 
+  m_size = 0;
+  m_priorFunc = rhs.m_priorFunc;
+  m_order = rhs.m_order;
+  m_indexed = rhs.m_indexed;
+
+  m_heap = copyTree(rhs.m_heap);
+}
+
+template <class Priority, class Order>
+BasicIQueue<Priority, Order>& BasicIQueue<Priority, Order>::operator=(const BasicIQueue& rhs) {
+  if(this == &rhs) {
+    return *this;
+  }
+
+  // copy first, so a failed allocation leaves this queue as it was
+  BasicIQueue copy(rhs);
+  swap(copy);
+
+  return *this;
+}
+
+template <class Priority, class Order>
+BasicIQueue<Priority, Order>::BasicIQueue(BasicIQueue&& rhs) {
+  m_heap = nullptr;
+  m_size = 0;
+  m_priorFunc = rhs.m_priorFunc;
+  m_order = rhs.m_order;
+  m_indexed = rhs.m_indexed;
+
+  swap(rhs);
+}
+
+template <class Priority, class Order>
+BasicIQueue<Priority, Order>& BasicIQueue<Priority, Order>::operator=(BasicIQueue&& rhs) {
+  if(this == &rhs) {
+    return *this;
+  }
+
+  clear();
+  swap(rhs);
+
+  return *this;
+}
+
+template <class Priority, class Order>
+void BasicIQueue<Priority, Order>::swap(BasicIQueue& rhs) {
+  std::swap(m_heap, rhs.m_heap);
+  std::swap(m_size, rhs.m_size);
+  std::swap(m_priorFunc, rhs.m_priorFunc);
+  std::swap(m_order, rhs.m_order);
+  m_pool.swap(rhs.m_pool);
+  std::swap(m_indexed, rhs.m_indexed);
+  m_index.swap(rhs.m_index);
+}
+
+template <class Priority, class Order>
+CropHandle BasicIQueue<Priority, Order>::insertCrop(const Crop& crop) {
+    checkNewID(crop.m_cropID);
+    Node* newNode = m_pool.allocate(crop, m_priorFunc(crop));
+
+    m_heap = merge(m_heap, newNode);
+    m_size++;
+    if(m_indexed) {
+        m_index[crop.m_cropID] = newNode;
+    }
+    return newNode;
+}
+
+template <class Priority, class Order>
+void BasicIQueue<Priority, Order>::insertCrops(const Crop* crops, int count) {
+    if(count <= 0) {
+        return;
+    }
+
+    // with the index on, the whole batch is checked before anything goes in
+    if(m_indexed) {
+        unordered_map<int, Node*> batch;
+        for(int i = 0; i < count; i++) {
+            checkNewID(crops[i].m_cropID);
+            if(!batch.insert(make_pair(crops[i].m_cropID, (Node*)nullptr)).second) {
+                throw std::domain_error("You attempted to insert two crops with the same ID into an indexed queue!");
             }
-        } else if(left) {
-            newSubRoot = left;
-        } else if (right) {
-            newSubRoot = right;
         }
-        
-        return newSubRoot;
-    };
+    }
 
-    Node* mergeMin(Node* left, Node* right) {
-        Node* newSubRoot = nullptr;
-        if(left != nullptr && right != nullptr) {
-            if(m_priorFunc(left->getCrop()) <= m_priorFunc(right->getCrop())) {
-            left->m_right = merge(left->m_right, right);
-            newSubRoot = left;
-            } else {
-            right->m_right = merge(right->m_right, left);
-            newSubRoot = right;
-            }
-        } else if(left) {
-            newSubRoot = left;
-        } else if (right) {
-            newSubRoot = right;
+    vector<int> priorities(count);
+    computePriorities(m_priorFunc, crops, count, priorities.data());
+    vector<Node*> nodes(count);
+    for(int i = 0; i < count; i++) {
+        nodes[i] = m_pool.allocate(crops[i], priorities[i]);
+        if(m_indexed) {
+            m_index[crops[i].m_cropID] = nodes[i];
         }
-        
-        return newSubRoot;
-    };
+    }
 
-    void clearRecursive(Node* currentNode) { // i know this works
-        if(currentNode) {
-            clearRecursive(currentNode->m_left);
-            clearRecursive(currentNode->m_right);
+    // the new heap has a right spine of log(count) nodes, so the merge is cheap
+    m_heap = merge(m_heap, buildHeap(nodes));
+    m_size += count;
+}
 
-            delete currentNode;
-            currentNode = nullptr;
-        }
-    };
+template <class Priority, class Order>
+Crop BasicIQueue<Priority, Order>::getNextCrop() {
+  
+  if(m_heap == nullptr) {
+    throw std::domain_error("You are attempting to get next crop from an empty skew-heap!");
+  }
 
-    Node* copyRecursive(Node* currentNode) { // i know this works...
-        if(currentNode != nullptr) {
-            Node* leftNode = copyRecursive(currentNode->m_left);
-            Node* rightNode = copyRecursive(currentNode->m_right);
+  Node* oldNode = m_heap;
+  Crop nextCrop = oldNode->getCrop();
 
-            Node* newNode = new Node(currentNode->getCrop());
-            newNode->m_left = leftNode;
-            newNode->m_right = rightNode;
-            m_size++;
+  m_heap = merge(m_heap->m_left, m_heap->m_right);
+  if(m_indexed) {
+    m_index.erase(nextCrop.m_cropID);
+  }
 
 
-            return newNode;
-        } else {
-            return nullptr;
-        }
+  m_pool.release(oldNode);
+  oldNode = nullptr;
+  m_size--;
+
+  return nextCrop;
+}
+
+template <class Priority, class Order>
+int BasicIQueue<Priority, Order>::getNextPriority() const {
+  if(m_heap == nullptr) {
+    throw std::domain_error("You are attempting to look at the next crop of an empty skew-heap!");
+  }
+  return m_heap->m_priority;
+}
+
+template <class Priority, class Order>
+int BasicIQueue<Priority, Order>::getNextCrops(int k, Crop* out) {
+  vector<Node*> top;
+  vector<Node*> rest;
+  findTop(k, top, rest);
+  if(top.empty()) {
+    return 0;
+  }
 
+  // what is left is a forest, merged in pairs so every root goes through log(k) merges
+  while(rest.size() > 1) {
+    unsigned int half = 0;
+    for(unsigned int i = 0; i + 1 < rest.size(); i += 2) {
+      rest[half++] = merge(rest[i], rest[i + 1]);
+    }
+    if(rest.size() % 2 == 1) {
+      rest[half++] = rest.back();
     }
+    rest.resize(half);
+  }
+  m_heap = rest.empty() ? nullptr : rest[0];
+  if(m_heap != nullptr) {
+    m_heap->m_parent = nullptr;
+  }
 
-    void printPreOrder(Node* currNode) const {
-        if (currNode == NULL) {
-            return;
-        }
+  for(unsigned int i = 0; i < top.size(); i++) {
+    out[i] = top[i]->m_crop;
+    if(m_indexed) {
+      m_index.erase(top[i]->m_crop.m_cropID);
+    }
+    m_pool.release(top[i]);
+  }
+  m_size -= top.size();
 
-    
-        Crop crop = currNode->getCrop();
-        cout << "[" << m_priorFunc(crop) << "] Crop ID:" <<  crop.getCropID() << ", current temperature: " << crop.getTemperature() << ", current soil moisture: " << crop.getMoisture() << "%, current time: " << crop.getTimeString() << ", plant type: " << crop.getTypeString() << endl;
-    
+  return top.size();
+}
+
+template <class Priority, class Order>
+int BasicIQueue<Priority, Order>::peekTopK(int k, Crop* out) const {
+  vector<Node*> top;
+  vector<Node*> frontier;
+  findTop(k, top, frontier);
+
+  for(unsigned int i = 0; i < top.size(); i++) {
+    out[i] = top[i]->m_crop;
+  }
+  return top.size();
+}
+
+template <class Priority, class Order>
+void BasicIQueue<Priority, Order>::updateCrop(CropHandle handle, const Crop& crop) {
+  Node* node = const_cast<Node*>(handle);
+  int oldID = node->m_crop.m_cropID;
+  if(crop.m_cropID != oldID) {
+    checkNewID(crop.m_cropID);
+  }
+
+  detach(node);
+  node->m_crop = crop;
+  node->m_priority = m_priorFunc(crop);
+  m_heap = merge(m_heap, node);
+
+  if(m_indexed && crop.m_cropID != oldID) {
+    m_index.erase(oldID);
+    m_index[crop.m_cropID] = node;
+  }
+}
+
+template <class Priority, class Order>
+Crop BasicIQueue<Priority, Order>::removeCrop(CropHandle handle) {
+  Node* node = const_cast<Node*>(handle);
+  Crop crop = node->m_crop;
+
+  detach(node);
+  if(m_indexed) {
+    m_index.erase(crop.m_cropID);
+  }
+  m_pool.release(node);
+  m_size--;
+
+  return crop;
+}
 
-        printPreOrder(currNode->m_left);
+template <class Priority, class Order>
+void BasicIQueue<Priority, Order>::enableCropIndex() {
+  if(m_indexed) {
+    return;
+  }
 
-        printPreOrder(currNode->m_right);
+  unordered_map<int, Node*> index;
+  index.reserve(m_size);
+  vector<Node*> stack;
+  if(m_heap != nullptr) {
+    stack.push_back(m_heap);
+  }
+  while(!stack.empty()) {
+    Node* node = stack.back();
+    stack.pop_back();
+    if(!index.insert(make_pair(node->m_crop.m_cropID, node)).second) {
+      throw std::domain_error("You attempted to index a queue that holds two crops with the same ID!");
     }
-};
+    if(node->m_left != nullptr) {
+      stack.push_back(node->m_left);
+    }
+    if(node->m_right != nullptr) {
+      stack.push_back(node->m_right);
+    }
+  }
+
+  m_index.swap(index);
+  m_indexed = true;
+}
+
+template <class Priority, class Order>
+bool BasicIQueue<Priority, Order>::hasCropIndex() const {
+  return m_indexed;
+}
+
+template <class Priority, class Order>
+bool BasicIQueue<Priority, Order>::updateCrop(int cropID, const Crop& crop) {
+  if(!m_indexed) {
+    throw std::domain_error("You attempted to update a crop by ID without a crop index!");
+  }
+  typename unordered_map<int, Node*>::iterator found = m_index.find(cropID);
+  if(found == m_index.end()) {
+    return false;
+  }
+  updateCrop(found->second, crop);
+  return true;
+}
+
+template <class Priority, class Order>
+bool BasicIQueue<Priority, Order>::removeCrop(int cropID) {
+  if(!m_indexed) {
+    throw std::domain_error("You attempted to remove a crop by ID without a crop index!");
+  }
+  typename unordered_map<int, Node*>::iterator found = m_index.find(cropID);
+  if(found == m_index.end()) {
+    return false;
+  }
+  removeCrop(found->second);
+  return true;
+}
+
+template <class Priority, class Order>
+void BasicIQueue<Priority, Order>::mergeWithQueue(BasicIQueue& rhs) {
+  if(this == &rhs) {
+    return;
+  }
+
+  // every crop of rhs joins our index, duplicates are checked before anything moves
+  if(m_indexed) {
+    vector<Node*> stack;
+    if(rhs.m_heap != nullptr) {
+      stack.push_back(rhs.m_heap);
+    }
+    vector<Node*> incoming;
+    unordered_set<int> incomingIDs; // a queue without an index may hold an ID twice
+    while(!stack.empty()) {
+      Node* node = stack.back();
+      stack.pop_back();
+      checkNewID(node->m_crop.m_cropID);
+      if(!incomingIDs.insert(node->m_crop.m_cropID).second) {
+        throw std::domain_error("You attempted to merge two crops with the same ID into an indexed queue!");
+      }
+      incoming.push_back(node);
+      if(node->m_left != nullptr) {
+        stack.push_back(node->m_left);
+      }
+      if(node->m_right != nullptr) {
+        stack.push_back(node->m_right);
+      }
+    }
+    for(unsigned int i = 0; i < incoming.size(); i++) {
+      m_index[incoming[i]->m_crop.m_cropID] = incoming[i];
+    }
+  }
+  rhs.m_index.clear();
+
+  m_heap = merge(m_heap, rhs.m_heap);
+  m_size += rhs.m_size;
+  rhs.m_heap = nullptr;
+  rhs.m_size = 0;
+  m_pool.adopt(rhs.m_pool); // rhs's Nodes live in our heap now
+}
+
+template <class Priority, class Order>
+void BasicIQueue<Priority, Order>::clear() {
+  m_pool.releaseAll();
+
+  m_heap = nullptr;
+  m_size = 0;
+  m_index.clear();
+}
+
+template <class Priority, class Order>
+int BasicIQueue<Priority, Order>::numCrops() const
+{
+  return m_size;
+}
+
+template <class Priority, class Order>
+void BasicIQueue<Priority, Order>::cropIDs(vector<int>& out) const {
+  vector<Node*> stack;
+  if(m_heap != nullptr) {
+    stack.push_back(m_heap);
+  }
+  while(!stack.empty()) {
+    Node* node = stack.back();
+    stack.pop_back();
+    out.push_back(node->m_crop.m_cropID);
+    if(node->m_right != nullptr) {
+      stack.push_back(node->m_right);
+    }
+    if(node->m_left != nullptr) {
+      stack.push_back(node->m_left);
+    }
+  }
+}
+
+template <class Priority, class Order>
+void BasicIQueue<Priority, Order>::printCropsQueue() const {
+  printPreOrder(m_heap);  
+}
+
+template <class Priority, class Order>
+const Priority& BasicIQueue<Priority, Order>::getPriority() const {
+  return m_priorFunc;
+}
+
+template <class Priority, class Order>
+const Order& BasicIQueue<Priority, Order>::getOrder() const {
+  return m_order;
+}
+
+template <class Priority, class Order>
+void BasicIQueue<Priority, Order>::setPriority(Priority priority, Order order) {
+  m_priorFunc = priority;
+  m_order = order;
+
+  // walk the tree once, every Node gets its new priority on the way and is
+  // reused as it is, then the whole lot is heapified bottom-up. O(n), no allocations
+  vector<Node*> nodes;
+  nodes.reserve(m_size);
+  if(m_heap != nullptr) {
+    nodes.push_back(m_heap);
+  }
+  for(unsigned int i = 0; i < nodes.size(); i++) {
+    Node* node = nodes[i];
+    node->m_priority = m_priorFunc(node->m_crop);
+    if(node->m_left != nullptr) {
+      nodes.push_back(node->m_left);
+    }
+    if(node->m_right != nullptr) {
+      nodes.push_back(node->m_right);
+    }
+  }
+
+  m_heap = buildHeap(nodes);
+}
+
+template <class Priority, class Order>
+Node* BasicIQueue<Priority, Order>::merge(Node* left, Node* right) {
+  // top-down along both right spines, no recursion. the winning root keeps its
+  // old left child as its new right child and the rest of the merge goes to its left,
+  // which is the same tree the recursive merge-then-swap builds
+  Node* newRoot = nullptr;
+  Node** link = &newRoot;
+  Node* parent = nullptr; // owner of link
+
+  while(left != nullptr && right != nullptr) {
+    if(!outranks(left, right)) {
+      std::swap(left, right);
+    }
+
+    *link = left;
+    left->m_parent = parent;
+    Node* next = left->m_right;
+    left->m_right = left->m_left; // skew heap property
+    link = &left->m_left;
+    parent = left;
+    left = next;
+  }
+
+  Node* rest = (left != nullptr) ? left : right;
+  if(rest != nullptr) { // skew heap property, the last subtree root swaps too
+    std::swap(rest->m_left, rest->m_right);
+    rest->m_parent = parent;
+  }
+  *link = rest;
+
+  return newRoot;
+}
+
+template <class Priority, class Order>
+Node* BasicIQueue<Priority, Order>::buildHeap(vector<Node*>& nodes) {
+  int count = nodes.size();
+  if(count == 0) {
+    return nullptr;
+  }
+
+  // sift down every inner position, only the pointers in the array move
+  for(int start = count / 2 - 1; start >= 0; start--) {
+    int index = start;
+    Node* node = nodes[index];
+    while(2 * index + 1 < count) {
+      int child = 2 * index + 1;
+      if(child + 1 < count && !outranks(nodes[child], nodes[child + 1])) {
+        child++;
+      }
+      if(outranks(node, nodes[child])) {
+        break;
+      }
+      nodes[index] = nodes[child];
+      index = child;
+    }
+    nodes[index] = node;
+  }
+
+  // a heap ordered complete binary tree is a valid skew heap
+  for(int i = 0; i < count; i++) {
+    nodes[i]->m_left = (2 * i + 1 < count) ? nodes[2 * i + 1] : nullptr;
+    nodes[i]->m_right = (2 * i + 2 < count) ? nodes[2 * i + 2] : nullptr;
+    nodes[i]->m_parent = (i > 0) ? nodes[(i - 1) / 2] : nullptr;
+  }
+
+  return nodes[0];
+}
+
+template <class Priority, class Order>
+void BasicIQueue<Priority, Order>::detach(Node* node) {
+  // the merged children are outranked by node, so they are by its parent too
+  Node* parent = node->m_parent;
+  Node* children = merge(node->m_left, node->m_right);
+  if(parent == nullptr) {
+    m_heap = children;
+  } else if(parent->m_left == node) {
+    parent->m_left = children;
+  } else {
+    parent->m_right = children;
+  }
+  if(children != nullptr) {
+    children->m_parent = parent;
+  }
+
+  node->m_left = nullptr;
+  node->m_right = nullptr;
+  node->m_parent = nullptr;
+}
+
+template <class Priority, class Order>
+void BasicIQueue<Priority, Order>::findTop(int count, vector<Node*>& top, vector<Node*>& frontier) const {
+  top.clear();
+  frontier.clear();
+  if(m_heap == nullptr || count <= 0) {
+    return;
+  }
+
+  // std heap functions keep the best Node at the front, a Node ranks below
+  // another one if it does not outrank it
+  const Order& order = m_order;
+  auto ranksBelow = [&order](Node* left, Node* right) {
+    return !order(left->m_priority, right->m_priority);
+  };
+
+  // the next Node always sits in the frontier, its children replace it there
+  frontier.push_back(m_heap);
+  while((int)top.size() < count && !frontier.empty()) {
+    pop_heap(frontier.begin(), frontier.end(), ranksBelow);
+    Node* node = frontier.back();
+    frontier.pop_back();
+    top.push_back(node);
+
+    if(node->m_left != nullptr) {
+      frontier.push_back(node->m_left);
+      push_heap(frontier.begin(), frontier.end(), ranksBelow);
+    }
+    if(node->m_right != nullptr) {
+      frontier.push_back(node->m_right);
+      push_heap(frontier.begin(), frontier.end(), ranksBelow);
+    }
+  }
+}
+
+template <class Priority, class Order>
+void BasicIQueue<Priority, Order>::checkNewID(int cropID) const {
+  if(m_indexed && m_index.count(cropID) > 0) {
+    throw std::domain_error("You attempted to insert a crop whose ID is already in an indexed queue!");
+  }
+}
+
+template <class Priority, class Order>
+void BasicIQueue<Priority, Order>::dump() const
+{
+  if (m_size == 0) {
+    cout << "Empty skew heap.\n" ;
+  } else {
+    dump(m_heap);
+    cout << endl;
+  }
+}
+
+template <class Priority, class Order>
+void BasicIQueue<Priority, Order>::dump(Node *pos) const {
+  // in-order with an explicit stack, every node goes through three stages:
+  // 0 opens it and visits the left, 1 prints it and visits the right, 2 closes it
+  vector<pair<Node*, int> > stack;
+  if ( pos != nullptr ) {
+    stack.push_back(make_pair(pos, 0));
+  }
+
+  while ( !stack.empty() ) {
+    Node* node = stack.back().first;
+    int stage = stack.back().second;
+    stack.back().second++;
+
+    if ( stage == 0 ) {
+      cout << "(";
+      if ( node->m_left != nullptr ) {
+        stack.push_back(make_pair(node->m_left, 0));
+      }
+    } else if ( stage == 1 ) {
+      cout << node->m_priority << ":" << node->m_crop.getCropID();
+      if ( node->m_right != nullptr ) {
+        stack.push_back(make_pair(node->m_right, 0));
+      }
+    } else {
+      cout << ")";
+      stack.pop_back();
+    }
+  }
+}
 #endif
- 
@@ -0,0 +1,58 @@
+#include "linearpriority.h"
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define HAVE_AVX2_KERNEL
+#endif
+
+// the kernels read a Crop as two 32-bit words: the ID, then the four one-byte fields
+static_assert(sizeof(Crop) == 8, "Crop is expected to pack into 8 bytes");
+
+// one crop at a time, for CPUs without AVX2 and for the tail of the array
+static void computeScalar(const LinearPriority& priority, const Crop* crops, int count, int* out) {
+    for(int i = 0; i < count; i++) {
+        out[i] = priority(crops[i]);
+    }
+}
+
+#ifdef HAVE_AVX2_KERNEL
+// eight crops per round: two loads give eight (ID, fields) pairs, a permute
+// keeps the eight field words, and the fields come out with a shift and a mask
+__attribute__((target("avx2")))
+static int computeAVX2(const LinearPriority& priority, const Crop* crops, int count, int* out) {
+    const __m256i constant = _mm256_set1_epi32(priority.getConstant());
+    const __m256i temperature = _mm256_set1_epi32(priority.getTemperature());
+    const __m256i moisture = _mm256_set1_epi32(priority.getMoisture());
+    const __m256i time = _mm256_set1_epi32(priority.getTime());
+    const __m256i type = _mm256_set1_epi32(priority.getType());
+    const __m256i byteMask = _mm256_set1_epi32(0xFF);
+    const __m256i oddWords = _mm256_setr_epi32(1, 3, 5, 7, 0, 2, 4, 6);
+
+    int i = 0;
+    for(; i + 8 <= count; i += 8) {
+        __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(crops + i));
+        __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(crops + i + 4));
+        low = _mm256_permutevar8x32_epi32(low, oddWords);
+        high = _mm256_permutevar8x32_epi32(high, oddWords);
+        __m256i fields = _mm256_permute2x128_si256(low, high, 0x20);
+
+        __m256i sum = constant;
+        sum = _mm256_add_epi32(sum, _mm256_mullo_epi32(_mm256_and_si256(fields, byteMask), temperature));
+        sum = _mm256_add_epi32(sum, _mm256_mullo_epi32(_mm256_and_si256(_mm256_srli_epi32(fields, 8), byteMask), moisture));
+        sum = _mm256_add_epi32(sum, _mm256_mullo_epi32(_mm256_and_si256(_mm256_srli_epi32(fields, 16), byteMask), time));
+        sum = _mm256_add_epi32(sum, _mm256_mullo_epi32(_mm256_srli_epi32(fields, 24), type));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), sum);
+    }
+    return i;
+}
+#endif
+
+void computePriorities(const LinearPriority& priority, const Crop* crops, int count, int* out) {
+    int done = 0;
+#ifdef HAVE_AVX2_KERNEL
+    static const bool hasAVX2 = __builtin_cpu_supports("avx2");
+    if(hasAVX2) {
+        done = computeAVX2(priority, crops, count, out);
+    }
+#endif
+    computeScalar(priority, crops + done, count - done, out + done);
+}
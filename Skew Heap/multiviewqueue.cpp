@@ -0,0 +1,180 @@
+#include "multiviewqueue.h"
+
+// The comparison the std heap algorithms want: true if left belongs below right
+class EntryBelow{
+    public:
+    EntryBelow(HEAPTYPE heapType) {m_heapType = heapType;}
+    template <class Entry>
+    bool operator()(const Entry& left, const Entry& right) const {
+        if(m_heapType == MAXHEAP) {
+            return left.m_priority < right.m_priority;
+        }
+        return left.m_priority > right.m_priority;
+    }
+    private:
+    HEAPTYPE m_heapType;
+};
+
+MultiViewQueue::MultiViewQueue() {
+    m_size = 0;
+}
+
+int MultiViewQueue::addView(prifn_t priFn, HEAPTYPE heapType) {
+    View view;
+    view.m_priorFunc = priFn;
+    view.m_heapType = heapType;
+
+    // every live slot gets an entry, then the heap is built bottom-up
+    vector<bool> freed(m_crops.size(), false);
+    for(unsigned int i = 0; i < m_freeSlots.size(); i++) {
+        freed[m_freeSlots[i]] = true;
+    }
+    view.m_heap.reserve(m_size);
+    for(unsigned int slot = 0; slot < m_crops.size(); slot++) {
+        if(freed[slot]) {
+            continue;
+        }
+        Entry entry = {priFn(m_crops[slot]), (int)slot, m_generations[slot]};
+        view.m_heap.push_back(entry);
+    }
+    make_heap(view.m_heap.begin(), view.m_heap.end(), EntryBelow(view.m_heapType));
+
+    m_views.push_back(view);
+    return m_views.size() - 1;
+}
+
+void MultiViewQueue::insertCrop(const Crop& crop) {
+    int slot;
+    if(!m_freeSlots.empty()) {
+        slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+        m_crops[slot] = crop;
+    } else {
+        slot = m_crops.size();
+        m_crops.push_back(crop);
+        m_generations.push_back(0);
+    }
+
+    for(unsigned int v = 0; v < m_views.size(); v++) {
+        Entry entry = {m_views[v].m_priorFunc(crop), slot, m_generations[slot]};
+        push(m_views[v], entry);
+    }
+    m_size++;
+}
+
+Crop MultiViewQueue::getNextCrop(int view) {
+    checkView(view);
+    if(m_size == 0) {
+        throw std::domain_error("You are attempting to get next crop from an empty multi-view queue!");
+    }
+
+    View& current = m_views[view];
+    skipStale(current);
+    int slot = current.m_heap[0].m_slot;
+    pop(current);
+
+    // the other views find out when this entry reaches their top
+    m_generations[slot]++;
+    m_freeSlots.push_back(slot);
+    m_size--;
+
+    for(unsigned int v = 0; v < m_views.size(); v++) {
+        if((int)m_views[v].m_heap.size() > 2 * m_size + COMPACTSLACK) {
+            compact(m_views[v]);
+        }
+    }
+    return m_crops[slot];
+}
+
+int MultiViewQueue::getNextPriority(int view) {
+    checkView(view);
+    if(m_size == 0) {
+        throw std::domain_error("You are attempting to look at the next crop of an empty multi-view queue!");
+    }
+
+    skipStale(m_views[view]);
+    return m_views[view].m_heap[0].m_priority;
+}
+
+void MultiViewQueue::clear() {
+    m_crops.clear();
+    m_generations.clear();
+    m_freeSlots.clear();
+    for(unsigned int v = 0; v < m_views.size(); v++) {
+        m_views[v].m_heap.clear();
+    }
+    m_size = 0;
+}
+
+int MultiViewQueue::numCrops() const {
+    return m_size;
+}
+
+int MultiViewQueue::numViews() const {
+    return m_views.size();
+}
+
+prifn_t MultiViewQueue::getPriorityFn(int view) const {
+    checkView(view);
+    return m_views[view].m_priorFunc;
+}
+
+HEAPTYPE MultiViewQueue::getHeapType(int view) const {
+    checkView(view);
+    return m_views[view].m_heapType;
+}
+
+void MultiViewQueue::dump() const {
+    if(m_size == 0) {
+        cout << "Empty multi-view queue.\n";
+        return;
+    }
+
+    // live entries of every view in array order, stale ones are not shown
+    for(unsigned int v = 0; v < m_views.size(); v++) {
+        cout << "view " << v << ": [";
+        bool first = true;
+        for(unsigned int i = 0; i < m_views[v].m_heap.size(); i++) {
+            const Entry& entry = m_views[v].m_heap[i];
+            if(!isLive(entry)) {
+                continue;
+            }
+            cout << (first ? "" : " ") << entry.m_priority << ":" << m_crops[entry.m_slot].getCropID();
+            first = false;
+        }
+        cout << "]" << endl;
+    }
+}
+
+void MultiViewQueue::checkView(int view) const {
+    if(view < 0 || view >= (int)m_views.size()) {
+        throw std::out_of_range("There is no such view in the multi-view queue!");
+    }
+}
+
+void MultiViewQueue::skipStale(View& view) {
+    while(!view.m_heap.empty() && !isLive(view.m_heap[0])) {
+        pop(view);
+    }
+}
+
+void MultiViewQueue::compact(View& view) {
+    unsigned int kept = 0;
+    for(unsigned int i = 0; i < view.m_heap.size(); i++) {
+        if(isLive(view.m_heap[i])) {
+            view.m_heap[kept++] = view.m_heap[i];
+        }
+    }
+    view.m_heap.resize(kept);
+    make_heap(view.m_heap.begin(), view.m_heap.end(), EntryBelow(view.m_heapType));
+}
+
+void MultiViewQueue::push(View& view, const Entry& entry) {
+    view.m_heap.push_back(entry);
+    push_heap(view.m_heap.begin(), view.m_heap.end(), EntryBelow(view.m_heapType));
+}
+
+void MultiViewQueue::pop(View& view) {
+    pop_heap(view.m_heap.begin(), view.m_heap.end(), EntryBelow(view.m_heapType));
+    view.m_heap.pop_back();
+}
@@ -0,0 +1,71 @@
+// Date Created: November, 2022
+// One set of crops served in several priority orders at once, say "most
+// urgent by heat" (priorityFn1, MAXHEAP) next to "most urgent by dryness"
+// (priorityFn2, MINHEAP). Every Crop is stored once in a slot. Each view is
+// an implicit binary heap of small (priority, slot, generation) entries.
+//
+// Popping a crop from one view only frees its slot. The entries the other
+// views hold for it are recognised as stale when they reach the top (the
+// slot's generation moved on) and thrown away then. A view whose heap is
+// more than half stale entries is rebuilt, so memory stays O(views * n).
+#ifndef MULTIVIEWQUEUE_H
+#define MULTIVIEWQUEUE_H
+#include "iqueue.h"
+
+const int COMPACTSLACK = 64; // stale entries a view may always hold before it is rebuilt
+
+class MultiViewQueue{
+    public:
+    friend class Grader; // for grading purposes
+    friend class Tester; // for testing purposes
+
+    MultiViewQueue();
+    // Adds a view and returns its number. Crops already in the queue are
+    // added to it in O(n)
+    int addView(prifn_t priFn, HEAPTYPE heapType);
+    void insertCrop(const Crop& crop); // O(views * log n)
+    // Takes the highest priority crop of view out of every view, amortized
+    // O(log n). Throws domain_error if empty, out_of_range for a bad view
+    Crop getNextCrop(int view);
+    // Priority of the crop getNextCrop(view) would return
+    int getNextPriority(int view);
+    void clear();
+    int numCrops() const;
+    int numViews() const;
+    prifn_t getPriorityFn(int view) const;
+    HEAPTYPE getHeapType(int view) const;
+    void dump() const; // For debugging purposes
+
+    private:
+    class Entry{
+        public:
+        int m_priority;
+        int m_slot;             // where the crop is in m_crops
+        unsigned int m_generation; // m_generations[m_slot] when the entry was made
+    };
+
+    class View{
+        public:
+        prifn_t m_priorFunc;
+        HEAPTYPE m_heapType;
+        vector<Entry> m_heap;   // implicit binary heap, may hold stale entries
+    };
+
+    vector<Crop> m_crops;               // the crops, a freed slot keeps its old crop
+    vector<unsigned int> m_generations; // bumped every time a slot is freed
+    vector<int> m_freeSlots;            // slots getNextCrop freed, reused first
+    vector<View> m_views;
+    int m_size;                         // live crops
+
+    bool isLive(const Entry& entry) const {
+        return m_generations[entry.m_slot] == entry.m_generation;
+    };
+    void checkView(int view) const; // throws out_of_range
+    // drops stale entries from the top of view until a live one is there
+    void skipStale(View& view);
+    // rebuilds the heap of view from its live entries, O(entries)
+    void compact(View& view);
+    void push(View& view, const Entry& entry);
+    void pop(View& view);
+};
+#endif
@@ -0,0 +1,820 @@
+//benchmark driver for iqueue.cpp
+//usage: mybench <benchmark> [number of crops]
+
+#include "iqueue.h"
+#include "daryheap.h"
+#include "bucketqueue.h"
+#include "concurrentqueue.h"
+#include "persistentqueue.h"
+#include "linearpriority.h"
+#include "multiviewqueue.h"
+#include "boundedqueue.h"
+#include "externalqueue.h"
+#include "cropfile.h"
+#include <chrono>
+#include <fstream>
+#include <random>
+#include <cstdlib>
+#include <pthread.h>
+#include <thread>
+#include <mutex>
+// the same sample priority functions mytest.cpp uses
+int priorityFn1(const Crop &crop);// works with a MAXHEAP
+int priorityFn2(const Crop &crop);// works with a MINHEAP
+
+const size_t SMALLSTACK = 256 * 1024; // bytes of stack the stack-safety benchmarks get
+
+enum ORDER {SORTED, REVERSESORTED, SHUFFLED};
+
+// builds numCrops crops whose priorityFn1 value follows order
+vector<Crop> makeCrops(int numCrops, ORDER order) {
+    vector<Crop> crops;
+    crops.reserve(numCrops);
+    mt19937 generator(10);// 10 is the fixed seed value
+    for (int i = 0; i < numCrops; i++) {
+        int step = (int)((long long)i * (MAXTEMP - MINTEMP + 1) / numCrops);
+        int temperature = (order == REVERSESORTED) ? MAXTEMP - step : MINTEMP + step;
+        if (order == SHUFFLED)
+            temperature = MINTEMP + generator() % (MAXTEMP - MINTEMP + 1);
+        crops.push_back(Crop(MINCROPID + i % (MAXCROPID - MINCROPID + 1), temperature,
+                             generator() % (MAXMOISTURE + 1), generator() % (MAXTIME + 1), BEAN));
+    }
+    return crops;
+}
+
+// times a single call of fn in milliseconds
+template <class Fn>
+double timeIt(Fn fn) {
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    fn();
+    chrono::steady_clock::time_point stop = chrono::steady_clock::now();
+    return chrono::duration<double, milli>(stop - start).count();
+}
+
+// runs fn on a thread that only has SMALLSTACK bytes of stack, a recursive
+// walk down a long right spine would crash it
+template <class Fn>
+bool runOnSmallStack(Fn& fn) {
+    pthread_attr_t attributes;
+    pthread_attr_init(&attributes);
+    pthread_attr_setstacksize(&attributes, SMALLSTACK);
+    pthread_t thread;
+    bool started = pthread_create(&thread, &attributes,
+                                  [](void* arg) -> void* { (*(Fn*)arg)(); return nullptr; }, &fn) == 0;
+    pthread_attr_destroy(&attributes);
+    if (started)
+        pthread_join(thread, nullptr);
+    return started;
+}
+
+// the same two priority functions as compile time policies
+class Fn1Priority{
+    public:
+    int operator()(const Crop& crop) const {return priorityFn1(crop);}
+};
+class Fn2Priority{
+    public:
+    int operator()(const Crop& crop) const {return priorityFn2(crop);}
+};
+
+// inserts every crop and pops them all again, returns the time of both
+template <class Queue>
+double insertAndDrain(Queue& queue, const vector<Crop>& crops) {
+    return timeIt([&]() {
+        for (unsigned int i = 0; i < crops.size(); i++)
+            queue.insertCrop(crops[i]);
+        while (queue.numCrops() > 0)
+            queue.getNextCrop();
+    });
+}
+
+void benchPolicy(int numCrops) {
+    vector<Crop> crops = makeCrops(numCrops, SHUFFLED);
+
+    IQueue runtime1(priorityFn1, MAXHEAP);
+    BasicIQueue<Fn1Priority, MaxOrder> static1;
+    IQueue runtime2(priorityFn2, MINHEAP);
+    BasicIQueue<Fn2Priority, MinOrder> static2;
+
+    // one untimed round each so every pool already has its chunks
+    insertAndDrain(runtime1, crops);
+    insertAndDrain(static1, crops);
+    insertAndDrain(runtime2, crops);
+    insertAndDrain(static2, crops);
+
+    cout << numCrops << " shuffled crops, insert all then pop all" << endl;
+    cout << "priorityFn1, MAXHEAP | IQueue: " << insertAndDrain(runtime1, crops)
+         << " ms, BasicIQueue<Fn1Priority, MaxOrder>: " << insertAndDrain(static1, crops) << " ms" << endl;
+    cout << "priorityFn2, MINHEAP | IQueue: " << insertAndDrain(runtime2, crops)
+         << " ms, BasicIQueue<Fn2Priority, MinOrder>: " << insertAndDrain(static2, crops) << " ms" << endl;
+}
+
+// keeps numCrops crops queued and replaces the top one 4 * numCrops times
+template <class Queue>
+double churn(Queue& queue, const vector<Crop>& crops) {
+    for (unsigned int i = 0; i < crops.size(); i++)
+        queue.insertCrop(crops[i]);
+    double elapsed = timeIt([&]() {
+        for (unsigned int i = 0; i < 4 * crops.size(); i++) {
+            queue.getNextCrop();
+            queue.insertCrop(crops[(i * 7919) % crops.size()]);
+        }
+    });
+    queue.clear();
+    return elapsed;
+}
+
+void benchEngines(int numCrops) {
+    vector<Crop> crops = makeCrops(numCrops, SHUFFLED);
+    const char* names[3] = {"SKEWHEAP", "DARYHEAP4", "DARYHEAP8"};
+    ENGINE engines[3] = {SKEWHEAP, DARYHEAP4, DARYHEAP8};
+
+    cout << numCrops << " shuffled crops, priorityFn2, MINHEAP" << endl;
+    for (int e = 0; e < 3; e++) {
+        IQueue queue(priorityFn2, MINHEAP, engines[e]);
+        insertAndDrain(queue, crops); // warm up
+        double fill = insertAndDrain(queue, crops);
+        double steady = churn(queue, crops);
+        cout << "IQueue " << names[e] << " | insert all then pop all: " << fill
+             << " ms, pop+insert churn: " << steady << " ms" << endl;
+    }
+
+    BasicIQueue<Fn2Priority, MinOrder> skew;
+    DaryIQueue<Fn2Priority, MinOrder, 4> dary4;
+    DaryIQueue<Fn2Priority, MinOrder, 8> dary8;
+    insertAndDrain(skew, crops);
+    insertAndDrain(dary4, crops);
+    insertAndDrain(dary8, crops);
+    cout << "BasicIQueue            | insert all then pop all: " << insertAndDrain(skew, crops)
+         << " ms, pop+insert churn: " << churn(skew, crops) << " ms" << endl;
+    cout << "DaryIQueue<4>          | insert all then pop all: " << insertAndDrain(dary4, crops)
+         << " ms, pop+insert churn: " << churn(dary4, crops) << " ms" << endl;
+    cout << "DaryIQueue<8>          | insert all then pop all: " << insertAndDrain(dary8, crops)
+         << " ms, pop+insert churn: " << churn(dary8, crops) << " ms" << endl;
+}
+
+void benchBuckets(int numCrops) {
+    vector<Crop> crops = makeCrops(numCrops, SHUFFLED);
+
+    IQueue skew1(priorityFn1, MAXHEAP);
+    IQueue dary1(priorityFn1, MAXHEAP, DARYHEAP4);
+    IQueue bucket1(priorityFn1, MAXHEAP, 30, 116);
+    IQueue skew2(priorityFn2, MINHEAP);
+    IQueue dary2(priorityFn2, MINHEAP, DARYHEAP4);
+    IQueue bucket2(priorityFn2, MINHEAP, 0, 103);
+    IQueue* queues[6] = {&skew1, &dary1, &bucket1, &skew2, &dary2, &bucket2};
+    const char* names[6] = {"priorityFn1, MAXHEAP, SKEWHEAP   ", "priorityFn1, MAXHEAP, DARYHEAP4  ",
+                            "priorityFn1, MAXHEAP, BUCKETQUEUE", "priorityFn2, MINHEAP, SKEWHEAP   ",
+                            "priorityFn2, MINHEAP, DARYHEAP4  ", "priorityFn2, MINHEAP, BUCKETQUEUE"};
+
+    cout << numCrops << " shuffled crops" << endl;
+    for (int q = 0; q < 6; q++) {
+        insertAndDrain(*queues[q], crops); // warm up
+        double fill = insertAndDrain(*queues[q], crops);
+        double steady = churn(*queues[q], crops);
+        cout << "IQueue " << names[q] << " | insert all then pop all: " << fill
+             << " ms, pop+insert churn: " << steady << " ms" << endl;
+    }
+
+    BucketIQueue<Fn1Priority, MaxOrder> static1(30, 116);
+    BucketIQueue<Fn2Priority, MinOrder> static2(0, 103);
+    insertAndDrain(static1, crops);
+    insertAndDrain(static2, crops);
+    cout << "BucketIQueue<Fn1Priority, MaxOrder>      | insert all then pop all: " << insertAndDrain(static1, crops)
+         << " ms, pop+insert churn: " << churn(static1, crops) << " ms" << endl;
+    cout << "BucketIQueue<Fn2Priority, MinOrder>      | insert all then pop all: " << insertAndDrain(static2, crops)
+         << " ms, pop+insert churn: " << churn(static2, crops) << " ms" << endl;
+}
+
+void benchBulkLoad(int numCrops) {
+    vector<Crop> crops = makeCrops(numCrops, SHUFFLED);
+    const char* names[3] = {"SKEWHEAP   ", "DARYHEAP4  ", "BUCKETQUEUE"};
+
+    cout << numCrops << " shuffled crops, priorityFn2, MINHEAP" << endl;
+    for (int e = 0; e < 3; e++) {
+        double oneByOne = 0, bulk = 0;
+        // a fresh queue for each run, so neither run reuses the other's memory
+        for (int run = 0; run < 2; run++) {
+            IQueue* queue = (e == 2) ? new IQueue(priorityFn2, MINHEAP, 0, 103)
+                                     : new IQueue(priorityFn2, MINHEAP, e == 0 ? SKEWHEAP : DARYHEAP4);
+            if (run == 0) {
+                oneByOne = timeIt([&]() {
+                    for (unsigned int i = 0; i < crops.size(); i++)
+                        queue->insertCrop(crops[i]);
+                });
+            } else {
+                bulk = timeIt([&]() { queue->insertCrops(crops.data(), crops.size()); });
+            }
+            delete queue;
+        }
+        cout << "IQueue " << names[e] << " | insertCrop one by one: " << oneByOne
+             << " ms, insertCrops: " << bulk << " ms" << endl;
+    }
+}
+
+// what setPriorityFn used to do: copy the queue, then pop every crop
+// from the copy into the emptied original
+void rebuildByReinsert(IQueue& queue, prifn_t priFn, HEAPTYPE heapType) {
+    IQueue oldQueue(queue);
+    queue.clear();
+    queue.setPriorityFn(priFn, heapType);
+    while (oldQueue.numCrops() > 0)
+        queue.insertCrop(oldQueue.getNextCrop());
+}
+
+void benchRebuild(int numCrops) {
+    vector<Crop> crops = makeCrops(numCrops, SHUFFLED);
+    IQueue inPlace(priorityFn2, MINHEAP, crops);
+    IQueue reinsert(priorityFn2, MINHEAP, crops);
+    double inPlaceTime = 0, reinsertTime = 0;
+    const int SWITCHES = 6;
+
+    // moisture driven, temperature driven, and back again
+    for (int s = 0; s < SWITCHES; s++) {
+        prifn_t priFn = (s % 2 == 0) ? priorityFn1 : priorityFn2;
+        HEAPTYPE heapType = (s % 2 == 0) ? MAXHEAP : MINHEAP;
+        inPlaceTime += timeIt([&]() { inPlace.setPriorityFn(priFn, heapType); });
+        reinsertTime += timeIt([&]() { rebuildByReinsert(reinsert, priFn, heapType); });
+    }
+
+    cout << numCrops << " crops, " << SWITCHES << " switches between priorityFn1 and priorityFn2" << endl;
+    cout << "setPriorityFn in place: " << inPlaceTime / SWITCHES << " ms per switch" << endl;
+    cout << "copy, pop and reinsert: " << reinsertTime / SWITCHES << " ms per switch" << endl;
+}
+
+void benchUpdate(int numCrops) {
+    if (numCrops > MAXCROPID - MINCROPID + 1) {
+        cout << "at most " << MAXCROPID - MINCROPID + 1 << " crops have unique IDs" << endl;
+        return;
+    }
+    vector<Crop> crops = makeCrops(numCrops, SHUFFLED);
+    for (int i = 0; i < numCrops; i++) // the index needs unique IDs
+        crops[i] = Crop(MINCROPID + i, crops[i].getTemperature(),
+                        crops[i].getMoisture(), crops[i].getTime(), crops[i].getType());
+
+    IQueue plain(priorityFn2, MINHEAP);
+    IQueue indexed(priorityFn2, MINHEAP);
+    indexed.enableCropIndex();
+    double plainFill = timeIt([&]() { for (int i = 0; i < numCrops; i++) plain.insertCrop(crops[i]); });
+    double indexedFill = timeIt([&]() { for (int i = 0; i < numCrops; i++) indexed.insertCrop(crops[i]); });
+
+    // fresh sensor readings for random crops
+    mt19937 generator(10);// 10 is the fixed seed value
+    vector<int> ids(numCrops);
+    vector<Crop> readings(numCrops);
+    for (int i = 0; i < numCrops; i++) {
+        Crop& crop = crops[generator() % numCrops];
+        ids[i] = crop.getCropID();
+        readings[i] = Crop(crop.getCropID(), MINTEMP + generator() % (MAXTEMP - MINTEMP + 1),
+                           generator() % (MAXMOISTURE + 1), crop.getTime(), crop.getType());
+    }
+    double updates = timeIt([&]() { for (int i = 0; i < numCrops; i++) indexed.updateCrop(ids[i], readings[i]); });
+    double removes = timeIt([&]() { for (int i = 0; i < numCrops / 2; i++) indexed.removeCrop(crops[i].getCropID()); });
+
+    cout << numCrops << " crops with unique IDs, priorityFn2, MINHEAP" << endl;
+    cout << "insertCrop without index: " << plainFill << " ms, with index: " << indexedFill << " ms" << endl;
+    cout << numCrops << " updateCrop by ID: " << updates << " ms, " << numCrops / 2
+         << " removeCrop by ID: " << removes << " ms" << endl;
+}
+
+// watered crops are wetter, they go back further down the queue
+void freshReadings(vector<Crop>& crops) {
+    for (unsigned int i = 0; i < crops.size(); i++)
+        crops[i] = Crop(crops[i].getCropID(), crops[i].getTemperature(), (crops[i].getMoisture() + 37) % (MAXMOISTURE + 1),
+                        crops[i].getTime(), crops[i].getType());
+}
+
+void benchTopK(int numCrops) {
+    vector<Crop> crops = makeCrops(numCrops, SHUFFLED);
+    const int K = 64;
+    const int CYCLES = 2000;
+    vector<Crop> batch(K);
+
+    cout << numCrops << " crops, " << CYCLES << " cycles of " << K << " crops taken out and put back" << endl;
+    ENGINE engines[3] = {SKEWHEAP, DARYHEAP4, BUCKETQUEUE};
+    const char* names[3] = {"SKEWHEAP   ", "DARYHEAP4  ", "BUCKETQUEUE"};
+    for (int e = 0; e < 3; e++) {
+        IQueue* loop = (e == 2) ? new IQueue(priorityFn2, MINHEAP, 0, 103) : new IQueue(priorityFn2, MINHEAP, engines[e]);
+        IQueue* batched = (e == 2) ? new IQueue(priorityFn2, MINHEAP, 0, 103) : new IQueue(priorityFn2, MINHEAP, engines[e]);
+        loop->insertCrops(crops.data(), numCrops);
+        batched->insertCrops(crops.data(), numCrops);
+
+        // the dispatched crops come back with fresh readings on the next cycle
+        double loopTime = timeIt([&]() {
+            for (int c = 0; c < CYCLES; c++) {
+                for (int i = 0; i < K; i++)
+                    batch[i] = loop->getNextCrop();
+                freshReadings(batch);
+                loop->insertCrops(batch.data(), K);
+            }
+        });
+        double batchTime = timeIt([&]() {
+            for (int c = 0; c < CYCLES; c++) {
+                batched->getNextCrops(K, batch.data());
+                freshReadings(batch);
+                batched->insertCrops(batch.data(), K);
+            }
+        });
+        double peekTime = timeIt([&]() {
+            for (int c = 0; c < CYCLES; c++)
+                batched->peekTopK(K, batch.data());
+        });
+        cout << "IQueue " << names[e] << " | getNextCrop x" << K << ": " << loopTime << " ms, getNextCrops: "
+             << batchTime << " ms, peekTopK: " << peekTime << " ms" << endl;
+        delete loop;
+        delete batched;
+    }
+}
+
+// every thread inserts its share of the crops and then pops as many back
+template <class Fn>
+double runThreads(int numThreads, Fn work) {
+    return timeIt([&]() {
+        vector<thread> threads;
+        for (int t = 0; t < numThreads; t++)
+            threads.push_back(thread(work, t));
+        for (int t = 0; t < numThreads; t++)
+            threads[t].join();
+    });
+}
+
+void benchConcurrent(int numCrops) {
+    vector<Crop> crops = makeCrops(numCrops, SHUFFLED);
+
+    cout << numCrops << " crops inserted and popped, " << thread::hardware_concurrency() << " hardware threads" << endl;
+    for (int numThreads = 1; numThreads <= 64; numThreads *= 2) {
+        int perThread = numCrops / numThreads;
+
+        // one IQueue behind one mutex
+        IQueue locked(priorityFn2, MINHEAP);
+        mutex lock;
+        double lockedTime = runThreads(numThreads, [&](int t) {
+            for (int i = t * perThread; i < (t + 1) * perThread; i++) {
+                lock_guard<mutex> guard(lock);
+                locked.insertCrop(crops[i]);
+            }
+            for (int i = 0; i < perThread; i++) {
+                lock_guard<mutex> guard(lock);
+                locked.getNextCrop();
+            }
+        });
+
+        ConcurrentIQueue relaxed(priorityFn2, MINHEAP, numThreads);
+        double relaxedTime = runThreads(numThreads, [&](int t) {
+            for (int i = t * perThread; i < (t + 1) * perThread; i++)
+                relaxed.insertCrop(crops[i]);
+            Crop crop;
+            for (int i = 0; i < perThread; i++)
+                relaxed.getNextCrop(crop);
+        });
+
+        double operations = 2.0 * perThread * numThreads / 1000.0; // thousands
+        cout << numThreads << " threads | locked IQueue: " << lockedTime << " ms (" << operations / lockedTime
+             << " Mops/s), ConcurrentIQueue: " << relaxedTime << " ms (" << operations / relaxedTime << " Mops/s)" << endl;
+    }
+}
+
+void benchHandOff(int numCrops) {
+    vector<Crop> crops = makeCrops(numCrops, SHUFFLED);
+    const int STAGES = 10;
+
+    // the queue goes through STAGES pipeline stages, each takes it by value
+    cout << numCrops << " crops handed through " << STAGES << " stages" << endl;
+    IQueue copied(priorityFn2, MINHEAP, crops);
+    double copyTime = timeIt([&]() {
+        for (int i = 0; i < STAGES; i++) {
+            IQueue stage(copied);
+            copied = stage;
+        }
+    });
+    IQueue moved(priorityFn2, MINHEAP, crops);
+    double moveTime = timeIt([&]() {
+        for (int i = 0; i < STAGES; i++) {
+            IQueue stage(std::move(moved));
+            moved = std::move(stage);
+        }
+    });
+    cout << "copy: " << copyTime << " ms, move: " << moveTime << " ms, "
+         << copied.numCrops() << " and " << moved.numCrops() << " crops at the end" << endl;
+}
+
+// builds one queue per zone, each with its share of the crops
+vector<IQueue*> makeZones(const vector<Crop>& crops, int numZones, ENGINE engine) {
+    vector<IQueue*> zones;
+    int perZone = crops.size() / numZones;
+    for (int z = 0; z < numZones; z++) {
+        zones.push_back(new IQueue(priorityFn2, MINHEAP, engine));
+        zones.back()->insertCrops(crops.data() + z * perZone, perZone);
+    }
+    return zones;
+}
+
+void benchMergeAll(int numCrops) {
+    vector<Crop> crops = makeCrops(numCrops, SHUFFLED);
+    const int ZONES = 64;
+
+    cout << numCrops << " crops in " << ZONES << " zones" << endl;
+    ENGINE engines[2] = {SKEWHEAP, DARYHEAP4};
+    const char* names[2] = {"SKEWHEAP ", "DARYHEAP4"};
+    for (int e = 0; e < 2; e++) {
+        vector<IQueue*> zones = makeZones(crops, ZONES, engines[e]);
+        double chainTime = timeIt([&]() {
+            for (int z = 1; z < ZONES; z++)
+                zones[0]->mergeWithQueue(*zones[z]);
+        });
+        for (int z = 0; z < ZONES; z++)
+            delete zones[z];
+
+        double treeTimes[2];
+        int threads[2] = {1, 4};
+        for (int t = 0; t < 2; t++) {
+            zones = makeZones(crops, ZONES, engines[e]);
+            treeTimes[t] = timeIt([&]() {
+                zones[0]->mergeAll(zones.data() + 1, ZONES - 1, threads[t]);
+            });
+            for (int z = 0; z < ZONES; z++)
+                delete zones[z];
+        }
+        cout << "IQueue " << names[e] << " | mergeWithQueue chain: " << chainTime << " ms, mergeAll: "
+             << treeTimes[0] << " ms, mergeAll on 4 threads: " << treeTimes[1] << " ms" << endl;
+    }
+}
+
+void benchSnapshot(int numCrops) {
+    typedef PersistentIQueue<FnPriority, HeapOrder> Snapshots;
+    vector<Crop> crops = makeCrops(numCrops, SHUFFLED);
+    const int SNAPSHOTS = 20;
+    const int CHANGES = 1000; // crops dispatched and put back between snapshots
+
+    cout << numCrops << " crops, " << SNAPSHOTS << " snapshots " << CHANGES << " changes apart" << endl;
+    IQueue queue(priorityFn2, MINHEAP, crops);
+    vector<IQueue*> copies;
+    double copyTime = timeIt([&]() {
+        for (int s = 0; s < SNAPSHOTS; s++) {
+            copies.push_back(new IQueue(queue));
+            for (int i = 0; i < CHANGES; i++)
+                queue.insertCrop(queue.getNextCrop());
+        }
+    });
+    for (int s = 0; s < SNAPSHOTS; s++)
+        delete copies[s];
+
+    Snapshots version(crops.data(), numCrops, FnPriority(priorityFn2), HeapOrder(MINHEAP));
+    vector<Snapshots> snapshots;
+    double persistentTime = timeIt([&]() {
+        for (int s = 0; s < SNAPSHOTS; s++) {
+            snapshots.push_back(version);
+            for (int i = 0; i < CHANGES; i++) {
+                Crop next = version.getNextCrop();
+                version = version.removeNextCrop().insertCrop(next);
+            }
+        }
+    });
+    cout << "IQueue copies: " << copyTime << " ms, PersistentIQueue versions: " << persistentTime << " ms" << endl;
+}
+
+void benchLinear(int numCrops) {
+    vector<Crop> crops = makeCrops(numCrops, SHUFFLED);
+    vector<int> priorities(numCrops);
+    LinearPriority dryness(0, 0, 1, 1, 0); // priorityFn2
+    const int ROUNDS = 10;
+
+    cout << numCrops << " crops of " << sizeof(Crop) << " bytes, " << sizeof(Node) << " byte Nodes" << endl;
+    double fnTime = timeIt([&]() {
+        for (int r = 0; r < ROUNDS; r++)
+            computePriorities(FnPriority(priorityFn2), crops.data(), numCrops, priorities.data());
+    });
+    double linearTime = timeIt([&]() {
+        for (int r = 0; r < ROUNDS; r++)
+            computePriorities(dryness, crops.data(), numCrops, priorities.data());
+    });
+    cout << "priorities x" << ROUNDS << " | priorityFn2: " << fnTime << " ms, LinearPriority: " << linearTime << " ms" << endl;
+
+    FnPriority dryFn(priorityFn2);
+    DaryIQueue<FnPriority, HeapOrder, 4> fnQueue(dryFn, HeapOrder(MINHEAP));
+    DaryIQueue<LinearPriority, HeapOrder, 4> linearQueue(dryness, HeapOrder(MINHEAP));
+    double fnLoad = timeIt([&]() {fnQueue.insertCrops(crops.data(), numCrops);});
+    double linearLoad = timeIt([&]() {linearQueue.insertCrops(crops.data(), numCrops);});
+    double fnRebuild = timeIt([&]() {fnQueue.setPriority(FnPriority(priorityFn1), HeapOrder(MAXHEAP));});
+    double linearRebuild = timeIt([&]() {linearQueue.setPriority(LinearPriority(0, 1, 0, 0, 1), HeapOrder(MAXHEAP));});
+    cout << "DaryIQueue 4 insertCrops | priorityFn2: " << fnLoad << " ms, LinearPriority: " << linearLoad << " ms" << endl;
+    cout << "DaryIQueue 4 setPriority | priorityFn1: " << fnRebuild << " ms, LinearPriority: " << linearRebuild << " ms" << endl;
+
+    IQueue fnIQueue(priorityFn2, MINHEAP, DARYHEAP4);
+    IQueue linearIQueue(priorityFn2, MINHEAP, DARYHEAP4);
+    linearIQueue.setPriorityFn(priorityFn2, MINHEAP, dryness);
+    double fnIQueueLoad = timeIt([&]() {fnIQueue.insertCrops(crops.data(), numCrops);});
+    double linearIQueueLoad = timeIt([&]() {linearIQueue.insertCrops(crops.data(), numCrops);});
+    cout << "IQueue DARYHEAP4 insertCrops | priorityFn2: " << fnIQueueLoad << " ms, with LinearPriority: "
+         << linearIQueueLoad << " ms" << endl;
+}
+
+void benchViews(int numCrops) {
+    vector<Crop> crops = makeCrops(numCrops, SHUFFLED);
+    for (int i = 0; i < numCrops; i++) // the indexed IQueues need unique IDs
+        crops[i] = Crop(MINCROPID + i % (MAXCROPID - MINCROPID + 1), crops[i].getTemperature(),
+                        crops[i].getMoisture(), crops[i].getTime(), crops[i].getType());
+
+    cout << numCrops << " crops served by heat and by dryness, pops alternate between the two" << endl;
+    IQueue byHeat(priorityFn1, MAXHEAP);
+    IQueue byDryness(priorityFn2, MINHEAP);
+    byHeat.enableCropIndex();
+    byDryness.enableCropIndex();
+    double twoQueues = timeIt([&]() {
+        byHeat.insertCrops(crops.data(), numCrops);
+        byDryness.insertCrops(crops.data(), numCrops);
+        for (int i = 0; i < numCrops; i++) {
+            IQueue& from = (i % 2 == 0) ? byHeat : byDryness;
+            IQueue& other = (i % 2 == 0) ? byDryness : byHeat;
+            other.removeCrop(from.getNextCrop().getCropID());
+        }
+    });
+
+    MultiViewQueue views;
+    int heat = views.addView(priorityFn1, MAXHEAP);
+    int dryness = views.addView(priorityFn2, MINHEAP);
+    double multiView = timeIt([&]() {
+        for (int i = 0; i < numCrops; i++)
+            views.insertCrop(crops[i]);
+        for (int i = 0; i < numCrops; i++)
+            views.getNextCrop(i % 2 == 0 ? heat : dryness);
+    });
+    cout << "two indexed IQueues: " << twoQueues << " ms, MultiViewQueue: " << multiView << " ms" << endl;
+    cout << "bytes per crop | two IQueues: " << 2 * sizeof(Node) << " plus two index entries, MultiViewQueue: "
+         << sizeof(Crop) + sizeof(unsigned int) + 2 * 3 * sizeof(int) << endl;
+}
+
+void benchMinMax(int numCrops) {
+    vector<Crop> crops = makeCrops(numCrops, SHUFFLED);
+    for (int i = 0; i < numCrops; i++) // the indexed IQueues need unique IDs
+        crops[i] = Crop(MINCROPID + i % (MAXCROPID - MINCROPID + 1), crops[i].getTemperature(),
+                        crops[i].getMoisture(), crops[i].getTime(), crops[i].getType());
+    int capacity = numCrops / 2;
+
+    // the first half fills the queue, then every new crop pushes the least urgent one out
+    // and every fourth round the most urgent one is dispatched
+    cout << numCrops << " crops through a queue capped at " << capacity << endl;
+    IQueue urgent(priorityFn2, MINHEAP);
+    IQueue mirror(priorityFn2, MAXHEAP);
+    urgent.enableCropIndex();
+    mirror.enableCropIndex();
+    double mirrored = timeIt([&]() {
+        urgent.insertCrops(crops.data(), capacity);
+        mirror.insertCrops(crops.data(), capacity);
+        for (int i = capacity; i < numCrops; i++) {
+            urgent.insertCrop(crops[i]);
+            mirror.insertCrop(crops[i]);
+            urgent.removeCrop(mirror.getNextCrop().getCropID());
+            if (i % 4 == 0)
+                mirror.removeCrop(urgent.getNextCrop().getCropID());
+        }
+    });
+
+    IQueue interval(priorityFn2, MINHEAP, INTERVALHEAP);
+    double doubleEnded = timeIt([&]() {
+        interval.insertCrops(crops.data(), capacity);
+        for (int i = capacity; i < numCrops; i++) {
+            interval.insertCrop(crops[i]);
+            interval.getLastCrop();
+            if (i % 4 == 0)
+                interval.getNextCrop();
+        }
+    });
+    cout << "two mirrored indexed IQueues: " << mirrored << " ms, INTERVALHEAP: " << doubleEnded << " ms, "
+         << urgent.numCrops() << " and " << interval.numCrops() << " crops left" << endl;
+}
+
+void benchBounded(int numCrops) {
+    vector<Crop> crops = makeCrops(numCrops, SHUFFLED);
+    const int K = 1000;
+
+    // keep everything and pop the top K at the end
+    cout << "top " << K << " of a stream of " << numCrops << " crops" << endl;
+    Crop fullTop[K];
+    double full = timeIt([&]() {
+        IQueue queue(priorityFn1, MAXHEAP, DARYHEAP4);
+        for (int i = 0; i < numCrops; i++)
+            queue.insertCrop(crops[i]);
+        for (int i = 0; i < K; i++)
+            fullTop[i] = queue.getNextCrop();
+    });
+
+    Crop boundedTop[K];
+    long long rejected = 0;
+    double bounded = timeIt([&]() {
+        BoundedIQueue<FnPriority, HeapOrder> queue(K, FnPriority(priorityFn1), HeapOrder(MAXHEAP));
+        for (int i = 0; i < numCrops; i++)
+            queue.insertCrop(crops[i]);
+        queue.getNextCrops(K, boundedTop);
+        rejected = queue.numRejected();
+    });
+
+    bool same = true;
+    for (int i = 0; i < K; i++)
+        same = same && priorityFn1(fullTop[i]) == priorityFn1(boundedTop[i]);
+    cout << "full DARYHEAP4 IQueue: " << full << " ms, BoundedIQueue: " << bounded << " ms, "
+         << rejected << " rejected, same priorities: " << (same ? "yes" : "no") << endl;
+}
+
+void benchExternal(int numCrops) {
+    vector<Crop> crops = makeCrops(numCrops, SHUFFLED);
+    int memoryCrops = max(numCrops / 10, RUNBLOCK);
+
+    // the input is ten times what the external queue may keep in memory
+    cout << numCrops << " crops, at most " << memoryCrops << " of them in memory" << endl;
+    long long checksum = 0;
+    double inMemory = timeIt([&]() {
+        IQueue queue(priorityFn2, MINHEAP, DARYHEAP4);
+        queue.insertCrops(crops.data(), numCrops);
+        while (queue.numCrops() > 0)
+            checksum += priorityFn2(queue.getNextCrop());
+    });
+
+    long long externalChecksum = 0;
+    long long spilled = 0;
+    int runs = 0;
+    double external = timeIt([&]() {
+        ExternalIQueue queue(priorityFn2, MINHEAP, memoryCrops);
+        for (int i = 0; i < numCrops; i += RUNBLOCK)
+            queue.insertCrops(crops.data() + i, min(RUNBLOCK, numCrops - i));
+        spilled = queue.numSpilled();
+        runs = queue.numRuns();
+        while (queue.numCrops() > 0)
+            externalChecksum += priorityFn2(queue.getNextCrop());
+    });
+    cout << "DARYHEAP4 IQueue: " << inMemory << " ms, ExternalIQueue: " << external << " ms, "
+         << spilled << " crops spilled into " << runs << " runs, priority sums match: "
+         << (checksum == externalChecksum ? "yes" : "no") << endl;
+}
+
+void benchLoad(int numCrops) {
+    vector<Crop> crops = makeCrops(numCrops, SHUFFLED);
+    const char* csvPath = "mybench-crops.csv";
+    const char* binaryPath = "mybench-crops.bin";
+    FILE* csv = fopen(csvPath, "w");
+    FILE* binary = fopen(binaryPath, "wb");
+    unsigned char record[CROPRECORDSIZE];
+    for (int i = 0; i < numCrops; i++) {
+        fprintf(csv, "%d,%d,%d,%d,%d\n", crops[i].getCropID(), crops[i].getTemperature(),
+                crops[i].getMoisture(), crops[i].getTime(), crops[i].getType());
+        encodeCrop(crops[i], record);
+        fwrite(record, CROPRECORDSIZE, 1, binary);
+    }
+    fclose(csv);
+    fclose(binary);
+
+    // what the loading code did before: ifstream, one insertCrop per row
+    cout << numCrops << " crops into a DARYHEAP4 IQueue" << endl;
+    int streamed = 0;
+    double iostreams = timeIt([&]() {
+        IQueue queue(priorityFn2, MINHEAP, DARYHEAP4);
+        ifstream in(csvPath);
+        int id, temperature, moisture, time, type;
+        char comma;
+        while (in >> id >> comma >> temperature >> comma >> moisture >> comma >> time >> comma >> type)
+            queue.insertCrop(Crop(id, temperature, moisture, time, type));
+        streamed = queue.numCrops();
+    });
+
+    int fromCSV = 0;
+    double csvLoad = timeIt([&]() {
+        IQueue queue(priorityFn2, MINHEAP, DARYHEAP4);
+        CropFileLoader loader(csvPath, CSVFILE);
+        loader.loadInto(queue);
+        fromCSV = queue.numCrops();
+    });
+
+    int fromBinary = 0;
+    double binaryLoad = timeIt([&]() {
+        IQueue queue(priorityFn2, MINHEAP, DARYHEAP4);
+        CropFileLoader loader(binaryPath, BINARYFILE);
+        loader.loadInto(queue);
+        fromBinary = queue.numCrops();
+    });
+    remove(csvPath);
+    remove(binaryPath);
+    cout << "ifstream + insertCrop: " << iostreams << " ms, CropFileLoader CSV: " << csvLoad
+         << " ms, binary: " << binaryLoad << " ms (" << streamed << ", " << fromCSV << ", "
+         << fromBinary << " crops)" << endl;
+}
+
+void benchStackSafety(int numCrops) {
+    const char* names[2] = {"sorted", "reverse sorted"};
+    ORDER orders[2] = {SORTED, REVERSESORTED};
+
+    for (int o = 0; o < 2; o++) {
+        vector<Crop> crops = makeCrops(numCrops, orders[o]);
+        double insertTime = 0, copyTime = 0, popTime = 0, clearTime = 0;
+
+        auto work = [&]() {
+            IQueue queue(priorityFn1, MAXHEAP);
+            insertTime = timeIt([&]() {
+                for (unsigned int i = 0; i < crops.size(); i++)
+                    queue.insertCrop(crops[i]);
+            });
+            IQueue* copy = nullptr;
+            copyTime = timeIt([&]() { copy = new IQueue(queue); });
+            clearTime = timeIt([&]() { delete copy; });
+            popTime = timeIt([&]() {
+                while (queue.numCrops() > 0)
+                    queue.getNextCrop();
+            });
+        };
+
+        if (!runOnSmallStack(work)) {
+            cout << "could not start a thread with a small stack" << endl;
+            return;
+        }
+        cout << numCrops << " " << names[o] << " crops on a " << SMALLSTACK / 1024 << " KB stack | insert: "
+             << insertTime << " ms, copy: " << copyTime << " ms, clear: " << clearTime
+             << " ms, pop all: " << popTime << " ms" << endl;
+    }
+}
+
+int main(int argc, char* argv[]){
+    if (argc < 2) {
+        cout << "usage: " << argv[0] << " <benchmark> [number of crops]" << endl;
+        cout << "benchmarks:" << endl;
+        cout << "  stack      sorted and reverse sorted inserts, copy, clear and pops (10M)" << endl;
+        cout << "  policy     IQueue against BasicIQueue with compile time policies (1M)" << endl;
+        cout << "  engines    skew heap against 4-ary and 8-ary heaps, fill/drain and churn (1M)" << endl;
+        cout << "  buckets    bucket queue against skew and 4-ary heaps, fill/drain and churn (1M)" << endl;
+        cout << "  bulk       insertCrop one by one against insertCrops, try 1M-100M crops (1M)" << endl;
+        cout << "  rebuild    setPriorityFn against copying and reinserting every crop (1M)" << endl;
+        cout << "  update     updateCrop and removeCrop by ID on an indexed queue (500K)" << endl;
+        cout << "  topk       getNextCrop k times against getNextCrops and peekTopK (1M)" << endl;
+        cout << "  concurrent one locked IQueue against ConcurrentIQueue, 1 to 64 threads (1M)" << endl;
+        cout << "  handoff    passing a queue between stages by copy and by move (1M)" << endl;
+        cout << "  mergeall   a chain of mergeWithQueue against mergeAll over 64 zones (1M)" << endl;
+        cout << "  snapshot   IQueue copies against PersistentIQueue versions (1M)" << endl;
+        cout << "  linear     priorityFn2 against the batch LinearPriority evaluator (10M)" << endl;
+        cout << "  views      two indexed IQueues against one MultiViewQueue with two views (500K)" << endl;
+        cout << "  minmax     a mirrored MIN/MAX pair of IQueues against the INTERVALHEAP engine (500K)" << endl;
+        cout << "  bounded    top 1000 of a stream, a full IQueue against BoundedIQueue (10M)" << endl;
+        cout << "  external   an in-memory IQueue against ExternalIQueue with a tenth of the crops in memory (10M)" << endl;
+        cout << "  load       ifstream parsing against CropFileLoader on CSV and binary files (5M)" << endl;
+        return 1;
+    }
+
+    string name = argv[1];
+    int numCrops = (argc > 2) ? atoi(argv[2]) : 0;
+
+    if (name == "stack") {
+        benchStackSafety(numCrops > 0 ? numCrops : 10000000);
+    } else if (name == "policy") {
+        benchPolicy(numCrops > 0 ? numCrops : 1000000);
+    } else if (name == "engines") {
+        benchEngines(numCrops > 0 ? numCrops : 1000000);
+    } else if (name == "buckets") {
+        benchBuckets(numCrops > 0 ? numCrops : 1000000);
+    } else if (name == "bulk") {
+        benchBulkLoad(numCrops > 0 ? numCrops : 1000000);
+    } else if (name == "rebuild") {
+        benchRebuild(numCrops > 0 ? numCrops : 1000000);
+    } else if (name == "update") {
+        benchUpdate(numCrops > 0 ? numCrops : 500000);
+    } else if (name == "topk") {
+        benchTopK(numCrops > 0 ? numCrops : 1000000);
+    } else if (name == "concurrent") {
+        benchConcurrent(numCrops > 0 ? numCrops : 1000000);
+    } else if (name == "handoff") {
+        benchHandOff(numCrops > 0 ? numCrops : 1000000);
+    } else if (name == "mergeall") {
+        benchMergeAll(numCrops > 0 ? numCrops : 1000000);
+    } else if (name == "snapshot") {
+        benchSnapshot(numCrops > 0 ? numCrops : 1000000);
+    } else if (name == "linear") {
+        benchLinear(numCrops > 0 ? numCrops : 10000000);
+    } else if (name == "views") {
+        benchViews(numCrops > 0 ? numCrops : 500000);
+    } else if (name == "minmax") {
+        benchMinMax(numCrops > 0 ? numCrops : 500000);
+    } else if (name == "bounded") {
+        benchBounded(numCrops > 0 ? numCrops : 10000000);
+    } else if (name == "external") {
+        benchExternal(numCrops > 0 ? numCrops : 10000000);
+    } else if (name == "load") {
+        benchLoad(numCrops > 0 ? numCrops : 5000000);
+    } else {
+        cout << "unknown benchmark " << name << endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+int priorityFn1(const Crop &crop) {
+    //needs MAXHEAP
+    //priority value falls in the range [30-116]
+    //the larger value means the higher priority
+    int priority = crop.getTemperature() + crop.getType();
+    return priority;
+}
+
+int priorityFn2(const Crop &crop) {
+    //needs MINHEAP
+    //priority value falls in the range [0-103]
+    //the smaller value means the higher priority
+    int priority = crop.getMoisture() + crop.getTime();
+    return priority;
+}
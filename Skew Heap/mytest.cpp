@@ -1,5 +1,20 @@
 #include "iqueue.h"
+#include "concurrentqueue.h"
+#include "persistentqueue.h"
+#include "linearpriority.h"
+#include "multiviewqueue.h"
+#include "boundedqueue.h"
+#include "externalqueue.h"
+#include "cropfile.h"
+#include "daryheap.h"
 #include <random>
+#include <algorithm>
+#include <set>
+#include <thread>
+#include <type_traits>
+#include <csignal>
+#include <sys/resource.h>
+#include <unistd.h>
 // the followings are sample priority functions to be used by IQueue class
 // users can define their own priority functions
 // Priority functions compute an integer priority for a crop.  Internal
@@ -104,6 +119,32 @@ class Tester{
     bool testMergeQueueDiffPrior(IQueue& queue1, IQueue& queue2);
 
 
+    bool testPoolReuse(IQueue& queue, int numCrops);
+    bool testPoolClear(IQueue& queue);
+    bool testStoredPriority(IQueue& queue);
+    bool testDaryEngine(IQueue& queue);
+    bool testBucketEngine(IQueue& queue);
+    bool testBucketFallback(IQueue& queue);
+    bool testBulkInsert(vector<Crop>& crops);
+    bool testUpdateRemoveCrop(IQueue& queue);
+    bool testTopK(IQueue& queue);
+    bool testConcurrentRankError(ConcurrentIQueue& queue, vector<Crop>& crops);
+    bool testConcurrentThreads(ConcurrentIQueue& queue, vector<Crop>& crops, int numThreads);
+    bool testMoveSwap(IQueue& queue);
+    bool testMergeAll(vector<Crop>& crops);
+    bool testPersistentQueue(vector<Crop>& crops);
+    bool testLinearPriority(vector<Crop>& crops);
+    bool testMultiView(vector<Crop>& crops);
+    bool testIntervalEngine(IQueue& queue);
+    bool testBoundedQueue(vector<Crop>& crops);
+    bool testExternalQueue(vector<Crop>& crops);
+    bool testCropFile(vector<Crop>& crops);
+    bool testNextPriorityEngines(vector<Crop>& crops);
+    bool testEngineFacade(vector<Crop>& crops);
+    bool testBucketEngineNeedsRange();
+    bool testExternalQueueFailures(vector<Crop>& crops);
+    bool testIndexedMergeDuplicates(vector<Crop>& crops);
+
     // helper functions
     private:
     int countQueueSize(Node* currNode) {    
@@ -113,12 +154,73 @@ class Tester{
             return countQueueSize(currNode->m_left) + 1 + countQueueSize(currNode->m_right);
     };
 
+    // true if every Node holds the priority of its crop and no child outranks its parent
+    bool checkStoredPriority(Node* root, prifn_t priFn, HEAPTYPE heapType) {
+        vector<Node*> stack;
+        if(root != nullptr)
+            stack.push_back(root);
+        while(!stack.empty()) {
+            Node* currNode = stack.back();
+            stack.pop_back();
+            if(currNode->m_priority != priFn(currNode->m_crop))
+                return false;
+            Node* children[2] = {currNode->m_left, currNode->m_right};
+            for(int i = 0; i < 2; i++) {
+                if(children[i] == nullptr)
+                    continue;
+                if(heapType == MAXHEAP && children[i]->m_priority > currNode->m_priority)
+                    return false;
+                if(heapType == MINHEAP && children[i]->m_priority < currNode->m_priority)
+                    return false;
+                stack.push_back(children[i]);
+            }
+        }
+        return true;
+    };
+
+    // true if every child points back at its parent
+    bool checkParents(Node* root) {
+        if(root == nullptr)
+            return true;
+        if(root->m_parent != nullptr)
+            return false;
+        vector<Node*> stack(1, root);
+        while(!stack.empty()) {
+            Node* currNode = stack.back();
+            stack.pop_back();
+            Node* children[2] = {currNode->m_left, currNode->m_right};
+            for(int i = 0; i < 2; i++) {
+                if(children[i] == nullptr)
+                    continue;
+                if(children[i]->m_parent != currNode)
+                    return false;
+                stack.push_back(children[i]);
+            }
+        }
+        return true;
+    };
+
+    int treeHeight(Node* currNode) {
+        if(currNode == nullptr)
+            return 0;
+        return 1 + max(treeHeight(currNode->m_left), treeHeight(currNode->m_right));
+    };
+
+    // a priority with a range much wider than any bucket queue takes
+    static int priorityByID(const Crop& crop) {
+        return crop.getCropID();
+    };
+
+    bool hasCrops(IQueue& queue) {
+        return queue.numCrops() > 0;
+    };
+
     //testHeaps should always be called last... they clear out the queues.
     bool testHeapAscending(IQueue& queue) { // for min heap
         int maxPrior = priorityFn2(queue.getNextCrop());
 
         // let's make sure that the insertion properties are being met. if priority numbers decreases as the values pop, there's a problem.
-        while(queue.m_heap != nullptr) {
+        while(hasCrops(queue)) {
             int currPrior = priorityFn2(queue.getNextCrop());
 
             if(maxPrior > currPrior) { // value for min heap is ascending as it travels through heap...
@@ -135,7 +237,7 @@ class Tester{
         int maxPrior = priorityFn1(queue.getNextCrop());
 
         // let's make sure that the insertion properties are being met. if priority numbers decreases as the values pop, there's a problem.
-        while(queue.m_heap != nullptr) {
+        while(hasCrops(queue)) {
             int currPrior = priorityFn1(queue.getNextCrop());
 
             if(maxPrior < currPrior) { // value for min heap is descending as it travels through heap...
@@ -448,198 +550,1992 @@ int main(){
         }
     }
 
-    return 0;
-}
+    {
+        cout << "Test 12: Testing Node Pool | Reuse Case: ";
+        IQueue queue(priorityFn2, MINHEAP);
+        int numCrops = 300;
 
-bool Tester::testInsertMinNormal(IQueue& queue, int numCrops) {
-    // if the heap size does not much the numCrops, there's a problem...
-    if (countQueueSize(queue.m_heap) != numCrops) {
-        return false;
+        for (int i = 0; i < numCrops; i++){
+            Crop aCrop(idGen.getRandNum(),
+                        temperature,
+                        moistureGen.getRandNum(),
+                        time,
+                        typeGen.getRandNum());
+            queue.insertCrop(aCrop);
+        }
+
+        if(Test.testPoolReuse(queue, numCrops) == true) {
+            cout << "Test Passed" << endl;
+        } else {
+            cout << "Test Failed" << endl;
+        }
     }
 
-    return testHeapAscending(queue);
-}
+    {
+        cout << "Test 13: Testing Node Pool | Clear and Merge Case: ";
+        IQueue queue(priorityFn2, MINHEAP);
+        int numCrops = 300;
 
-bool Tester::testInsertMaxNormal(IQueue& queue, int numCrops) {
+        for (int i = 0; i < numCrops; i++){
+            Crop aCrop(idGen.getRandNum(),
+                        temperature,
+                        moistureGen.getRandNum(),
+                        time,
+                        typeGen.getRandNum());
+            queue.insertCrop(aCrop);
+        }
 
-    // if the heap size does not much the numCrops, there's a problem...
-    if (countQueueSize(queue.m_heap) != numCrops) {
-        return false;
+        if(Test.testPoolClear(queue) == true) {
+            cout << "Test Passed" << endl;
+        } else {
+            cout << "Test Failed" << endl;
+        }
     }
 
-    return testHeapDescending(queue); 
-}
 
+    {
+        cout << "Test 14: Testing Stored Priority | SetPriorityFunc Case: ";
+        IQueue queue(priorityFn2, MINHEAP);
+        int numCrops = 300;
 
-bool Tester::testRemoveMinNormal(IQueue& queue, int numCrops) {
-    return testHeapAscending(queue);
-}
+        for (int i = 0; i < numCrops; i++){
+            Crop aCrop(idGen.getRandNum(),
+                        temperatureGen.getRandNum(),
+                        moistureGen.getRandNum(),
+                        timeGen.getRandNum(),
+                        typeGen.getRandNum());
+            queue.insertCrop(aCrop);
+        }
 
+        if(Test.testStoredPriority(queue) == true) {
+            cout << "Test Passed" << endl;
+        } else {
+            cout << "Test Failed" << endl;
+        }
+    }
 
-bool Tester::testRemoveMaxNormal(IQueue& queue, int numCrops) {
-    return testHeapDescending(queue); 
-}
 
-bool Tester::testSetPriorFuncNormal(IQueue& queue) {
-    IQueue maxQueue(priorityFn1, MAXHEAP);
-    IQueue testQueue(queue); // queue is originally a priorityFn2 + min heap
+    {
+        cout << "Test 15: Testing 4-ary Heap Engine | Normal Case: ";
+        IQueue queue(priorityFn2, MINHEAP, DARYHEAP4);
+        int numCrops = 300;
 
-    while(queue.m_heap != nullptr) { // changes data from min heap to max heap
-        maxQueue.insertCrop(queue.getNextCrop());
-    }
+        for (int i = 0; i < numCrops; i++){
+            Crop aCrop(idGen.getRandNum(),
+                        temperatureGen.getRandNum(),
+                        moistureGen.getRandNum(),
+                        timeGen.getRandNum(),
+                        typeGen.getRandNum());
+            queue.insertCrop(aCrop);
+        }
 
-    testQueue.setPriorityFn(priorityFn1, MAXHEAP); // function we're testing...
-    
-    while(maxQueue.m_heap != nullptr) {
-        Crop maxQueueCrop = maxQueue.getNextCrop();
-        Crop testQueueCrop = testQueue.getNextCrop();
-        if ((maxQueueCrop.getCropID() != testQueueCrop.getCropID()) || (maxQueueCrop.getTemperature() != testQueueCrop.getTemperature()) 
-            || (maxQueueCrop.getMoisture() != testQueueCrop.getMoisture()) || (maxQueueCrop.getTimeString() != testQueueCrop.getTimeString())
-            || (maxQueueCrop.getTypeString() != testQueueCrop.getTypeString())) {
-            return false;
+        if(Test.testDaryEngine(queue) == true) {
+            cout << "Test Passed" << endl;
+        } else {
+            cout << "Test Failed" << endl;
         }
     }
 
-    return testQueue.m_size == 0; // if testQueue is empty, that means everything has been deleted, the count was the same, and that no differences were found...
-}
-
-bool Tester::testQueueMergeEmpty(IQueue& queue) {
-    IQueue emptyQueue(priorityFn2, MINHEAP);
-    
-    int numCrops = countQueueSize(queue.m_heap);
-    emptyQueue.mergeWithQueue(queue);
+    {
+        cout << "Test 16: Testing 8-ary Heap Engine | Normal Case: ";
+        IQueue queue(priorityFn2, MINHEAP, DARYHEAP8);
+        int numCrops = 300;
 
+        for (int i = 0; i < numCrops; i++){
+            Crop aCrop(idGen.getRandNum(),
+                        temperatureGen.getRandNum(),
+                        moistureGen.getRandNum(),
+                        timeGen.getRandNum(),
+                        typeGen.getRandNum());
+            queue.insertCrop(aCrop);
+        }
 
-    if(countQueueSize(emptyQueue.m_heap) != numCrops) { // if size is not same, theres a problem...
-        return false;
+        if(Test.testDaryEngine(queue) == true) {
+            cout << "Test Passed" << endl;
+        } else {
+            cout << "Test Failed" << endl;
+        }
     }
 
-    return testHeapAscending(emptyQueue); // let's see if the merge has kept the heap property in tact!
 
-}
+    {
+        cout << "Test 17: Testing Bucket Queue Engine | Normal Case: ";
+        IQueue queue(priorityFn2, MINHEAP, 0, 103);
+        int numCrops = 300;
 
-bool Tester::testCopyConstructorNormal(IQueue& queue) {
-    IQueue testQueue(queue);
+        for (int i = 0; i < numCrops; i++){
+            Crop aCrop(idGen.getRandNum(),
+                        temperatureGen.getRandNum(),
+                        moistureGen.getRandNum(),
+                        timeGen.getRandNum(),
+                        typeGen.getRandNum());
+            queue.insertCrop(aCrop);
+        }
 
-    if (countQueueSize(queue.m_heap) != countQueueSize(testQueue.m_heap)) { // if size isn't same, there is a problem!
-        return false;
+        if(Test.testBucketEngine(queue) == true) {
+            cout << "Test Passed" << endl;
+        } else {
+            cout << "Test Failed" << endl;
+        }
     }
 
-    if (queue.getPriorityFn() != testQueue.getPriorityFn()) {
-        return false;
-    } else if (queue.getHeapType() != testQueue.getHeapType()) {
-        return false;
-    }
+    {
+        cout << "Test 18: Testing Bucket Queue Engine | Range Too Wide Case: ";
+        IQueue queue(priorityFn2, MINHEAP, 0, 103);
+        int numCrops = 300;
 
-    while(queue.m_heap != nullptr) { // we compare queues...
-        Crop queueCrop = queue.getNextCrop();
-        Crop testQueueCrop = testQueue.getNextCrop();
-        if ((queueCrop.getCropID() != testQueueCrop.getCropID()) || (queueCrop.getTemperature() != testQueueCrop.getTemperature()) 
-            || (queueCrop.getMoisture() != testQueueCrop.getMoisture()) || (queueCrop.getTimeString() != testQueueCrop.getTimeString())
-            || (queueCrop.getTypeString() != testQueueCrop.getTypeString())) {
-            return false;
+        for (int i = 0; i < numCrops; i++){
+            Crop aCrop(idGen.getRandNum(),
+                        temperatureGen.getRandNum(),
+                        moistureGen.getRandNum(),
+                        timeGen.getRandNum(),
+                        typeGen.getRandNum());
+            queue.insertCrop(aCrop);
         }
-    }
 
-    return testQueue.m_size == 0; // if testQueue is empty, that means everything has been deleted, the count was the same, and that no differences were found...
-}
+        if(Test.testBucketFallback(queue) == true) {
+            cout << "Test Passed" << endl;
+        } else {
+            cout << "Test Failed" << endl;
+        }
+    }
 
-bool Tester::testCopyConstructorEdge(IQueue& queue) { // queue should be of size 0, 1, 2
-    IQueue testQueue(queue);
 
-    if (countQueueSize(queue.m_heap) != countQueueSize(testQueue.m_heap)) { // if size isn't same, there is a problem!
-        return false;
-    }
+    {
+        cout << "Test 19: Testing Bulk Insert | Normal Case: ";
+        vector<Crop> crops;
+        int numCrops = 300;
 
-    if (queue.getPriorityFn() != testQueue.getPriorityFn()) {
-        return false;
-    } else if (queue.getHeapType() != testQueue.getHeapType()) {
-        return false;
-    }
+        for (int i = 0; i < numCrops; i++){
+            Crop aCrop(idGen.getRandNum(),
+                        temperatureGen.getRandNum(),
+                        moistureGen.getRandNum(),
+                        timeGen.getRandNum(),
+                        typeGen.getRandNum());
+            crops.push_back(aCrop);
+        }
 
-    while(queue.m_heap != nullptr) { // we compare queues...
-        Crop queueCrop = queue.getNextCrop();
-        Crop testQueueCrop = testQueue.getNextCrop();
-        if ((queueCrop.getCropID() != testQueueCrop.getCropID()) || (queueCrop.getTemperature() != testQueueCrop.getTemperature()) 
-            || (queueCrop.getMoisture() != testQueueCrop.getMoisture()) || (queueCrop.getTimeString() != testQueueCrop.getTimeString())
-            || (queueCrop.getTypeString() != testQueueCrop.getTypeString())) {
-            return false;
+        if(Test.testBulkInsert(crops) == true) {
+            cout << "Test Passed" << endl;
+        } else {
+            cout << "Test Failed" << endl;
         }
     }
 
-    return testQueue.m_size == 0; // if testQueue is empty, that means everything has been deleted, the count was the same, and that no differences were found...
-}
-
-bool Tester::testAssignmentNormal(IQueue& queue) {
-    IQueue testQueue = queue;
 
-    if (countQueueSize(queue.m_heap) != countQueueSize(testQueue.m_heap)) { // if size isn't same, there is a problem!
-        return false;
-    }
+    {
+        cout << "Test 20: Testing Update and Remove Crop | Normal Case: ";
+        IQueue queue(priorityFn2, MINHEAP);
+        int numCrops = 300;
 
-    if (queue.getPriorityFn() != testQueue.getPriorityFn()) {
-        return false;
-    } else if (queue.getHeapType() != testQueue.getHeapType()) {
-        return false;
-    }
+        for (int i = 0; i < numCrops; i++){ // IDs have to be unique for the index
+            Crop aCrop(MINCROPID + i,
+                        temperatureGen.getRandNum(),
+                        moistureGen.getRandNum(),
+                        timeGen.getRandNum(),
+                        typeGen.getRandNum());
+            queue.insertCrop(aCrop);
+        }
 
-    while(queue.m_heap != nullptr) { // we compare queues...
-        Crop queueCrop = queue.getNextCrop();
-        Crop testQueueCrop = testQueue.getNextCrop();
-        if ((queueCrop.getCropID() != testQueueCrop.getCropID()) || (queueCrop.getTemperature() != testQueueCrop.getTemperature()) 
-            || (queueCrop.getMoisture() != testQueueCrop.getMoisture()) || (queueCrop.getTimeString() != testQueueCrop.getTimeString())
-            || (queueCrop.getTypeString() != testQueueCrop.getTypeString())) {
-            return false;
+        if(Test.testUpdateRemoveCrop(queue) == true) {
+            cout << "Test Passed" << endl;
+        } else {
+            cout << "Test Failed" << endl;
         }
     }
 
-    return testQueue.m_size == 0; // if testQueue is empty, that means everything has been deleted, the count was the same, and that no differences were found...
-}
 
-bool Tester::testAssignmentEdge(IQueue& queue) { // queue should be of size 0, 1, 2
-    IQueue testQueue = queue;
+    {
+        cout << "Test 21: Testing Top K | Normal Case: ";
+        IQueue queue(priorityFn2, MINHEAP);
+        int numCrops = 300;
 
-    if (countQueueSize(queue.m_heap) != countQueueSize(testQueue.m_heap)) { // if size isn't same, there is a problem!
-        return false;
+        for (int i = 0; i < numCrops; i++){
+            Crop aCrop(idGen.getRandNum(),
+                        temperatureGen.getRandNum(),
+                        moistureGen.getRandNum(),
+                        timeGen.getRandNum(),
+                        typeGen.getRandNum());
+            queue.insertCrop(aCrop);
+        }
+
+        if(Test.testTopK(queue) == true) {
+            cout << "Test Passed" << endl;
+        } else {
+            cout << "Test Failed" << endl;
+        }
     }
 
-    if (queue.getPriorityFn() != testQueue.getPriorityFn()) {
-        return false;
-    } else if (queue.getHeapType() != testQueue.getHeapType()) {
+
+    {
+        cout << "Test 22: Testing Concurrent Queue Rank Error | Normal Case: ";
+        ConcurrentIQueue queue(priorityFn1, MAXHEAP, 4);
+        vector<Crop> crops;
+        int numCrops = 2000;
+
+        for (int i = 0; i < numCrops; i++){
+            crops.push_back(Crop(MINCROPID + i,
+                        temperatureGen.getRandNum(),
+                        moistureGen.getRandNum(),
+                        timeGen.getRandNum(),
+                        typeGen.getRandNum()));
+        }
+
+        if(Test.testConcurrentRankError(queue, crops) == true) {
+            cout << "Test Passed" << endl;
+        } else {
+            cout << "Test Failed" << endl;
+        }
+    }
+
+    {
+        cout << "Test 23: Testing Concurrent Queue Threads | Normal Case: ";
+        int numThreads = 4;
+        ConcurrentIQueue queue(priorityFn1, MAXHEAP, numThreads);
+        vector<Crop> crops;
+        int numCrops = 8000;
+
+        for (int i = 0; i < numCrops; i++){
+            crops.push_back(Crop(MINCROPID + i,
+                        temperatureGen.getRandNum(),
+                        moistureGen.getRandNum(),
+                        timeGen.getRandNum(),
+                        typeGen.getRandNum()));
+        }
+
+        if(Test.testConcurrentThreads(queue, crops, numThreads) == true) {
+            cout << "Test Passed" << endl;
+        } else {
+            cout << "Test Failed" << endl;
+        }
+    }
+
+
+    {
+        cout << "Test 24: Testing Move, Swap and Assignment | Normal Case: ";
+        IQueue queue(priorityFn2, MINHEAP);
+        int numCrops = 300;
+
+        for (int i = 0; i < numCrops; i++){
+            Crop aCrop(idGen.getRandNum(),
+                        temperatureGen.getRandNum(),
+                        moistureGen.getRandNum(),
+                        timeGen.getRandNum(),
+                        typeGen.getRandNum());
+            queue.insertCrop(aCrop);
+        }
+
+        if(Test.testMoveSwap(queue) == true) {
+            cout << "Test Passed" << endl;
+        } else {
+            cout << "Test Failed" << endl;
+        }
+    }
+
+
+    {
+        cout << "Test 25: Testing Merge All | Normal Case: ";
+        vector<Crop> crops;
+        int numCrops = 1000;
+
+        for (int i = 0; i < numCrops; i++){
+            crops.push_back(Crop(idGen.getRandNum(),
+                        temperatureGen.getRandNum(),
+                        moistureGen.getRandNum(),
+                        timeGen.getRandNum(),
+                        typeGen.getRandNum()));
+        }
+
+        if(Test.testMergeAll(crops) == true) {
+            cout << "Test Passed" << endl;
+        } else {
+            cout << "Test Failed" << endl;
+        }
+    }
+
+
+    {
+        cout << "Test 26: Testing Persistent Queue Snapshots | Normal Case: ";
+        vector<Crop> crops;
+        int numCrops = 300;
+
+        for (int i = 0; i < numCrops; i++){
+            crops.push_back(Crop(idGen.getRandNum(),
+                        temperatureGen.getRandNum(),
+                        moistureGen.getRandNum(),
+                        timeGen.getRandNum(),
+                        typeGen.getRandNum()));
+        }
+
+        if(Test.testPersistentQueue(crops) == true) {
+            cout << "Test Passed" << endl;
+        } else {
+            cout << "Test Failed" << endl;
+        }
+    }
+
+
+    {
+        cout << "Test 27: Testing Packed Crop and Linear Priority | Normal Case: ";
+        vector<Crop> crops;
+        int numCrops = 1003; // not a multiple of 8, the tail goes through the plain loop
+
+        for (int i = 0; i < numCrops; i++){
+            crops.push_back(Crop(idGen.getRandNum(),
+                        temperatureGen.getRandNum(),
+                        moistureGen.getRandNum(),
+                        timeGen.getRandNum(),
+                        typeGen.getRandNum()));
+        }
+
+        if(Test.testLinearPriority(crops) == true) {
+            cout << "Test Passed" << endl;
+        } else {
+            cout << "Test Failed" << endl;
+        }
+    }
+
+
+    {
+        cout << "Test 28: Testing Multi-View Queue | Normal Case: ";
+        vector<Crop> crops;
+        int numCrops = 300;
+
+        for (int i = 0; i < numCrops; i++){ // unique IDs tell the crops apart
+            crops.push_back(Crop(MINCROPID + i,
+                        temperatureGen.getRandNum(),
+                        moistureGen.getRandNum(),
+                        timeGen.getRandNum(),
+                        typeGen.getRandNum()));
+        }
+
+        if(Test.testMultiView(crops) == true) {
+            cout << "Test Passed" << endl;
+        } else {
+            cout << "Test Failed" << endl;
+        }
+    }
+
+
+    {
+        cout << "Test 29: Testing Interval Heap Engine | Normal Case: ";
+        IQueue queue(priorityFn2, MINHEAP, INTERVALHEAP);
+        int numCrops = 301;
+
+        for (int i = 0; i < numCrops; i++){
+            Crop aCrop(idGen.getRandNum(),
+                        temperatureGen.getRandNum(),
+                        moistureGen.getRandNum(),
+                        timeGen.getRandNum(),
+                        typeGen.getRandNum());
+            queue.insertCrop(aCrop);
+        }
+
+        if(Test.testIntervalEngine(queue) == true) {
+            cout << "Test Passed" << endl;
+        } else {
+            cout << "Test Failed" << endl;
+        }
+    }
+
+    {
+        cout << "Test 30: Testing Bounded Top K Queue | Normal Case: ";
+        vector<Crop> crops;
+        int numCrops = 5000;
+
+        for (int i = 0; i < numCrops; i++){
+            crops.push_back(Crop(idGen.getRandNum(),
+                        temperatureGen.getRandNum(),
+                        moistureGen.getRandNum(),
+                        timeGen.getRandNum(),
+                        typeGen.getRandNum()));
+        }
+
+        if(Test.testBoundedQueue(crops) == true) {
+            cout << "Test Passed" << endl;
+        } else {
+            cout << "Test Failed" << endl;
+        }
+    }
+
+    {
+        cout << "Test 31: Testing External Memory Queue | Normal Case: ";
+        vector<Crop> crops;
+        int numCrops = 300000;
+
+        for (int i = 0; i < numCrops; i++){
+            crops.push_back(Crop(idGen.getRandNum(),
+                        temperatureGen.getRandNum(),
+                        moistureGen.getRandNum(),
+                        timeGen.getRandNum(),
+                        typeGen.getRandNum()));
+        }
+
+        if(Test.testExternalQueue(crops) == true) {
+            cout << "Test Passed" << endl;
+        } else {
+            cout << "Test Failed" << endl;
+        }
+    }
+
+    {
+        cout << "Test 32: Testing Crop File Loader | Normal Case: ";
+        vector<Crop> crops;
+        int numCrops = 200000;
+
+        for (int i = 0; i < numCrops; i++){
+            crops.push_back(Crop(idGen.getRandNum(),
+                        temperatureGen.getRandNum(),
+                        moistureGen.getRandNum(),
+                        timeGen.getRandNum(),
+                        typeGen.getRandNum()));
+        }
+
+        if(Test.testCropFile(crops) == true) {
+            cout << "Test Passed" << endl;
+        } else {
+            cout << "Test Failed" << endl;
+        }
+    }
+
+    {
+        cout << "Test 33: Testing Next Priority On Every Engine | Normal Case: ";
+        vector<Crop> crops;
+        int numCrops = 300;
+
+        for (int i = 0; i < numCrops; i++){
+            crops.push_back(Crop(idGen.getRandNum(),
+                        temperatureGen.getRandNum(),
+                        moistureGen.getRandNum(),
+                        timeGen.getRandNum(),
+                        typeGen.getRandNum()));
+        }
+
+        if(Test.testNextPriorityEngines(crops) == true) {
+            cout << "Test Passed" << endl;
+        } else {
+            cout << "Test Failed" << endl;
+        }
+    }
+
+    {
+        cout << "Test 34: Testing Engine Queue Facade | Normal Case: ";
+        vector<Crop> crops;
+        int numCrops = 100;
+
+        for (int i = 0; i < numCrops; i++){
+            crops.push_back(Crop(idGen.getRandNum(),
+                        temperatureGen.getRandNum(),
+                        moistureGen.getRandNum(),
+                        timeGen.getRandNum(),
+                        typeGen.getRandNum()));
+        }
+
+        if(Test.testEngineFacade(crops) == true) {
+            cout << "Test Passed" << endl;
+        } else {
+            cout << "Test Failed" << endl;
+        }
+    }
+
+    {
+        cout << "Test 35: Testing Bucket Engine Without Range | Error Case: ";
+        if(Test.testBucketEngineNeedsRange() == true) {
+            cout << "Test Passed" << endl;
+        } else {
+            cout << "Test Failed" << endl;
+        }
+    }
+
+    {
+        cout << "Test 36: Testing External Memory Queue Failures | Error Case: ";
+        vector<Crop> crops;
+        int numCrops = (MAXRUNS + 1) * RUNBLOCK + 1;
+
+        for (int i = 0; i < numCrops; i++){
+            crops.push_back(Crop(idGen.getRandNum(),
+                        temperatureGen.getRandNum(),
+                        moistureGen.getRandNum(),
+                        timeGen.getRandNum(),
+                        typeGen.getRandNum()));
+        }
+
+        if(Test.testExternalQueueFailures(crops) == true) {
+            cout << "Test Passed" << endl;
+        } else {
+            cout << "Test Failed" << endl;
+        }
+    }
+
+    {
+        cout << "Test 37: Testing Merge Into Indexed Queue | Duplicate ID Case: ";
+        vector<Crop> crops;
+        int numCrops = 1000;
+
+        // IDs are unique here, the test makes its own twins
+        for (int i = 0; i < numCrops; i++){
+            crops.push_back(Crop(MINCROPID + i,
+                        temperatureGen.getRandNum(),
+                        moistureGen.getRandNum(),
+                        timeGen.getRandNum(),
+                        typeGen.getRandNum()));
+        }
+
+        if(Test.testIndexedMergeDuplicates(crops) == true) {
+            cout << "Test Passed" << endl;
+        } else {
+            cout << "Test Failed" << endl;
+        }
+    }
+
+    return 0;
+}
+
+bool Tester::testInsertMinNormal(IQueue& queue, int numCrops) {
+    // if the heap size does not much the numCrops, there's a problem...
+    if (countQueueSize(queue.m_heap) != numCrops) {
+        return false;
+    }
+
+    return testHeapAscending(queue);
+}
+
+bool Tester::testInsertMaxNormal(IQueue& queue, int numCrops) {
+
+    // if the heap size does not much the numCrops, there's a problem...
+    if (countQueueSize(queue.m_heap) != numCrops) {
+        return false;
+    }
+
+    return testHeapDescending(queue); 
+}
+
+
+bool Tester::testRemoveMinNormal(IQueue& queue, int numCrops) {
+    return testHeapAscending(queue);
+}
+
+
+bool Tester::testRemoveMaxNormal(IQueue& queue, int numCrops) {
+    return testHeapDescending(queue); 
+}
+
+bool Tester::testSetPriorFuncNormal(IQueue& queue) {
+    IQueue maxQueue(priorityFn1, MAXHEAP);
+    IQueue testQueue(queue); // queue is originally a priorityFn2 + min heap
+
+    while(queue.m_heap != nullptr) { // changes data from min heap to max heap
+        maxQueue.insertCrop(queue.getNextCrop());
+    }
+
+    testQueue.setPriorityFn(priorityFn1, MAXHEAP); // function we're testing...
+    
+    // the rebuild is bottom-up, crops with equal priorities can come out in any order.
+    // so the priorities have to match pop by pop and the crops as a whole
+    vector<int> maxQueueIDs, testQueueIDs;
+    while(maxQueue.m_heap != nullptr) {
+        Crop maxQueueCrop = maxQueue.getNextCrop();
+        Crop testQueueCrop = testQueue.getNextCrop();
+        if (priorityFn1(maxQueueCrop) != priorityFn1(testQueueCrop)) {
+            return false;
+        }
+        maxQueueIDs.push_back(maxQueueCrop.getCropID());
+        testQueueIDs.push_back(testQueueCrop.getCropID());
+    }
+    sort(maxQueueIDs.begin(), maxQueueIDs.end());
+    sort(testQueueIDs.begin(), testQueueIDs.end());
+    if (maxQueueIDs != testQueueIDs) {
+        return false;
+    }
+
+    return testQueue.m_size == 0; // if testQueue is empty, that means everything has been deleted, the count was the same, and that no differences were found...
+}
+
+bool Tester::testQueueMergeEmpty(IQueue& queue) {
+    IQueue emptyQueue(priorityFn2, MINHEAP);
+    
+    int numCrops = countQueueSize(queue.m_heap);
+    emptyQueue.mergeWithQueue(queue);
+
+
+    if(countQueueSize(emptyQueue.m_heap) != numCrops) { // if size is not same, theres a problem...
+        return false;
+    }
+
+    return testHeapAscending(emptyQueue); // let's see if the merge has kept the heap property in tact!
+
+}
+
+bool Tester::testCopyConstructorNormal(IQueue& queue) {
+    IQueue testQueue(queue);
+
+    if (countQueueSize(queue.m_heap) != countQueueSize(testQueue.m_heap)) { // if size isn't same, there is a problem!
+        return false;
+    }
+
+    if (queue.getPriorityFn() != testQueue.getPriorityFn()) {
+        return false;
+    } else if (queue.getHeapType() != testQueue.getHeapType()) {
+        return false;
+    }
+
+    while(queue.m_heap != nullptr) { // we compare queues...
+        Crop queueCrop = queue.getNextCrop();
+        Crop testQueueCrop = testQueue.getNextCrop();
+        if ((queueCrop.getCropID() != testQueueCrop.getCropID()) || (queueCrop.getTemperature() != testQueueCrop.getTemperature()) 
+            || (queueCrop.getMoisture() != testQueueCrop.getMoisture()) || (queueCrop.getTimeString() != testQueueCrop.getTimeString())
+            || (queueCrop.getTypeString() != testQueueCrop.getTypeString())) {
+            return false;
+        }
+    }
+
+    return testQueue.m_size == 0; // if testQueue is empty, that means everything has been deleted, the count was the same, and that no differences were found...
+}
+
+bool Tester::testCopyConstructorEdge(IQueue& queue) { // queue should be of size 0, 1, 2
+    IQueue testQueue(queue);
+
+    if (countQueueSize(queue.m_heap) != countQueueSize(testQueue.m_heap)) { // if size isn't same, there is a problem!
+        return false;
+    }
+
+    if (queue.getPriorityFn() != testQueue.getPriorityFn()) {
+        return false;
+    } else if (queue.getHeapType() != testQueue.getHeapType()) {
+        return false;
+    }
+
+    while(queue.m_heap != nullptr) { // we compare queues...
+        Crop queueCrop = queue.getNextCrop();
+        Crop testQueueCrop = testQueue.getNextCrop();
+        if ((queueCrop.getCropID() != testQueueCrop.getCropID()) || (queueCrop.getTemperature() != testQueueCrop.getTemperature()) 
+            || (queueCrop.getMoisture() != testQueueCrop.getMoisture()) || (queueCrop.getTimeString() != testQueueCrop.getTimeString())
+            || (queueCrop.getTypeString() != testQueueCrop.getTypeString())) {
+            return false;
+        }
+    }
+
+    return testQueue.m_size == 0; // if testQueue is empty, that means everything has been deleted, the count was the same, and that no differences were found...
+}
+
+bool Tester::testAssignmentNormal(IQueue& queue) {
+    IQueue testQueue = queue;
+
+    if (countQueueSize(queue.m_heap) != countQueueSize(testQueue.m_heap)) { // if size isn't same, there is a problem!
+        return false;
+    }
+
+    if (queue.getPriorityFn() != testQueue.getPriorityFn()) {
+        return false;
+    } else if (queue.getHeapType() != testQueue.getHeapType()) {
+        return false;
+    }
+
+    while(queue.m_heap != nullptr) { // we compare queues...
+        Crop queueCrop = queue.getNextCrop();
+        Crop testQueueCrop = testQueue.getNextCrop();
+        if ((queueCrop.getCropID() != testQueueCrop.getCropID()) || (queueCrop.getTemperature() != testQueueCrop.getTemperature()) 
+            || (queueCrop.getMoisture() != testQueueCrop.getMoisture()) || (queueCrop.getTimeString() != testQueueCrop.getTimeString())
+            || (queueCrop.getTypeString() != testQueueCrop.getTypeString())) {
+            return false;
+        }
+    }
+
+    return testQueue.m_size == 0; // if testQueue is empty, that means everything has been deleted, the count was the same, and that no differences were found...
+}
+
+bool Tester::testAssignmentEdge(IQueue& queue) { // queue should be of size 0, 1, 2
+    IQueue testQueue = queue;
+
+    if (countQueueSize(queue.m_heap) != countQueueSize(testQueue.m_heap)) { // if size isn't same, there is a problem!
+        return false;
+    }
+
+    if (queue.getPriorityFn() != testQueue.getPriorityFn()) {
+        return false;
+    } else if (queue.getHeapType() != testQueue.getHeapType()) {
+        return false;
+    }
+
+    while(queue.m_heap != nullptr) { // we compare queues...
+        Crop queueCrop = queue.getNextCrop();
+        Crop testQueueCrop = testQueue.getNextCrop();
+        if ((queueCrop.getCropID() != testQueueCrop.getCropID()) || (queueCrop.getTemperature() != testQueueCrop.getTemperature()) 
+            || (queueCrop.getMoisture() != testQueueCrop.getMoisture()) || (queueCrop.getTimeString() != testQueueCrop.getTimeString())
+            || (queueCrop.getTypeString() != testQueueCrop.getTypeString())) {
+            return false;
+        }
+    }
+
+    return testQueue.m_size == 0; // if testQueue is empty, that means everything has been deleted, the count was the same, and that no differences were found...
+}
+
+bool Tester::testDeQueueEmpty() {
+    IQueue testQueue(priorityFn2, MINHEAP);
+
+    try {
+        testQueue.getNextCrop(); // exception should be thrown
+        return false; // did not throw out of range
+    } catch (domain_error& err) {
+        return true;
+    }
+}
+
+bool Tester::testMergeQueueDiffPrior(IQueue& queue1, IQueue& queue2) {
+    try {
+        queue1.mergeWithQueue(queue2); // exception should be thrown
+        return false; // did not throw out of range
+    } catch (domain_error& err) {
+        return true;
+    }
+}
+
+bool Tester::testPoolReuse(IQueue& queue, int numCrops) {
+    int chunks = queue.m_pool.numChunks();
+
+    // steady churn, every pop frees a Node the next insert picks up again
+    for (int i = 0; i < numCrops * 10; i++) {
+        Crop crop = queue.getNextCrop();
+        queue.insertCrop(crop);
+    }
+
+    if (queue.m_pool.numChunks() != chunks) { // no new chunk should have been needed...
+        return false;
+    }
+
+    return testHeapAscending(queue);
+}
+
+bool Tester::testPoolClear(IQueue& queue) {
+    IQueue otherQueue(priorityFn2, MINHEAP);
+    int numCrops = countQueueSize(queue.m_heap);
+
+    for (int i = 0; i < 50; i++) {
+        otherQueue.insertCrop(Crop(MINCROPID + i, MINTEMP, i, MORNING, BEAN));
+    }
+
+    // the merged Nodes change owner together with their chunks
+    int chunks = queue.m_pool.numChunks() + otherQueue.m_pool.numChunks();
+    queue.mergeWithQueue(otherQueue);
+    if (queue.m_pool.numChunks() != chunks || otherQueue.m_pool.numChunks() != 0) {
+        return false;
+    }
+    if (countQueueSize(queue.m_heap) != numCrops + 50) {
+        return false;
+    }
+
+    queue.clear();
+    return queue.m_heap == nullptr && queue.m_pool.numChunks() == 0;
+}
+
+bool Tester::testStoredPriority(IQueue& queue) {
+    int numCrops = countQueueSize(queue.m_heap);
+
+    if (!checkStoredPriority(queue.m_heap, queue.getPriorityFn(), queue.getHeapType())) {
+        return false;
+    }
+
+    // every Node has to pick up the new priority, and the heap has to be ordered by it.
+    // the Nodes are reused, so the pool must not grow
+    int chunks = queue.m_pool.numChunks();
+    queue.setPriorityFn(priorityFn1, MAXHEAP);
+    if (queue.m_pool.numChunks() != chunks) {
+        return false;
+    }
+    if (!checkStoredPriority(queue.m_heap, queue.getPriorityFn(), queue.getHeapType())) {
+        return false;
+    }
+    if (countQueueSize(queue.m_heap) != numCrops || queue.m_size != numCrops) {
+        return false;
+    }
+
+    return testHeapDescending(queue);
+}
+
+bool Tester::testDaryEngine(IQueue& queue) { // queue should be a priorityFn2 + min heap
+    int numCrops = queue.numCrops();
+    if (queue.m_heap != nullptr || numCrops == 0) { // the skew heap part has to stay empty
+        return false;
+    }
+
+    // the copy must not share anything with queue
+    IQueue copyQueue(queue);
+    if (copyQueue.getEngine() != queue.getEngine() || copyQueue.numCrops() != numCrops) {
+        return false;
+    }
+    if (!testHeapAscending(copyQueue) || queue.numCrops() != numCrops) {
+        return false;
+    }
+
+    // half of the crops come back through a merge with a queue of the same engine
+    IQueue otherQueue(priorityFn2, MINHEAP, queue.getEngine());
+    for (int i = 0; i < numCrops / 2; i++) {
+        otherQueue.insertCrop(queue.getNextCrop());
+    }
+    queue.mergeWithQueue(otherQueue);
+    if (queue.numCrops() != numCrops || otherQueue.numCrops() != 0) {
+        return false;
+    }
+
+    queue.setPriorityFn(priorityFn1, MAXHEAP);
+    if (queue.numCrops() != numCrops) {
+        return false;
+    }
+    return testHeapDescending(queue);
+}
+
+bool Tester::testBucketEngine(IQueue& queue) { // queue should be a priorityFn2 + min heap with 0-103
+    int numCrops = queue.numCrops();
+    if (queue.getEngine() != BUCKETQUEUE || queue.m_heap != nullptr) {
+        return false;
+    }
+
+    IQueue copyQueue(queue);
+    if (!testHeapAscending(copyQueue) || queue.numCrops() != numCrops) {
+        return false;
+    }
+
+    // the other queue was declared narrower, the merge widens ours
+    IQueue otherQueue(priorityFn2, MINHEAP, 40, 60);
+    for (int i = 0; i < numCrops / 2; i++) {
+        otherQueue.insertCrop(queue.getNextCrop());
+    }
+    queue.mergeWithQueue(otherQueue);
+    if (queue.numCrops() != numCrops || otherQueue.numCrops() != 0) {
+        return false;
+    }
+
+    // 30-116 fits as well, the queue stays a bucket queue
+    queue.setPriorityFn(priorityFn1, MAXHEAP);
+    if (queue.getEngine() != BUCKETQUEUE || queue.numCrops() != numCrops) {
+        return false;
+    }
+    return testHeapDescending(queue);
+}
+
+bool Tester::testBucketFallback(IQueue& queue) { // queue should be a priorityFn2 + min heap with 0-103
+    int numCrops = queue.numCrops();
+
+    // a declared range that is too wide never gets a bucket queue
+    IQueue wideQueue(priorityByID, MAXHEAP, MINCROPID, MAXCROPID);
+    if (wideQueue.getEngine() != SKEWHEAP) {
+        return false;
+    }
+
+    // crop IDs span far more than MAXBUCKETS, the crops have to move to a skew heap
+    queue.setPriorityFn(priorityByID, MAXHEAP);
+    if (queue.getEngine() != SKEWHEAP || queue.numCrops() != numCrops) {
+        return false;
+    }
+
+    int lastID = queue.getNextCrop().getCropID();
+    while (queue.m_heap != nullptr) {
+        int currID = queue.getNextCrop().getCropID();
+        if (currID > lastID) {
+            return false;
+        }
+        lastID = currID;
+    }
+    return queue.numCrops() == 0;
+}
+
+bool Tester::testBulkInsert(vector<Crop>& crops) {
+    int numCrops = crops.size();
+
+    // built from nothing the tree is complete, so its height is about log2(n)
+    IQueue queue(priorityFn2, MINHEAP, crops);
+    if (countQueueSize(queue.m_heap) != numCrops || queue.numCrops() != numCrops) {
+        return false;
+    }
+    if (treeHeight(queue.m_heap) > 9) { // 300 crops fit into 9 levels
+        return false;
+    }
+    if (!checkStoredPriority(queue.m_heap, priorityFn2, MINHEAP) || !checkParents(queue.m_heap)) {
+        return false;
+    }
+
+    // a second batch lands on top of what is already there
+    queue.insertCrops(crops.data(), numCrops / 2);
+    queue.insertCrops(crops.data(), 0);
+    if (countQueueSize(queue.m_heap) != numCrops + numCrops / 2) {
+        return false;
+    }
+    if (!testHeapAscending(queue)) {
+        return false;
+    }
+
+    // every engine takes a batch
+    ENGINE engines[3] = {DARYHEAP4, DARYHEAP8, BUCKETQUEUE};
+    for (int e = 0; e < 3; e++) {
+        IQueue* engineQueue = (engines[e] == BUCKETQUEUE) ? new IQueue(priorityFn2, MINHEAP, 0, 103)
+                                                           : new IQueue(priorityFn2, MINHEAP, engines[e]);
+        engineQueue->insertCrop(crops[0]);
+        engineQueue->insertCrops(crops.data(), numCrops);
+        bool passed = engineQueue->getEngine() == engines[e] && engineQueue->numCrops() == numCrops + 1
+                      && testHeapAscending(*engineQueue);
+        delete engineQueue;
+        if (!passed) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Tester::testUpdateRemoveCrop(IQueue& queue) { // queue should be a priorityFn2 + min heap, IDs MINCROPID...
+    int numCrops = queue.numCrops();
+    queue.enableCropIndex();
+
+    // every even crop dries out completely, every third one is gone
+    for (int i = 0; i < numCrops; i += 2) {
+        if (!queue.updateCrop(MINCROPID + i, Crop(MINCROPID + i, MINTEMP, MINMOISTURE, MORNING, BEAN))) {
+            return false;
+        }
+    }
+    int removed = 0;
+    for (int i = 0; i < numCrops; i += 3) {
+        if (!queue.removeCrop(MINCROPID + i)) {
+            return false;
+        }
+        removed++;
+    }
+    if (queue.removeCrop(MINCROPID) || queue.updateCrop(MAXCROPID, Crop())) { // already gone, never there
+        return false;
+    }
+
+    // a handle works without looking anything up, a new ID moves in the index
+    CropHandle handle = queue.insertCrop(Crop(MAXCROPID, MAXTEMP, MAXMOISTURE, NIGHT, BEAN));
+    queue.updateCrop(handle, Crop(MAXCROPID - 1, MAXTEMP, MINMOISTURE, MORNING, BEAN));
+    if (queue.removeCrop(MAXCROPID) || !queue.removeCrop(MAXCROPID - 1)) {
+        return false;
+    }
+
+    // an ID that is already queued is refused
+    try {
+        queue.insertCrop(Crop(MINCROPID + 1, MINTEMP, MINMOISTURE, MORNING, BEAN));
+        return false;
+    } catch (domain_error& err) {
+    }
+
+    if (queue.numCrops() != numCrops - removed || countQueueSize(queue.m_heap) != numCrops - removed) {
+        return false;
+    }
+    if (!checkParents(queue.m_heap) || !checkStoredPriority(queue.m_heap, priorityFn2, MINHEAP)) {
+        return false;
+    }
+
+    // the dried out crops have priority 0, they come out first
+    int zeroPriority = 0;
+    for (int i = 0; i < numCrops; i += 2) {
+        if (i % 3 != 0) {
+            zeroPriority++;
+        }
+    }
+    IQueue copyQueue(queue);
+    for (int i = 0; i < zeroPriority; i++) {
+        if (priorityFn2(copyQueue.getNextCrop()) != 0) {
+            return false;
+        }
+    }
+    return testHeapAscending(queue);
+}
+
+bool Tester::testTopK(IQueue& queue) { // queue should be a priorityFn2 + min heap
+    const int K = 40;
+    int numCrops = queue.numCrops();
+    vector<Crop> crops; // every crop, for the other engines
+    IQueue copyQueue(queue);
+    while (copyQueue.numCrops() > 0) {
+        crops.push_back(copyQueue.getNextCrop());
+    }
+
+    // peeking leaves everything where it was
+    IQueue popQueue(queue);
+    Crop peeked[K], taken[K];
+    int expected[K];
+    if (queue.peekTopK(K, peeked) != K || queue.numCrops() != numCrops) {
+        return false;
+    }
+    for (int i = 0; i < K; i++) {
+        expected[i] = priorityFn2(popQueue.getNextCrop());
+        if (priorityFn2(peeked[i]) != expected[i]) {
+            return false;
+        }
+    }
+
+    // the skew heap takes exactly the crops it peeked
+    if (queue.getNextCrops(K, taken) != K || queue.numCrops() != numCrops - K) {
+        return false;
+    }
+    for (int i = 0; i < K; i++) {
+        if (taken[i].getCropID() != peeked[i].getCropID()) {
+            return false;
+        }
+    }
+    if (!checkParents(queue.m_heap) || !checkStoredPriority(queue.m_heap, priorityFn2, MINHEAP)
+        || countQueueSize(queue.m_heap) != numCrops - K) {
+        return false;
+    }
+
+    // asking for more than there is takes what there is, in order
+    vector<Crop> rest(numCrops);
+    if (queue.getNextCrops(numCrops, rest.data()) != numCrops - K || queue.m_heap != nullptr || queue.numCrops() != 0) {
+        return false;
+    }
+    if (priorityFn2(rest[0]) < expected[K - 1]) {
+        return false;
+    }
+    for (int i = 1; i < numCrops - K; i++) {
+        if (priorityFn2(rest[i]) < priorityFn2(rest[i - 1])) {
+            return false;
+        }
+    }
+
+    // the other engines agree on the priorities
+    ENGINE engines[3] = {DARYHEAP4, DARYHEAP8, BUCKETQUEUE};
+    for (int e = 0; e < 3; e++) {
+        IQueue* engineQueue = (engines[e] == BUCKETQUEUE) ? new IQueue(priorityFn2, MINHEAP, 0, 103)
+                                                           : new IQueue(priorityFn2, MINHEAP, engines[e]);
+        engineQueue->insertCrops(crops.data(), numCrops);
+        bool passed = engineQueue->peekTopK(K, peeked) == K && engineQueue->getNextCrops(K, taken) == K
+                      && engineQueue->numCrops() == numCrops - K;
+        for (int i = 0; passed && i < K; i++) {
+            passed = priorityFn2(peeked[i]) == expected[i] && priorityFn2(taken[i]) == expected[i];
+        }
+        delete engineQueue;
+        if (!passed) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Tester::testConcurrentRankError(ConcurrentIQueue& queue, vector<Crop>& crops) { // queue should be a priorityFn1 + max heap
+    int numCrops = crops.size();
+    multiset<int> remaining; // priorities of the crops still queued
+    for (int i = 0; i < numCrops; i++) {
+        queue.insertCrop(crops[i]);
+        remaining.insert(priorityFn1(crops[i]));
+    }
+    if (queue.numCrops() != numCrops) {
+        return false;
+    }
+
+    // the rank of a pop is how many crops still queued strictly outrank it
+    long totalRank = 0;
+    int maxRank = 0;
+    Crop crop;
+    while (queue.getNextCrop(crop)) {
+        int priority = priorityFn1(crop);
+        multiset<int>::iterator it = remaining.find(priority);
+        if (it == remaining.end()) {
+            return false;
+        }
+        int rank = distance(remaining.upper_bound(priority), remaining.end());
+        totalRank += rank;
+        maxRank = max(maxRank, rank);
+        remaining.erase(it);
+    }
+    if (!remaining.empty() || queue.numCrops() != 0) {
+        return false;
+    }
+
+    // expected rank is O(number of sub-queues), the worst one O(q log q)
+    int numQueues = queue.numQueues();
+    return totalRank <= (long)numQueues * numCrops && maxRank <= 10 * numQueues;
+}
+
+bool Tester::testConcurrentThreads(ConcurrentIQueue& queue, vector<Crop>& crops, int numThreads) {
+    int numCrops = crops.size();
+    int perThread = numCrops / numThreads;
+    atomic<bool> producing(true);
+    vector<vector<int> > poppedIDs(numThreads);
+
+    // half the threads insert while the other half pop
+    vector<thread> producers, consumers;
+    for (int t = 0; t < numThreads; t++) {
+        producers.push_back(thread([&queue, &crops, t, perThread]() {
+            for (int i = t * perThread; i < (t + 1) * perThread; i++) {
+                queue.insertCrop(crops[i]);
+            }
+        }));
+        consumers.push_back(thread([&queue, &producing, &poppedIDs, t]() {
+            Crop crop;
+            while (true) {
+                bool done = !producing.load();
+                if (queue.getNextCrop(crop)) {
+                    poppedIDs[t].push_back(crop.getCropID());
+                } else if (done) {
+                    return;
+                }
+            }
+        }));
+    }
+    for (int t = 0; t < numThreads; t++) {
+        producers[t].join();
+    }
+    producing.store(false);
+    for (int t = 0; t < numThreads; t++) {
+        consumers[t].join();
+    }
+
+    // every crop came out exactly once
+    vector<int> allIDs;
+    for (int t = 0; t < numThreads; t++) {
+        allIDs.insert(allIDs.end(), poppedIDs[t].begin(), poppedIDs[t].end());
+    }
+    sort(allIDs.begin(), allIDs.end());
+    if ((int)allIDs.size() != perThread * numThreads || queue.numCrops() != 0) {
+        return false;
+    }
+    for (int i = 0; i < (int)allIDs.size(); i++) {
+        if (allIDs[i] != MINCROPID + i) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Tester::testMoveSwap(IQueue& queue) { // queue should be a priorityFn2 + min heap
+    int numCrops = queue.numCrops();
+    Crop extra(MINCROPID, MINTEMP, MAXMOISTURE, MINTIME, MINTYPE); // the lowest priority crop there is
+    CropHandle handle = queue.insertCrop(extra);
+    numCrops++;
+
+    // moving hands over the Nodes, the handle stays good
+    Node* root = queue.m_heap;
+    IQueue moved(std::move(queue));
+    if (moved.m_heap != root || moved.numCrops() != numCrops || queue.m_heap != nullptr || queue.numCrops() != 0
+        || queue.m_pool.numChunks() != 0) {
+        return false;
+    }
+    moved.updateCrop(handle, Crop(MINCROPID, MINTEMP, MINMOISTURE, MINTIME, MINTYPE));
+    if (moved.getNextCrop().getMoisture() != MINMOISTURE) {
+        return false;
+    }
+    numCrops--;
+
+    // the moved-from queue still works
+    queue.insertCrop(extra);
+    if (queue.numCrops() != 1 || queue.getNextCrop().getCropID() != MINCROPID) {
+        return false;
+    }
+
+    // swapping with another engine swaps the engines too
+    IQueue dary(priorityFn1, MAXHEAP, DARYHEAP4);
+    dary.insertCrop(extra);
+    moved.swap(dary);
+    if (moved.getEngine() != DARYHEAP4 || moved.numCrops() != 1 || moved.getHeapType() != MAXHEAP
+        || dary.getEngine() != SKEWHEAP || dary.numCrops() != numCrops || dary.getHeapType() != MINHEAP) {
+        return false;
+    }
+
+    // copy assignment is a deep copy, the two queues do not share Nodes
+    moved = dary;
+    if (moved.getEngine() != SKEWHEAP || moved.numCrops() != numCrops || moved.m_heap == dary.m_heap
+        || !checkParents(moved.m_heap) || !checkStoredPriority(moved.m_heap, priorityFn2, MINHEAP)) {
+        return false;
+    }
+    dary.clear();
+    if (countQueueSize(moved.m_heap) != numCrops) {
+        return false;
+    }
+
+    // move assignment drops what was there
+    IQueue bucket(priorityFn2, MINHEAP, 0, 103);
+    bucket.insertCrop(extra);
+    moved = std::move(bucket);
+    if (moved.getEngine() != BUCKETQUEUE || moved.numCrops() != 1 || moved.m_heap != nullptr || bucket.numCrops() != 0) {
+        return false;
+    }
+    return moved.getNextCrop().getCropID() == MINCROPID;
+}
+
+bool Tester::testMergeAll(vector<Crop>& crops) {
+    const int ZONES = 11;
+    int numCrops = crops.size();
+    ENGINE engines[3] = {SKEWHEAP, DARYHEAP4, SKEWHEAP};
+
+    for (int round = 0; round < 3; round++) {
+        // zones of different sizes, the last round mixes in a 4-ary heap zone
+        IQueue target(priorityFn2, MINHEAP, engines[round]);
+        vector<IQueue*> zones;
+        int start = 0;
+        for (int z = 0; z < ZONES; z++) {
+            int end = (z == ZONES - 1) ? numCrops : start + (z + 1) * numCrops / (ZONES * (ZONES + 1) / 2);
+            ENGINE engine = (round == 2 && z == 3) ? DARYHEAP4 : engines[round];
+            zones.push_back(new IQueue(priorityFn2, MINHEAP, engine));
+            zones.back()->insertCrops(crops.data() + start, end - start);
+            start = end;
+        }
+        zones.push_back(zones[0]); // a queue listed twice is merged once
+        zones.push_back(nullptr);
+
+        target.mergeAll(zones.data(), zones.size(), round + 1);
+        bool passed = target.numCrops() == numCrops;
+        for (int z = 0; z < ZONES; z++) {
+            passed = passed && zones[z]->numCrops() == 0;
+            delete zones[z];
+        }
+        if (!passed) {
+            return false;
+        }
+        if (target.getEngine() == SKEWHEAP && (countQueueSize(target.m_heap) != numCrops
+            || !checkParents(target.m_heap) || !checkStoredPriority(target.m_heap, priorityFn2, MINHEAP))) {
+            return false;
+        }
+        if (!testHeapAscending(target)) {
+            return false;
+        }
+    }
+
+    // the queues pair up in the order the caller lists them, not by address,
+    // so crops with equal priorities come out the same way on every run
+    vector<IQueue*> listed;
+    vector<IQueue> copies;
+    copies.reserve(ZONES);
+    for (int z = 0; z < ZONES; z++) {
+        listed.push_back(new IQueue(priorityFn2, MINHEAP));
+        listed.back()->insertCrops(crops.data() + z * (numCrops / ZONES), numCrops / ZONES);
+    }
+    reverse(listed.begin(), listed.end());
+    IQueue merged(priorityFn2, MINHEAP);
+    vector<IQueue*> tree(1, new IQueue(priorityFn2, MINHEAP));
+    for (int z = 0; z < ZONES; z++) {
+        copies.push_back(*listed[z]);
+        tree.push_back(&copies.back());
+    }
+    for (unsigned int stride = 1; stride < tree.size(); stride *= 2) {
+        for (unsigned int i = 0; i + stride < tree.size(); i += 2 * stride) {
+            tree[i]->mergeWithQueue(*tree[i + stride]);
+        }
+    }
+    listed.push_back(listed[1]);
+    merged.mergeAll(listed.data(), listed.size());
+    bool sameOrder = merged.numCrops() == tree[0]->numCrops();
+    while (sameOrder && merged.numCrops() > 0) {
+        sameOrder = merged.getNextCrop().getCropID() == tree[0]->getNextCrop().getCropID();
+    }
+    delete tree[0];
+    for (int z = 0; z < ZONES; z++) {
+        delete listed[z];
+    }
+    if (!sameOrder) {
         return false;
     }
 
-    while(queue.m_heap != nullptr) { // we compare queues...
-        Crop queueCrop = queue.getNextCrop();
-        Crop testQueueCrop = testQueue.getNextCrop();
-        if ((queueCrop.getCropID() != testQueueCrop.getCropID()) || (queueCrop.getTemperature() != testQueueCrop.getTemperature()) 
-            || (queueCrop.getMoisture() != testQueueCrop.getMoisture()) || (queueCrop.getTimeString() != testQueueCrop.getTimeString())
-            || (queueCrop.getTypeString() != testQueueCrop.getTypeString())) {
+    // a different priority function is caught before anything moves
+    IQueue target(priorityFn2, MINHEAP);
+    IQueue same(priorityFn2, MINHEAP, crops);
+    IQueue other(priorityFn1, MAXHEAP, crops);
+    IQueue* zones[2] = {&same, &other};
+    try {
+        target.mergeAll(zones, 2, 2);
+        return false;
+    } catch (std::domain_error&) {}
+    if (target.numCrops() != 0 || same.numCrops() != numCrops || other.numCrops() != numCrops) {
+        return false;
+    }
+
+    // so is a crop ID that would show up twice in an indexed queue, even when
+    // it only meets its twin in a later round
+    IQueue indexed(priorityFn2, MINHEAP);
+    indexed.enableCropIndex();
+    indexed.insertCrop(crops[0]);
+    IQueue first(priorityFn2, MINHEAP);
+    IQueue second(priorityFn2, MINHEAP);
+    IQueue third(priorityFn2, MINHEAP, DARYHEAP4);
+    first.insertCrops(crops.data() + 1, numCrops / 2);
+    second.insertCrops(crops.data() + 1 + numCrops / 2, numCrops / 2 - 1);
+    third.insertCrop(crops[0]);
+    IQueue* twins[3] = {&first, &second, &third};
+    try {
+        indexed.mergeAll(twins, 3, 2);
+        return false;
+    } catch (std::domain_error&) {}
+    return indexed.numCrops() == 1 && first.numCrops() == numCrops / 2
+        && second.numCrops() == numCrops / 2 - 1 && third.numCrops() == 1;
+}
+
+bool Tester::testPersistentQueue(vector<Crop>& crops) {
+    typedef PersistentIQueue<FnPriority, HeapOrder> Snapshots;
+    int numCrops = crops.size();
+    int half = numCrops / 2;
+
+    // half the crops built bottom-up, the rest inserted one by one
+    Snapshots version(crops.data(), half, FnPriority(priorityFn2), HeapOrder(MINHEAP));
+    Snapshots empty = version.removeNextCrop().mergeWithQueue(Snapshots(nullptr, 0, FnPriority(priorityFn2), HeapOrder(MINHEAP)));
+    for (int i = half; i < numCrops; i++) {
+        version = version.insertCrop(crops[i]);
+    }
+    if (version.numCrops() != numCrops || empty.numCrops() != half - 1) {
+        return false;
+    }
+
+    // every subtree is heap ordered, leftist and knows its size
+    vector<const Snapshots::PNode*> stack(1, version.m_heap.get());
+    while (!stack.empty()) {
+        const Snapshots::PNode* node = stack.back();
+        stack.pop_back();
+        const Snapshots::PNode* children[2] = {node->m_left.get(), node->m_right.get()};
+        int sizes = 1;
+        for (int i = 0; i < 2; i++) {
+            if (children[i] == nullptr)
+                continue;
+            if (children[i]->m_priority < node->m_priority)
+                return false;
+            sizes += children[i]->m_size;
+            stack.push_back(children[i]);
+        }
+        int leftRank = children[0] == nullptr ? 0 : children[0]->m_rank;
+        int rightRank = children[1] == nullptr ? 0 : children[1]->m_rank;
+        if (node->m_size != sizes || leftRank < rightRank || node->m_rank != rightRank + 1)
+            return false;
+    }
+
+    // draining a snapshot leaves the original alone, both pop in IQueue's order
+    Snapshots snapshot = version;
+    IQueue queue(priorityFn2, MINHEAP, crops);
+    vector<int> priorities;
+    while (snapshot.numCrops() > 0) {
+        int expected = priorityFn2(queue.getNextCrop());
+        if (snapshot.getNextPriority() != expected || priorityFn2(snapshot.getNextCrop()) != expected) {
+            return false;
+        }
+        priorities.push_back(expected);
+        snapshot = snapshot.removeNextCrop();
+    }
+    if (version.numCrops() != numCrops) {
+        return false;
+    }
+    for (int i = 0; i < numCrops; i++) {
+        if (version.getNextPriority() != priorities[i]) {
             return false;
         }
+        version = version.removeNextCrop();
     }
 
-    return testQueue.m_size == 0; // if testQueue is empty, that means everything has been deleted, the count was the same, and that no differences were found...
+    // a left spine as long as the heap is dropped without deep recursion
+    FnPriority byID(priorityByID);
+    Snapshots chain(byID, HeapOrder(MAXHEAP));
+    for (int i = 0; i < 200000; i++) {
+        chain = chain.insertCrop(Crop(MINCROPID + i, MINTEMP, MINMOISTURE, MINTIME, MINTYPE));
+    }
+    if (chain.numCrops() != 200000 || chain.getNextCrop().getCropID() != MINCROPID + 199999) {
+        return false;
+    }
+    chain = Snapshots(byID, HeapOrder(MAXHEAP));
+
+    try {
+        chain.getNextCrop(); // exception should be thrown
+    } catch (std::domain_error&) {
+        return true;
+    }
+    return false;
 }
 
-bool Tester::testDeQueueEmpty() {
-    IQueue testQueue(priorityFn2, MINHEAP);
+bool Tester::testLinearPriority(vector<Crop>& crops) {
+    int numCrops = crops.size();
+
+    // the packed Crop still checks its ranges like before
+    Crop packed(MAXCROPID, MAXTEMP, MINMOISTURE, NIGHT, SUGARCANE);
+    Crop invalid(MAXCROPID + 1, MAXTEMP + 1, MAXMOISTURE + 1, MAXTIME + 1, MAXTYPE + 1);
+    if (sizeof(Crop) != 8 || packed.getCropID() != MAXCROPID || packed.getTemperature() != MAXTEMP
+        || packed.getMoisture() != MINMOISTURE || packed.getTime() != NIGHT || packed.getType() != SUGARCANE
+        || invalid.getCropID() != DEFAULTCROPID || invalid.getTemperature() != MINTEMP
+        || invalid.getMoisture() != MAXMOISTURE || invalid.getTime() != MAXTIME || invalid.getType() != MINTYPE) {
+        return false;
+    }
+
+    // the batch evaluator agrees with the sample functions and a crop at a time
+    LinearPriority heat(0, 1, 0, 0, 1);         // priorityFn1
+    LinearPriority dryness(0, 0, 1, 1, 0);      // priorityFn2
+    LinearPriority mixed(-7, 3, -2, 11, -5);
+    vector<int> priorities(numCrops);
+    computePriorities(heat, crops.data(), numCrops, priorities.data());
+    for (int i = 0; i < numCrops; i++) {
+        if (priorities[i] != priorityFn1(crops[i])) {
+            return false;
+        }
+    }
+    computePriorities(dryness, crops.data(), numCrops, priorities.data());
+    for (int i = 0; i < numCrops; i++) {
+        if (priorities[i] != priorityFn2(crops[i])) {
+            return false;
+        }
+    }
+    computePriorities(mixed, crops.data(), numCrops, priorities.data());
+    for (int i = 0; i < numCrops; i++) {
+        if (priorities[i] != mixed(crops[i])) {
+            return false;
+        }
+    }
+
+    // bulk loads and rebuilds through the batch evaluator pop in the right order
+    BasicIQueue<LinearPriority, MinOrder> skew(dryness);
+    skew.insertCrops(crops.data(), numCrops);
+    DaryIQueue<LinearPriority, HeapOrder, 4> dary(dryness, HeapOrder(MINHEAP));
+    dary.insertCrops(crops.data(), numCrops);
+    dary.setPriority(heat, HeapOrder(MAXHEAP));
+    IQueue fnQueue(priorityFn1, MAXHEAP, crops);
+    if (!checkStoredPriority(skew.m_heap, priorityFn2, MINHEAP) || skew.numCrops() != numCrops) {
+        return false;
+    }
+    for (int i = 0; i < numCrops; i++) {
+        if (priorityFn1(dary.getNextCrop()) != priorityFn1(fnQueue.getNextCrop())) {
+            return false;
+        }
+    }
+    if (dary.numCrops() != 0) {
+        return false;
+    }
+
+    // a function pointer with a LinearPriority behind it is evaluated through that one
+    computePriorities(FnPriority(priorityFn2, dryness), crops.data(), numCrops, priorities.data());
+    for (int i = 0; i < numCrops; i++) {
+        if (priorities[i] != priorityFn2(crops[i])) {
+            return false;
+        }
+    }
+    IQueue linearQueue(priorityFn2, MINHEAP, DARYHEAP4);
+    linearQueue.setPriorityFn(priorityFn2, MINHEAP, dryness);
+    linearQueue.insertCrops(crops.data(), numCrops);
+    linearQueue.setPriorityFn(priorityFn1, MAXHEAP, heat);
+    fnQueue.insertCrops(crops.data(), numCrops);
+    if (linearQueue.getPriority().getLinear() == nullptr || linearQueue.getPriorityFn() != priorityFn1) {
+        return false;
+    }
+    for (int i = 0; i < numCrops; i++) {
+        if (priorityFn1(linearQueue.getNextCrop()) != priorityFn1(fnQueue.getNextCrop())) {
+            return false;
+        }
+    }
+    if (linearQueue.numCrops() != 0) {
+        return false;
+    }
 
+    // a LinearPriority that does not match its function is refused and changes nothing
+    linearQueue.insertCrops(crops.data(), numCrops);
+    fnQueue.insertCrops(crops.data(), numCrops);
     try {
-        testQueue.getNextCrop(); // exception should be thrown
-        return false; // did not throw out of range
-    } catch (domain_error& err) {
+        linearQueue.setPriorityFn(priorityFn2, MINHEAP, mixed);
+        return false;
+    } catch (invalid_argument&) {
+    }
+    try {
+        FnPriority mismatched(priorityFn1, dryness);
+        return false;
+    } catch (invalid_argument&) {
+    }
+    return linearQueue.getPriorityFn() == priorityFn1 && linearQueue.getHeapType() == MAXHEAP
+           && linearQueue.getPriority().getLinear() != nullptr && linearQueue.numCrops() == numCrops
+           && priorityFn1(linearQueue.getNextCrop()) == priorityFn1(fnQueue.getNextCrop());
+}
+
+bool Tester::testMultiView(vector<Crop>& crops) {
+    int numCrops = crops.size();
+    MultiViewQueue queue;
+    int heat = queue.addView(priorityFn1, MAXHEAP);
+    int half = numCrops / 2;
+    for (int i = 0; i < half; i++) {
+        queue.insertCrop(crops[i]);
+    }
+    int dryness = queue.addView(priorityFn2, MINHEAP); // picks up the crops already there
+    for (int i = half; i < numCrops; i++) {
+        queue.insertCrop(crops[i]);
+    }
+    if (queue.numCrops() != numCrops || queue.numViews() != 2 || queue.getHeapType(dryness) != MINHEAP) {
+        return false;
+    }
+
+    // pop from both views in turn, each pop is the best crop left by that view
+    vector<bool> left(numCrops, true);
+    for (int i = 0; i < numCrops; i++) {
+        int view = (i % 3 == 0) ? dryness : heat;
+        prifn_t priFn = queue.getPriorityFn(view);
+        int best = -1;
+        for (int c = 0; c < numCrops; c++) {
+            if (!left[c])
+                continue;
+            int priority = priFn(crops[c]);
+            if (best == -1 || (view == heat ? priority > best : priority < best))
+                best = priority;
+        }
+        if (queue.getNextPriority(view) != best) {
+            return false;
+        }
+        Crop crop = queue.getNextCrop(view);
+        int index = crop.getCropID() - MINCROPID;
+        if (priFn(crop) != best || !left[index]) {
+            return false;
+        }
+        left[index] = false;
+
+        // stale entries never pile up past the compaction bound
+        for (int v = 0; v < 2; v++) {
+            if ((int)queue.m_views[v].m_heap.size() > 2 * queue.numCrops() + COMPACTSLACK)
+                return false;
+        }
+    }
+
+    // freed slots are reused, and a bad view is caught
+    queue.insertCrop(crops[0]);
+    if (queue.numCrops() != 1 || queue.m_crops.size() != (unsigned int)numCrops || queue.getNextCrop(dryness).getCropID() != MINCROPID) {
+        return false;
+    }
+    try {
+        queue.getNextCrop(2);
+    } catch (std::out_of_range&) {
+        try {
+            queue.getNextCrop(heat); // exception should be thrown
+        } catch (std::domain_error&) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Tester::testIntervalEngine(IQueue& queue) { // queue should be a priorityFn2 + min heap
+    int numCrops = queue.numCrops();
+    if (queue.getEngine() != INTERVALHEAP) {
+        return false;
+    }
+
+    // every priority, lowest first, from a copy drained from the front
+    IQueue copyQueue(queue);
+    vector<Crop> crops;
+    vector<int> sorted;
+    while (copyQueue.numCrops() > 0) {
+        crops.push_back(copyQueue.getNextCrop());
+        sorted.push_back(priorityFn2(crops.back()));
+    }
+    for (int i = 1; i < numCrops; i++) {
+        if (sorted[i] < sorted[i - 1]) {
+            return false;
+        }
+    }
+
+    // take from both ends in turn, they meet in the middle
+    int front = 0, back = numCrops - 1;
+    for (int i = 0; i < numCrops; i++) {
+        if (i % 3 == 2) {
+            if (priorityFn2(queue.getLastCrop()) != sorted[back--])
+                return false;
+        } else {
+            if (priorityFn2(queue.getNextCrop()) != sorted[front++])
+                return false;
+        }
+    }
+    if (queue.numCrops() != 0) {
+        return false;
+    }
+
+    // a bulk load with the other priority function turns both ends around
+    queue.insertCrops(crops.data(), numCrops);
+    queue.setPriorityFn(priorityFn1, MAXHEAP);
+    int highest = priorityFn1(queue.getNextCrop());
+    int lowest = priorityFn1(queue.getLastCrop());
+    for (int i = 0; i < numCrops; i++) {
+        if (priorityFn1(crops[i]) > highest || priorityFn1(crops[i]) < lowest)
+            return false;
+    }
+
+    // only this engine has a last crop
+    IQueue skewQueue(priorityFn2, MINHEAP);
+    skewQueue.insertCrop(crops[0]);
+    try {
+        skewQueue.getLastCrop();
+    } catch (std::domain_error&) {
+        return queue.numCrops() == numCrops - 2;
+    }
+    return false;
+}
+
+bool Tester::testBoundedQueue(vector<Crop>& crops) {
+    const int CAPACITY = 100;
+    int numCrops = crops.size();
+    BoundedIQueue<FnPriority, HeapOrder> queue(CAPACITY, FnPriority(priorityFn1), HeapOrder(MAXHEAP));
+    const Crop* storage = queue.m_heap.m_crops.data();
+
+    // stream every crop through, the queue never grows past its capacity
+    int kept = 0;
+    for (int i = 0; i < numCrops; i++) {
+        if (queue.insertCrop(crops[i]))
+            kept++;
+        if (queue.numCrops() != min(i + 1, CAPACITY))
+            return false;
+    }
+    // every crop past the capacity was either turned away or pushed one out
+    if (queue.m_heap.m_crops.data() != storage || queue.numRejected() != numCrops - CAPACITY
+        || kept < CAPACITY) {
+        return false;
+    }
+
+    // it holds the CAPACITY highest priorities of the stream
+    vector<int> priorities(numCrops);
+    for (int i = 0; i < numCrops; i++)
+        priorities[i] = priorityFn1(crops[i]);
+    sort(priorities.begin(), priorities.end(), greater<int>());
+    if (queue.getLastPriority() != priorities[CAPACITY - 1]) {
+        return false;
+    }
+
+    // nothing at or below the worst gets in
+    Crop weakest(MINCROPID, MINTEMP, MAXMOISTURE, MAXTIME, MINTYPE);
+    if (queue.insertCrop(weakest) || queue.numCrops() != CAPACITY) {
+        return false;
+    }
+    Crop top[CAPACITY];
+    if (queue.getNextCrops(CAPACITY, top) != CAPACITY) {
+        return false;
+    }
+    for (int i = 0; i < CAPACITY; i++) {
+        if (priorityFn1(top[i]) != priorities[i])
+            return false;
+    }
+
+    // a capacity of one keeps the single best crop
+    BoundedIQueue<FnPriority, HeapOrder> single(1, FnPriority(priorityFn1), HeapOrder(MAXHEAP));
+    single.insertCrops(crops.data(), numCrops);
+    if (single.numCrops() != 1 || priorityFn1(single.getLastCrop()) != priorities[0]) {
+        return false;
+    }
+    try {
+        BoundedIQueue<FnPriority, HeapOrder> none(0, FnPriority(priorityFn1), HeapOrder(MAXHEAP));
+    } catch (std::domain_error&) {
         return true;
     }
+    return false;
 }
 
-bool Tester::testMergeQueueDiffPrior(IQueue& queue1, IQueue& queue2) {
+bool Tester::testExternalQueue(vector<Crop>& crops) {
+    // the record format gives back the same crop
+    unsigned char record[CROPRECORDSIZE];
+    for (int i = 0; i < 100; i++) {
+        encodeCrop(crops[i], record);
+        Crop copy = decodeCrop(record);
+        if (copy.getCropID() != crops[i].getCropID() || copy.getTemperature() != crops[i].getTemperature()
+            || copy.getMoisture() != crops[i].getMoisture() || copy.getTime() != crops[i].getTime()
+            || copy.getType() != crops[i].getType()) {
+            return false;
+        }
+    }
+
+    // the smallest memory there is, so the crops go through more than MAXRUNS runs
+    int numCrops = crops.size();
+    ExternalIQueue queue(priorityFn2, MINHEAP, RUNBLOCK);
+    IQueue reference(priorityFn2, MINHEAP, DARYHEAP4);
+    int half = numCrops / 2;
+    queue.insertCrops(crops.data(), half);
+    reference.insertCrops(crops.data(), half);
+    for (int i = half; i < numCrops; i++) {
+        queue.insertCrop(crops[i]);
+        reference.insertCrop(crops[i]);
+        if (i % 3 == 0 && priorityFn2(queue.getNextCrop()) != priorityFn2(reference.getNextCrop()))
+            return false;
+    }
+    if (queue.numSpilled() <= numCrops || queue.numRuns() > MAXRUNS + 1
+        || queue.numCrops() != reference.numCrops()) {
+        return false;
+    }
+
+    // the merged pops come out in order
+    while (reference.numCrops() > 0) {
+        if (queue.getNextPriority() != reference.getNextPriority()
+            || priorityFn2(queue.getNextCrop()) != priorityFn2(reference.getNextCrop()))
+            return false;
+    }
+    if (queue.numCrops() != 0 || queue.numRuns() != 0) {
+        return false;
+    }
+
+    // three times MAXRUNS spills, the runs of one level are merged together,
+    // so every crop is written once when spilled and once more at most
+    long long spills = 3 * MAXRUNS;
+    long long total = spills * RUNBLOCK;
+    queue.clear();
+    for (long long i = 0; i < total; i += numCrops) {
+        queue.insertCrops(crops.data(), (int)min((long long)numCrops, total - i));
+    }
+    if (queue.numCrops() != total || queue.numRuns() > MAXRUNS || queue.numSpilled() > 2 * total) {
+        return false;
+    }
+    int last = queue.getNextPriority();
+    while (queue.numCrops() > 0) {
+        int priority = priorityFn2(queue.getNextCrop());
+        if (priority < last)
+            return false;
+        last = priority;
+    }
+    queue.clear();
+
+    // a queue that never spilled is just the memory heap
+    queue.insertCrops(crops.data(), 10);
+    queue.clear();
+    if (queue.numCrops() != 0 || queue.numSpilled() != 0) {
+        return false;
+    }
     try {
-        queue1.mergeWithQueue(queue2); // exception should be thrown
-        return false; // did not throw out of range
-    } catch (domain_error& err) {
+        ExternalIQueue tooSmall(priorityFn2, MINHEAP, RUNBLOCK - 1);
+    } catch (std::domain_error&) {
         return true;
     }
+    return false;
+}
+
+bool Tester::testCropFile(vector<Crop>& crops) {
+    const char* csvPath = "mytest-crops.csv";
+    const char* binaryPath = "mytest-crops.bin";
+    int numCrops = crops.size();
+
+    // a header, \r\n line ends, two bad lines and two crops out of range
+    FILE* csv = fopen(csvPath, "w");
+    FILE* binary = fopen(binaryPath, "wb");
+    if (csv == nullptr || binary == nullptr)
+        return false;
+    fprintf(csv, "id,temperature,moisture,time,type\r\n");
+    unsigned char record[CROPRECORDSIZE];
+    for (int i = 0; i < numCrops; i++) {
+        const Crop& crop = crops[i];
+        fprintf(csv, "%d,%d, %d,%d,%d\r\n", crop.getCropID(), crop.getTemperature(),
+                crop.getMoisture(), crop.getTime(), crop.getType());
+        encodeCrop(crop, record);
+        fwrite(record, CROPRECORDSIZE, 1, binary);
+    }
+    fprintf(csv, "100001,50,20\n\nnot,a,crop,at,all\n100002,200,20,1,1\n-5,50,20,1,1");
+    fwrite(record, 3, 1, binary); // a cut off record
+    fclose(csv);
+    fclose(binary);
+
+    bool result = true;
+    CropFileLoader csvLoader(csvPath, CSVFILE);
+    vector<Crop> loaded;
+    if (csvLoader.readCrops(loaded) != numCrops + 2 || csvLoader.numMalformed() != 2
+        || csvLoader.numOutOfRange() != 2) {
+        result = false;
+    }
+    for (int i = 0; i < numCrops && result; i++) {
+        if (loaded[i].getCropID() != crops[i].getCropID() || priorityFn1(loaded[i]) != priorityFn1(crops[i])
+            || priorityFn2(loaded[i]) != priorityFn2(crops[i]))
+            result = false;
+    }
+    // the out of range fields got the constructor defaults
+    if (result && (loaded[numCrops].getTemperature() != MINTEMP || loaded[numCrops + 1].getCropID() != DEFAULTCROPID)) {
+        result = false;
+    }
+
+    // both formats fill a queue through the pipeline, small batches so it takes many rounds
+    IQueue fromCSV(priorityFn2, MINHEAP, DARYHEAP4);
+    IQueue fromBinary(priorityFn2, MINHEAP, DARYHEAP4);
+    CropFileLoader binaryLoader(binaryPath, BINARYFILE);
+    if (result && (csvLoader.loadInto(fromCSV, 1000) != numCrops + 2
+        || binaryLoader.loadInto(fromBinary, 1000) != numCrops || binaryLoader.numMalformed() != 1)) {
+        result = false;
+    }
+    IQueue expected(priorityFn2, MINHEAP, loaded);
+    while (result && expected.numCrops() > 0) {
+        if (priorityFn2(fromCSV.getNextCrop()) != priorityFn2(expected.getNextCrop()))
+            result = false;
+    }
+    IQueue original(priorityFn2, MINHEAP, crops);
+    while (result && original.numCrops() > 0) {
+        if (priorityFn2(fromBinary.getNextCrop()) != priorityFn2(original.getNextCrop()))
+            result = false;
+    }
+    remove(csvPath);
+    remove(binaryPath);
+
+    try {
+        CropFileLoader missing("mytest-no-such-file.csv", CSVFILE);
+    } catch (std::runtime_error&) {
+        return result;
+    }
+    return false;
+}
+
+bool Tester::testNextPriorityEngines(vector<Crop>& crops) {
+    IQueue skew(priorityFn1, MAXHEAP, crops, SKEWHEAP);
+    IQueue dary4(priorityFn1, MAXHEAP, crops, DARYHEAP4);
+    IQueue dary8(priorityFn1, MAXHEAP, crops, DARYHEAP8);
+    IQueue interval(priorityFn1, MAXHEAP, crops, INTERVALHEAP);
+    IQueue bucket(priorityFn1, MAXHEAP, MINTEMP + MINTYPE, MAXTEMP + MAXTYPE);
+    bucket.insertCrops(crops.data(), crops.size());
+    IQueue* queues[5] = {&skew, &dary4, &dary8, &interval, &bucket};
+
+    // the priority reported is the one of the crop that comes out next
+    for (int q = 0; q < 5; q++) {
+        while (queues[q]->numCrops() > 0) {
+            int priority = queues[q]->getNextPriority();
+            if (priorityFn1(queues[q]->getNextCrop()) != priority)
+                return false;
+        }
+        try {
+            queues[q]->getNextPriority();
+            return false;
+        } catch (std::domain_error&) {
+        }
+    }
+    return bucket.getEngine() == BUCKETQUEUE;
+}
+
+bool Tester::testEngineFacade(vector<Crop>& crops) {
+    // the skew heap base of an engine queue is empty, nobody outside IQueue may see it
+    static_assert(!is_convertible<IQueue*, BasicIQueue<FnPriority, HeapOrder>*>::value,
+                  "IQueue must not convert to its skew heap base");
+
+    IQueue queue(priorityFn1, MAXHEAP, crops, DARYHEAP4);
+    if (queue.numCrops() != (int)crops.size() || queue.hasCropIndex()
+        || queue.getPriorityFn() != priorityFn1 || queue.getHeapType() != MAXHEAP) {
+        return false;
+    }
+
+    // a new priority function reaches the engine, not just the base
+    queue.setPriorityFn(priorityFn2, MINHEAP);
+    if (queue.getPriorityFn() != priorityFn2 || queue.getHeapType() != MINHEAP) {
+        return false;
+    }
+    int last = priorityFn2(queue.getNextCrop());
+    while (queue.numCrops() > 0) {
+        int priority = priorityFn2(queue.getNextCrop());
+        if (priority < last)
+            return false;
+        last = priority;
+    }
+    return true;
+}
+
+bool Tester::testBucketEngineNeedsRange() {
+    // without a range there are no buckets, the queue must not quietly become a skew heap
+    try {
+        IQueue queue(priorityFn2, MINHEAP, BUCKETQUEUE);
+        return false;
+    } catch (domain_error&) {}
+
+    vector<Crop> crops(1, Crop(MINCROPID, MINTEMP, MINMOISTURE, MINTIME, MINTYPE));
+    try {
+        IQueue queue(priorityFn2, MINHEAP, crops, BUCKETQUEUE);
+        return false;
+    } catch (domain_error&) {}
+    return true;
+}
+
+// Caps the size of any file this process writes, 0 lifts the cap. Past
+// the cap a write fails with EFBIG instead of raising SIGXFSZ
+static void capFileSize(rlim_t bytes) {
+    static struct rlimit original;
+    static bool saved = false;
+    if (!saved) {
+        getrlimit(RLIMIT_FSIZE, &original);
+        signal(SIGXFSZ, SIG_IGN);
+        saved = true;
+    }
+    struct rlimit limit = original;
+    if (bytes > 0)
+        limit.rlim_cur = bytes;
+    setrlimit(RLIMIT_FSIZE, &limit);
+}
+
+bool Tester::testExternalQueueFailures(vector<Crop>& crops) {
+    int numCrops = crops.size();
+    long long runBytes = (long long)RUNBLOCK * CROPRECORDSIZE;
+    IQueue reference(priorityFn2, MINHEAP, DARYHEAP4);
+
+    // a spill that cannot be written keeps its crops in memory
+    ExternalIQueue queue(priorityFn2, MINHEAP, RUNBLOCK);
+    queue.insertCrops(crops.data(), RUNBLOCK);
+    reference.insertCrops(crops.data(), RUNBLOCK);
+    capFileSize(runBytes / 2);
+    bool thrown = false;
+    try {
+        queue.insertCrop(crops[RUNBLOCK]);
+    } catch (std::runtime_error&) {
+        thrown = true;
+    }
+    capFileSize(0);
+    if (!thrown || queue.numCrops() != RUNBLOCK || queue.numRuns() != 0 || queue.m_memory.numCrops() != RUNBLOCK)
+        return false;
+
+    // so does a merge that cannot be written, and the old runs stay readable
+    for (int i = RUNBLOCK; i < numCrops - 1; i++) {
+        queue.insertCrop(crops[i]);
+        reference.insertCrop(crops[i]);
+    }
+    if (queue.numRuns() != MAXRUNS)
+        return false;
+    capFileSize(runBytes * 2);
+    thrown = false;
+    try {
+        queue.insertCrop(crops[numCrops - 1]);
+    } catch (std::runtime_error&) {
+        thrown = true;
+    }
+    capFileSize(0);
+    if (!thrown || queue.numRuns() != MAXRUNS || queue.numCrops() != reference.numCrops())
+        return false;
+    queue.insertCrop(crops[numCrops - 1]);
+    reference.insertCrop(crops[numCrops - 1]);
+    if (queue.numRuns() != 2 || queue.numCrops() != reference.numCrops())
+        return false;
+    while (reference.numCrops() > 0) {
+        if (priorityFn2(queue.getNextCrop()) != priorityFn2(reference.getNextCrop()))
+            return false;
+    }
+
+    // a run that ends early is dropped and no longer counted
+    ExternalIQueue broken(priorityFn2, MINHEAP, 2 * RUNBLOCK);
+    broken.insertCrops(crops.data(), 2 * RUNBLOCK + 1);
+    if (broken.numRuns() != 1 || ftruncate(fileno(broken.m_runs[0]->m_file), runBytes) != 0)
+        return false;
+    thrown = false;
+    try {
+        while (broken.numCrops() > 0)
+            broken.getNextCrop();
+    } catch (std::runtime_error&) {
+        thrown = true;
+    }
+    return thrown && broken.numRuns() == 0 && broken.numCrops() == broken.m_memory.numCrops();
+}
+
+bool Tester::testIndexedMergeDuplicates(vector<Crop>& crops) {
+    int numCrops = crops.size();
+    int half = numCrops / 2;
+
+    // rhs has no index, so nothing stopped it from taking the same ID twice
+    IQueue indexed(priorityFn2, MINHEAP);
+    indexed.enableCropIndex();
+    indexed.insertCrops(crops.data(), half);
+    IQueue twins(priorityFn2, MINHEAP);
+    twins.insertCrops(crops.data() + half, numCrops - half);
+    Crop twin(crops.back().getCropID(), MAXTEMP, MINMOISTURE, MINTIME, MAXTYPE);
+    twins.insertCrop(twin);
+    try {
+        indexed.mergeWithQueue(twins);
+        return false;
+    } catch (std::domain_error&) {}
+
+    // nothing moved and the index still points at our own Nodes
+    if (indexed.numCrops() != half || twins.numCrops() != numCrops - half + 1
+        || countQueueSize(indexed.m_heap) != half || indexed.m_index.size() != (unsigned int)half) {
+        return false;
+    }
+    for (int i = 0; i < half; i++) {
+        if (indexed.m_index.at(crops[i].getCropID())->m_crop.getCropID() != crops[i].getCropID()) {
+            return false;
+        }
+    }
+
+    // without the twin the same merge goes through and every crop can be found
+    IQueue unique(priorityFn2, MINHEAP);
+    unique.insertCrops(crops.data() + half, numCrops - half);
+    indexed.mergeWithQueue(unique);
+    if (indexed.numCrops() != numCrops || unique.numCrops() != 0 || indexed.m_index.size() != (unsigned int)numCrops) {
+        return false;
+    }
+    for (int i = 0; i < numCrops; i++) {
+        if (!indexed.removeCrop(crops[i].getCropID())) {
+            return false;
+        }
+    }
+    return indexed.numCrops() == 0;
 }
 
 int priorityFn1(const Crop &crop) {
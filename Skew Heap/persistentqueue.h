@@ -0,0 +1,262 @@
+// Date Created: November, 2022
+// Immutable priority queue for snapshots. Inserting, merging or removing
+// the top never changes a queue, it returns a new version that shares every
+// untouched subtree with the old one through reference counted Nodes. A
+// snapshot is a copy of the queue object and costs O(1).
+//
+// It is a leftist heap rather than a skew heap: the skew heap's O(log n)
+// bound is amortized and does not survive when an expensive version is
+// reused many times. The leftist heap keeps every right spine at most
+// log(n+1) long, so every operation copies O(log n) Nodes in the worst case.
+#ifndef PERSISTENTQUEUE_H
+#define PERSISTENTQUEUE_H
+#include "iqueue.h"
+#include <memory>
+
+template <class Priority, class Order>
+class PersistentIQueue{
+    public:
+    friend class Grader; // for grading purposes
+    friend class Tester; // for testing purposes
+
+    PersistentIQueue(Priority priority = Priority(), Order order = Order());
+    // Pairs up count crops bottom-up, O(count)
+    PersistentIQueue(const Crop* crops, int count, Priority priority = Priority(), Order order = Order());
+    // The next version, this one stays as it is. O(log n)
+    PersistentIQueue insertCrop(const Crop& crop) const;
+    PersistentIQueue removeNextCrop() const;
+    // rhs must use the same priority and order
+    PersistentIQueue mergeWithQueue(const PersistentIQueue& rhs) const;
+    // The highest priority crop, throws domain_error if empty
+    const Crop& getNextCrop() const;
+    int getNextPriority() const;
+    int numCrops() const;
+    void printCropsQueue() const; // Print the queue using preorder traversal
+    const Priority& getPriority() const;
+    const Order& getOrder() const;
+    void dump() const; // For debugging purposes
+
+    private:
+    class PNode;
+    typedef shared_ptr<const PNode> PNodePtr;
+
+    class PNode{
+        public:
+        PNode(const Crop& crop, int priority, const PNodePtr& left, const PNodePtr& right);
+        // drops long chains with a loop, a left spine can be as long as the heap
+        ~PNode();
+        Crop m_crop;
+        int m_priority;
+        int m_rank;             // length of the right spine, null counts 0
+        int m_size;             // Nodes in this subtree
+        mutable PNodePtr m_left;  // mutable only so ~PNode can take the children
+        mutable PNodePtr m_right;
+    };
+
+    PNodePtr m_heap;            // root of this version
+    Priority m_priorFunc;       // Computes the priority of a crop
+    Order m_order;              // Decides which of two priorities goes on top
+
+    PersistentIQueue(const PNodePtr& heap, const Priority& priority, const Order& order);
+    // copies the right spines of left and right, shares everything else
+    PNodePtr merge(const PNodePtr& left, const PNodePtr& right) const;
+    // a Node over two subtrees, the one with the longer right spine goes left
+    static PNodePtr makeNode(const Crop& crop, int priority, const PNodePtr& first, const PNodePtr& second);
+    static int rank(const PNodePtr& node) {return node == nullptr ? 0 : node->m_rank;}
+    static int size(const PNodePtr& node) {return node == nullptr ? 0 : node->m_size;}
+};
+
+template <class Priority, class Order>
+PersistentIQueue<Priority, Order>::PNode::PNode(const Crop& crop, int priority, const PNodePtr& left, const PNodePtr& right)
+  : m_crop(crop), m_priority(priority), m_left(left), m_right(right)
+{
+    m_rank = rank(right) + 1;
+    m_size = size(left) + 1 + size(right);
+}
+
+template <class Priority, class Order>
+PersistentIQueue<Priority, Order>::PNode::~PNode() {
+    vector<PNodePtr> stack;
+    stack.push_back(std::move(m_left));
+    stack.push_back(std::move(m_right));
+    while(!stack.empty()) {
+        PNodePtr node = std::move(stack.back());
+        stack.pop_back();
+        // only a Node nobody else shares dies here, take its children first
+        if(node != nullptr && node.use_count() == 1) {
+            stack.push_back(std::move(node->m_left));
+            stack.push_back(std::move(node->m_right));
+        }
+    }
+}
+
+template <class Priority, class Order>
+PersistentIQueue<Priority, Order>::PersistentIQueue(Priority priority, Order order) {
+    m_priorFunc = priority;
+    m_order = order;
+}
+
+template <class Priority, class Order>
+PersistentIQueue<Priority, Order>::PersistentIQueue(const Crop* crops, int count, Priority priority, Order order) {
+    m_priorFunc = priority;
+    m_order = order;
+
+    // merge neighbours round by round, every round halves the number of heaps
+    vector<PNodePtr> heaps;
+    heaps.reserve(count);
+    for(int i = 0; i < count; i++) {
+        heaps.push_back(makeNode(crops[i], m_priorFunc(crops[i]), nullptr, nullptr));
+    }
+    while(heaps.size() > 1) {
+        unsigned int merged = 0;
+        for(unsigned int i = 0; i < heaps.size(); i += 2) {
+            heaps[merged++] = (i + 1 < heaps.size()) ? merge(heaps[i], heaps[i + 1]) : heaps[i];
+        }
+        heaps.resize(merged);
+    }
+    if(!heaps.empty()) {
+        m_heap = heaps[0];
+    }
+}
+
+template <class Priority, class Order>
+PersistentIQueue<Priority, Order>::PersistentIQueue(const PNodePtr& heap, const Priority& priority, const Order& order)
+  : m_heap(heap), m_priorFunc(priority), m_order(order)
+{
+}
+
+template <class Priority, class Order>
+PersistentIQueue<Priority, Order> PersistentIQueue<Priority, Order>::insertCrop(const Crop& crop) const {
+    PNodePtr single = makeNode(crop, m_priorFunc(crop), nullptr, nullptr);
+    return PersistentIQueue(merge(m_heap, single), m_priorFunc, m_order);
+}
+
+template <class Priority, class Order>
+PersistentIQueue<Priority, Order> PersistentIQueue<Priority, Order>::removeNextCrop() const {
+    if(m_heap == nullptr) {
+        throw std::domain_error("You are attempting to get next crop from an empty heap!");
+    }
+    return PersistentIQueue(merge(m_heap->m_left, m_heap->m_right), m_priorFunc, m_order);
+}
+
+template <class Priority, class Order>
+PersistentIQueue<Priority, Order> PersistentIQueue<Priority, Order>::mergeWithQueue(const PersistentIQueue& rhs) const {
+    return PersistentIQueue(merge(m_heap, rhs.m_heap), m_priorFunc, m_order);
+}
+
+template <class Priority, class Order>
+const Crop& PersistentIQueue<Priority, Order>::getNextCrop() const {
+    if(m_heap == nullptr) {
+        throw std::domain_error("You are attempting to look at the next crop of an empty heap!");
+    }
+    return m_heap->m_crop;
+}
+
+template <class Priority, class Order>
+int PersistentIQueue<Priority, Order>::getNextPriority() const {
+    if(m_heap == nullptr) {
+        throw std::domain_error("You are attempting to look at the next crop of an empty heap!");
+    }
+    return m_heap->m_priority;
+}
+
+template <class Priority, class Order>
+int PersistentIQueue<Priority, Order>::numCrops() const {
+    return size(m_heap);
+}
+
+template <class Priority, class Order>
+void PersistentIQueue<Priority, Order>::printCropsQueue() const {
+    vector<const PNode*> stack;
+    if(m_heap != nullptr) {
+        stack.push_back(m_heap.get());
+    }
+    while(!stack.empty()) {
+        const PNode* node = stack.back();
+        stack.pop_back();
+        const Crop& crop = node->m_crop;
+        cout << "[" << node->m_priority << "] Crop ID:" <<  crop.getCropID() << ", current temperature: " << crop.getTemperature() << ", current soil moisture: " << crop.getMoisture() << "%, current time: " << crop.getTimeString() << ", plant type: " << crop.getTypeString() << endl;
+        if(node->m_right != nullptr) {
+            stack.push_back(node->m_right.get());
+        }
+        if(node->m_left != nullptr) {
+            stack.push_back(node->m_left.get());
+        }
+    }
+}
+
+template <class Priority, class Order>
+const Priority& PersistentIQueue<Priority, Order>::getPriority() const {
+    return m_priorFunc;
+}
+
+template <class Priority, class Order>
+const Order& PersistentIQueue<Priority, Order>::getOrder() const {
+    return m_order;
+}
+
+template <class Priority, class Order>
+void PersistentIQueue<Priority, Order>::dump() const {
+    if(m_heap == nullptr) {
+        cout << "Empty heap.\n" ;
+        return;
+    }
+
+    // in-order with an explicit stack, every node goes through three stages:
+    // 0 opens it and visits the left, 1 prints it and visits the right, 2 closes it
+    vector<pair<const PNode*, int> > stack(1, make_pair(m_heap.get(), 0));
+    while(!stack.empty()) {
+        const PNode* node = stack.back().first;
+        int stage = stack.back().second;
+        stack.back().second++;
+
+        if(stage == 0) {
+            cout << "(";
+            if(node->m_left != nullptr) {
+                stack.push_back(make_pair(node->m_left.get(), 0));
+            }
+        } else if(stage == 1) {
+            cout << node->m_priority << ":" << node->m_crop.getCropID();
+            if(node->m_right != nullptr) {
+                stack.push_back(make_pair(node->m_right.get(), 0));
+            }
+        } else {
+            cout << ")";
+            stack.pop_back();
+        }
+    }
+    cout << endl;
+}
+
+template <class Priority, class Order>
+typename PersistentIQueue<Priority, Order>::PNodePtr
+PersistentIQueue<Priority, Order>::merge(const PNodePtr& left, const PNodePtr& right) const {
+    // walk down both right spines, remembering the Node that wins each step
+    vector<const PNode*> spine;
+    PNodePtr first = left;
+    PNodePtr second = right;
+    while(first != nullptr && second != nullptr) {
+        if(!m_order(first->m_priority, second->m_priority)) {
+            swap(first, second);
+        }
+        spine.push_back(first.get());
+        first = first->m_right;
+    }
+    PNodePtr merged = (first != nullptr) ? first : second;
+
+    // copy the spine bottom-up, every copy keeps its old left subtree
+    for(int i = spine.size() - 1; i >= 0; i--) {
+        merged = makeNode(spine[i]->m_crop, spine[i]->m_priority, spine[i]->m_left, merged);
+    }
+    return merged;
+}
+
+template <class Priority, class Order>
+typename PersistentIQueue<Priority, Order>::PNodePtr
+PersistentIQueue<Priority, Order>::makeNode(const Crop& crop, int priority, const PNodePtr& first, const PNodePtr& second) {
+    if(rank(first) >= rank(second)) {
+        return make_shared<const PNode>(crop, priority, first, second);
+    }
+    return make_shared<const PNode>(crop, priority, second, first);
+}
+#endif